@@ -0,0 +1,138 @@
+#include "dust/core/log.hpp"
+#include "dust/dust.hpp"
+#include "dust/io/keycodes.hpp"
+
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/ext/matrix_transform.hpp"
+#include "glm/gtc/constants.hpp"
+
+#include <chrono>
+#include <random>
+
+// Times the scene::BVH over a synthetic scene:
+//  - build (binned SAH) and refit after moving a tenth of the boxes
+//  - frustum culling, against the flat SIMD FrustumCuller
+//  - nearest ray hit and sphere overlap queries
+
+constexpr u32 BOX_COUNT   = 1000000;
+constexpr f32 SCENE_SIZE  = 2000.f;
+constexpr u32 QUERY_COUNT = 100000;
+constexpr u32 CULL_COUNT  = 100;
+
+class BVHBenchApp
+: public dust::Application
+{
+private:
+    using Clock = std::chrono::steady_clock;
+
+public:
+    BVHBenchApp()
+    : dust::Application("BVH Bench")
+    {
+        DUST_INFO("Press B to run the benchmark again.");
+        runBenchmark();
+    }
+
+    void update() override
+    {
+        if(getInputManager()->isKey(dust::Key::B, dust::KeyState::Press)) {
+            runBenchmark();
+        }
+    }
+
+private:
+    static double milliseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void runBenchmark()
+    {
+        std::mt19937 random{42};
+        std::uniform_real_distribution<f32> position{-SCENE_SIZE * .5f, SCENE_SIZE * .5f};
+        std::uniform_real_distribution<f32> size{.5f, 5.f};
+        std::uniform_real_distribution<f32> unit{-1.f, 1.f};
+
+        std::vector<dust::render::AABB> boxes(BOX_COUNT);
+        for(auto &box : boxes) {
+            const glm::vec3 center{position(random), position(random) * .1f, position(random)};
+            const glm::vec3 half{size(random), size(random), size(random)};
+            box = {center - half, center + half};
+        }
+
+        dust::scene::BVH bvh{};
+        auto start = Clock::now();
+        bvh.build(boxes);
+        const double buildTime = milliseconds(start);
+
+        // move a tenth of the boxes
+        for(u32 i = 0; i < BOX_COUNT; i += 10) {
+            const glm::vec3 offset{unit(random), unit(random), unit(random)};
+            bvh.setBox(i, {boxes[i].min + offset, boxes[i].max + offset});
+        }
+        start = Clock::now();
+        bvh.refit();
+        const double refitTime = milliseconds(start);
+
+        // frusta looking around from the center of the scene
+        std::vector<dust::render::Frustum> frusta(CULL_COUNT);
+        const glm::mat4 proj = glm::perspective(glm::radians(70.f), 16.f / 9.f, .1f, SCENE_SIZE * .5f);
+        for(u32 i = 0; i < CULL_COUNT; ++i) {
+            const f32 angle = glm::two_pi<f32>() * i / CULL_COUNT;
+            const glm::mat4 view = glm::lookAt(glm::vec3(0.f, 20.f, 0.f),
+                                               glm::vec3(cos(angle), 0.f, sin(angle)) * 100.f,
+                                               glm::vec3(0.f, 1.f, 0.f));
+            frusta[i] = dust::render::Frustum::FromMatrix(proj * view);
+        }
+
+        std::vector<u32> visible{};
+        u64 visibleCount = 0;
+        start = Clock::now();
+        for(const auto &frustum : frusta) {
+            visible.clear();
+            bvh.cull(frustum, visible);
+            visibleCount += visible.size();
+        }
+        const double cullTime = milliseconds(start) / CULL_COUNT;
+
+        dust::render::FrustumCuller culler{};
+        for(u32 i = 0; i < BOX_COUNT; ++i) culler.push(bvh.getBox(i));
+        std::vector<u8> visibility{};
+        u64 flatVisibleCount = 0;
+        start = Clock::now();
+        for(const auto &frustum : frusta) {
+            flatVisibleCount += culler.cull(frustum, visibility);
+        }
+        const double flatTime = milliseconds(start) / CULL_COUNT;
+
+        u32 hits = 0;
+        start = Clock::now();
+        for(u32 i = 0; i < QUERY_COUNT; ++i) {
+            const glm::vec3 origin{position(random), SCENE_SIZE * .1f, position(random)};
+            const glm::vec3 direction{unit(random), -1.f, unit(random)};
+            hits += (bool)bvh.intersect({origin, direction});
+        }
+        const double rayTime = milliseconds(start) * 1000. / QUERY_COUNT;
+
+        std::vector<u32> overlaps{};
+        u64 overlapCount = 0;
+        start = Clock::now();
+        for(u32 i = 0; i < QUERY_COUNT; ++i) {
+            overlaps.clear();
+            bvh.overlap({position(random), 0.f, position(random)}, 10.f, overlaps);
+            overlapCount += overlaps.size();
+        }
+        const double sphereTime = milliseconds(start) * 1000. / QUERY_COUNT;
+
+        DUST_INFO("[BVHBench] {} boxes, {} nodes", BOX_COUNT, bvh.getNodes().size());
+        DUST_INFO("[BVHBench] build  : {:.1f} ms", buildTime);
+        DUST_INFO("[BVHBench] refit  : {:.1f} ms", refitTime);
+        DUST_INFO("[BVHBench] cull   : {:.2f} ms/frustum ({} visible), flat SIMD {:.2f} ms/frustum ({} visible)",
+                  cullTime, visibleCount / CULL_COUNT, flatTime, flatVisibleCount / CULL_COUNT);
+        DUST_INFO("[BVHBench] ray    : {:.2f} us/ray ({} hits / {})", rayTime, hits, QUERY_COUNT);
+        DUST_INFO("[BVHBench] sphere : {:.2f} us/query ({:.1f} boxes/query)", sphereTime,
+                  (double)overlapCount / QUERY_COUNT);
+    }
+};
+
+DUST_SIMPLE_ENTRY(BVHBenchApp)
@@ -4,15 +4,19 @@ out vec4 fragColor;
 /***********************************************/
 // Materials
 
+#define MATERIAL_EXIST 1u
 struct material_t {
-    bool exist;
-    vec4 ambient;
-
-    bool hasDiffuse;
-    vec4 diffuse;
-    vec4 specular;
+    vec4 albedo;
+    vec4 params; // x: metallic, y: roughness, z: ao
+    uint flags;
+    uint textureSlot;
+    uint textures[3]; // packed texture array layers (array << 16 | layer)
+    uint _padding[3];
+};
+layout (std430, binding = 0) readonly buffer MaterialTable {
+    material_t uMaterialTable[];
 };
-uniform material_t uMaterials[1];
+uniform int uMaterialID;
 
 /***********************************************/
 
@@ -24,12 +28,28 @@ in VS_OUT {
 } fs_in;
 
 uniform sampler2D uShadowMap;
-uniform vec3 uLightDir;
-uniform vec3 uLightColor;
-uniform vec4 uAmbient;
-uniform vec3 uViewPos;
 
-float ShadowCalculation(vec4 fragPosLightSpace)
+layout (std140, binding = 1) uniform ViewData {
+    mat4 uView;
+    mat4 uProj;
+    mat4 uViewProj;
+    vec4 uViewPos;
+};
+
+#define MAX_LIGHTS_COUNT 16
+struct light_t {
+    vec4 position;  // w: type (0: directional, 1: point, 2: spot)
+    vec4 direction; // w: range
+    vec4 color;
+    vec4 cone;      // x: cos outer angle, y: 1 / (cos inner - cos outer)
+};
+layout (std140, binding = 2) uniform LightData {
+    vec4 uAmbient;
+    int uLightCount;
+    light_t uLights[MAX_LIGHTS_COUNT];
+};
+
+float ShadowCalculation(vec4 fragPosLightSpace, vec3 lightDir)
 {
     
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
@@ -38,7 +58,6 @@ float ShadowCalculation(vec4 fragPosLightSpace)
     float currentDepth = projCoords.z;
     // compute is in shadow
     vec3 normal = normalize(fs_in.normal);
-    vec3 lightDir = uLightDir;
     float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);  
     float shadow = currentDepth - bias > closestDepth  ? 1.0 : 0.0;
     if(projCoords.z > 1.0)
@@ -47,33 +66,35 @@ float ShadowCalculation(vec4 fragPosLightSpace)
 }
 
 void main() {
-    material_t uMaterial = uMaterials[0];
-    if(!uMaterial.exist) {
+    material_t uMaterial = uMaterialTable[uMaterialID];
+    if((uMaterial.flags & MATERIAL_EXIST) == 0u) {
         fragColor = vec4(1, 0, 1, 1);
         return;
     }
 
-    vec3 ambient = uMaterial.ambient.rgb * uAmbient.rgb * (uLightColor * .3);
+    vec3 lightDir   = uLights[0].direction.xyz;
+    vec3 lightColor = uLights[0].color.rgb;
+
+    vec3 ambient = uMaterial.albedo.rgb * uAmbient.rgb * (lightColor * .3);
     // diffuse 
     vec3 norm = normalize(fs_in.normal);
-    vec3 lightDir = uLightDir;
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = uLightColor.rgb * (diff * uMaterial.diffuse.rgb);
-    // if(uMaterial.hasDiffuse) {
+    vec3 diffuse = lightColor * (diff * uMaterial.albedo.rgb);
+    // if((uMaterial.flags & MATERIAL_TEXTURED) != 0u) {
     //     vec4 col = texture(uMaterial.diffuseTexture, fs_in.texCoord);
     //     if(col.a < 0.5) discard;
     //     diffuse *= col.rgb;
     // }
     
     // specular
-    vec3 viewDir = normalize(uViewPos - fs_in.fragPos);
+    vec3 viewDir = normalize(uViewPos.xyz - fs_in.fragPos);
     vec3 reflectDir = reflect(-lightDir, norm);  
     float spec = 0.0;
     vec3 halfwayDir = normalize(lightDir + viewDir);  
     spec = pow(max(dot(norm, halfwayDir), 0.0), 64.0);
-    vec3 specular = uLightColor * (spec * uMaterial.specular.rgb);  
+    vec3 specular = lightColor * (spec * uMaterial.albedo.rgb);  
 
-    float shadow = ShadowCalculation(fs_in.fragPosLightSpace);
+    float shadow = ShadowCalculation(fs_in.fragPosLightSpace, lightDir);
     vec3 result = (ambient + (1.0 - shadow) * (diffuse + specular));
     fragColor = vec4(result, 1.0);
 }
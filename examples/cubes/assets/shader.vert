@@ -11,8 +11,12 @@ out VS_OUT {
     vec4 fragPosLightSpace;
 } vs_out;
 
-uniform mat4 uView;
-uniform mat4 uProj;
+layout (std140, binding = 1) uniform ViewData {
+    mat4 uView;
+    mat4 uProj;
+    mat4 uViewProj;
+    vec4 uViewPos;
+};
 uniform mat4 uModel;
 uniform mat4 uLightViewProj;
 
@@ -62,6 +62,8 @@ private:
     render::ShaderPtr m_shadowShader;
     render::Framebuffer *m_shadowMap;
     render::DirectionnalLight m_sun;
+    glm::mat4 m_lightViewProj;
+    bool m_shadowsDirty;
 
     render::ModelPtr m_plane;
     std::vector<render::ModelPtr> m_cubes;
@@ -78,10 +80,13 @@ public:
     m_wireframe(false),
     m_camera(createRef<render::Camera3D>(getWindow()->getWidth(), getWindow()->getHeight(), 90, 2000)),
     m_sun(glm::normalize(glm::vec3(-2.0f, 4.0f, -1.0f)), {25/255.f, 108/255.f, 225/255.f}),
+    m_lightViewProj(1.f), m_shadowsDirty(true),
     m_ambientColor(53/255.f, 35/255.f, 100/255.f, 1.f),
     m_cameraY(10.f)
     { 
         m_camera->makeActive();
+        // the shadow map covers the cubes around the camera
+        m_sun.setShadowRange(30.f, 1024);
         m_sun.updateRenderPos();
         getWindow()->setVSync(false);
 
@@ -92,6 +97,7 @@ public:
         const auto shadowShader = render::Shader::LoadFromFile("assets/depth.vert", "assets/depth.frag");
         if(!shadowShader.has_value()) exit(EXIT_FAILURE);
         m_shadowShader = shadowShader.value();
+        m_shadowShader->setPositionOnly(true);
 
         m_skybox = render::SkyboxPtr(new render::Skybox({
             "assets/cubemap/right.png", "assets/cubemap/left.png",
@@ -172,8 +178,17 @@ public:
         m_camera->lookAt(glm::vec3{
             cos(angle) * 10.f, m_cameraY, sin(angle) * 10.f
         }, glm::vec3(0.f));
-        m_camera->bind(m_sceneShader.get());
-        m_sceneShader->setUniform("uLightViewProj", m_sun.getViewProjMat(true));
+        // the sun follows the camera by steps, the shadow map is only drawn again when it moved
+        const glm::mat4 lightViewProj = m_sun.getViewProjMat(m_camera->isDirty());
+        m_shadowsDirty |= lightViewProj != m_lightViewProj;
+        m_lightViewProj = lightViewProj;
+        m_sceneShader->setUniform("uLightViewProj", m_lightViewProj);
+        // or when a caster moved
+        for(const auto& cube : m_cubes)
+        {
+            m_shadowsDirty |= cube->isDirty();
+            cube->setDirty(false);
+        }
     }
 
     void drawCameraFrustumImmediate(render::CameraPtr camera)
@@ -205,7 +220,7 @@ public:
             frustrum.nearBottomRight, frustrum.farBottomRight, frustrum.farTopRight,
             frustrum.farTopRight, frustrum.nearTopRight, frustrum.nearBottomRight,
         };
-        render::Mesh mesh (tris.data(), sizeof(glm::vec3), tris.size(), { render::Attribute::Pos3D });
+        render::Mesh mesh (tris.data(), tris.size(), render::VertexLayout<render::Position3f>::Format());
         tris.clear();
 
         getRenderer()->setCulling(false);
@@ -216,20 +231,24 @@ public:
     void renderScene(ImVec2 size)
     {
         // shadow map
-        m_shadowMap->bind();
+        if(m_shadowsDirty)
         {
+            m_shadowMap->bind();
             getRenderer()->resize(m_shadowMap->getWidth(), m_shadowMap->getHeight());
             getRenderer()->clear(); // only depth
 
-            m_shadowShader->setUniform("uViewProj", m_sun.getViewProjMat());
+            m_shadowShader->setUniform("uViewProj", m_lightViewProj);
 
+            auto queue = getRenderQueue();
             for(const auto& cube : m_cubes)
             {
-                cube->draw(m_shadowShader.get());
+                cube->submit(*queue, m_shadowShader.get());
             }
-            m_plane->draw(m_shadowShader.get());
+            m_plane->submit(*queue, m_shadowShader.get());
+            queue->flush();
+            m_shadowMap->unbind();
+            m_shadowsDirty = false;
         }
-        m_shadowMap->unbind();
         m_shadowMap->bindAttachment(10, render::Framebuffer::AttachmentType::DEPTH);
         
         m_renderTarget->bind();
@@ -237,11 +256,14 @@ public:
             getRenderer()->resize(size.x, size.y);
             getRenderer()->clear();
 
+            auto queue = getRenderQueue();
+            queue->setViewPosition(m_camera->getPosition(), m_camera->getFar());
             for(const auto& cube : m_cubes)
             {
-                cube->draw(m_sceneShader.get());
+                cube->submit(*queue, m_sceneShader.get());
             }
-            m_plane->draw(m_sceneShader.get());
+            m_plane->submit(*queue, m_sceneShader.get());
+            queue->flush();
 
             // draw frustrum
             // render::Camera3DPtr sunCam = createRef<render::Camera3D>(1024,1024,90);
@@ -270,7 +292,7 @@ public:
                     m_renderTarget->resize(size.x, size.y);
                     m_previousSize = size;
                     m_camera->resize(size.x, size.y);
-                    m_camera->bind(m_sceneShader.get()); // update
+                    getRenderer()->setView(m_camera.get()); // update
                 }
                 
                 renderScene(size);
@@ -367,14 +389,12 @@ public:
 
 private:
     void updateUniforms() {
-        // m_sun.bind(m_sceneShader);
-        {
-            m_sceneShader->setUniform("uLightColor", m_sun.getColor());
-            m_sceneShader->setUniform("uLightDir", m_sun.getDirection());
-        }
-        m_camera->bind(m_sceneShader.get());
+        render::LightData lights{};
+        lights.ambient   = m_ambientColor;
+        lights.count     = 1;
+        lights.lights[0] = m_sun.getLightEntry();
+        getRenderer()->setLightData(lights);
         m_sceneShader->setUniform("uShadowMap", 10);
-        m_sceneShader->setUniform("uAmbient", m_ambientColor);
     }
 };
 
@@ -0,0 +1,318 @@
+#include "dust/core/log.hpp"
+#include "dust/dust.hpp"
+#include "dust/io/keycodes.hpp"
+#include "dust/render/camera.hpp"
+#include "dust/render/geometryArena.hpp"
+#include "dust/render/indirectBatch.hpp"
+#include "dust/render/instancedMesh.hpp"
+#include "dust/render/material.hpp"
+#include "dust/render/mesh.hpp"
+#include "dust/render/model.hpp"
+#include "dust/render/shader.hpp"
+#include "glm/ext/matrix_transform.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "imgui.h"
+
+// Renders 100k cubes with instanced draws (a few InstancedMesh), with one
+// glMultiDrawElementsIndirect over a GeometryArena (one command per cube)
+// or with the per model path (one Model submitted per cube), to compare CPU frame time.
+
+std::string instancedVertex = SHADER_SOURCE(
+    "#version 460 core",
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec3 aNormal;
+    layout (location = 8) in mat4 aInstanceTransform;
+    layout (location = 12) in vec4 aInstanceColor;
+    layout (std140, binding = 1) uniform ViewData {
+        mat4 uView;
+        mat4 uProj;
+        mat4 uViewProj;
+        vec4 uViewPos;
+    };
+    out vec3 oNormal;
+    out vec4 oColor;
+    void main() {
+        gl_Position = uViewProj * aInstanceTransform * vec4(aPos, 1.);
+        oNormal = mat3(aInstanceTransform) * aNormal;
+        oColor  = aInstanceColor;
+    }
+);
+
+std::string modelVertex = SHADER_SOURCE(
+    "#version 460 core",
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec3 aNormal;
+    layout (std140, binding = 1) uniform ViewData {
+        mat4 uView;
+        mat4 uProj;
+        mat4 uViewProj;
+        vec4 uViewPos;
+    };
+    struct material_t {
+        vec4 albedo;
+        vec4 params;
+        uint flags;
+        uint textureSlot;
+        uint textures[3];
+        uint _padding[3];
+    };
+    layout (std430, binding = 0) readonly buffer MaterialTable {
+        material_t uMaterialTable[];
+    };
+    uniform mat4 uModel;
+    uniform int uMaterialID;
+    out vec3 oNormal;
+    out vec4 oColor;
+    void main() {
+        gl_Position = uViewProj * uModel * vec4(aPos, 1.);
+        oNormal = mat3(uModel) * aNormal;
+        oColor  = uMaterialTable[uMaterialID].albedo;
+    }
+);
+
+std::string indirectVertex = SHADER_SOURCE(
+    "#version 460 core",
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec3 aNormal;
+    layout (std140, binding = 1) uniform ViewData {
+        mat4 uView;
+        mat4 uProj;
+        mat4 uViewProj;
+        vec4 uViewPos;
+    };
+    struct material_t {
+        vec4 albedo;
+        vec4 params;
+        uint flags;
+        uint textureSlot;
+        uint textures[3];
+        uint _padding[3];
+    };
+    layout (std430, binding = 0) readonly buffer MaterialTable {
+        material_t uMaterialTable[];
+    };
+    struct draw_t {
+        mat4 transform;
+        uint materialID;
+    };
+    layout (std430, binding = 1) readonly buffer DrawData {
+        draw_t uDraws[];
+    };
+    out vec3 oNormal;
+    out vec4 oColor;
+    void main() {
+        draw_t draw = uDraws[gl_DrawID];
+        gl_Position = uViewProj * draw.transform * vec4(aPos, 1.);
+        oNormal = mat3(draw.transform) * aNormal;
+        oColor  = uMaterialTable[draw.materialID].albedo;
+    }
+);
+
+std::string cubeFragment = SHADER_SOURCE(
+    "#version 460 core",
+    in vec3 oNormal;
+    in vec4 oColor;
+    out vec4 fragColor;
+    void main() {
+        const vec3 lightDir = normalize(vec3(-.4, 1., -.2));
+        float diffuse = max(dot(normalize(oNormal), lightDir), 0.) * .8 + .2;
+        fragColor = vec4(oColor.rgb * diffuse, 1.);
+    }
+);
+
+constexpr u32 CUBE_COUNT    = 100000;
+constexpr u32 CUBES_PER_ROW = 400;
+/// instances per draw call
+constexpr u32 INSTANCE_BATCH = 25000;
+/// materials of the indirect path
+constexpr u32 INDIRECT_MATERIALS = 8;
+
+enum class RenderPath : u32 {
+    Instanced = 0,
+    Indirect,
+    PerModel,
+    Count
+};
+
+static const char *RenderPathName(RenderPath path) {
+    switch (path) {
+    case RenderPath::Instanced: return "instanced";
+    case RenderPath::Indirect:  return "multi draw indirect";
+    case RenderPath::PerModel:  return "per model";
+    default:                    return "unknown";
+    }
+}
+
+using CubeVertexLayout = dust::render::VertexLayout<dust::render::Position3f, dust::render::Normal3f>;
+
+/// Indexed cube (position, normal) in a GeometryArena
+static dust::render::GeometryRange AllocateCube(dust::render::GeometryArena &arena, glm::vec3 size) {
+    const glm::vec3 half = size * .5f;
+    std::vector<f32> vertices;
+    std::vector<u32> indices;
+    for(u32 axis = 0; axis < 3; ++axis) {
+        for(f32 sign : {-1.f, 1.f}) {
+            glm::vec3 normal(0.f);
+            normal[axis] = sign;
+            const glm::vec3 u = glm::vec3(normal.y, normal.z, normal.x);
+            const glm::vec3 v = glm::cross(normal, u);
+            const u32 first = vertices.size() * sizeof(f32) / CubeVertexLayout::Stride;
+            for(const glm::vec2 corner : {glm::vec2{-1.f, -1.f}, glm::vec2{1.f, -1.f}, glm::vec2{1.f, 1.f}, glm::vec2{-1.f, 1.f}}) {
+                const glm::vec3 position = (normal + u * corner.x + v * corner.y) * half;
+                vertices.insert(vertices.end(), {position.x, position.y, position.z, normal.x, normal.y, normal.z});
+            }
+            indices.insert(indices.end(), {first, first + 1, first + 2, first, first + 2, first + 3});
+        }
+    }
+    return arena.allocate(vertices.data(), vertices.size() * sizeof(f32) / CubeVertexLayout::Stride, indices);
+}
+
+class InstancingApp
+: public dust::Application
+{
+private:
+    dust::render::ShaderPtr m_instancedShader;
+    dust::render::ShaderPtr m_modelShader;
+    dust::render::ShaderPtr m_indirectShader;
+    dust::render::Camera3DPtr m_camera;
+
+    dust::render::MeshPtr m_cube;
+    std::vector<dust::render::InstancedMeshPtr> m_batches;
+    std::vector<dust::render::ModelPtr> m_models;
+
+    dust::render::GeometryArenaUPtr m_arena;
+    dust::render::IndirectBatchUPtr m_indirect;
+    dust::render::GeometryRange m_cubeRange;
+    std::vector<dust::render::MaterialPtr> m_indirectMaterials;
+    std::vector<glm::mat4> m_transforms;
+
+    RenderPath m_path;
+    f64 m_cpuTime;
+    u32 m_drawCalls;
+
+public:
+    InstancingApp()
+    : dust::Application("Instancing", 1920u, 1080u),
+    m_instancedShader(dust::createRef<dust::render::Shader>(instancedVertex, cubeFragment)),
+    m_modelShader(dust::createRef<dust::render::Shader>(modelVertex, cubeFragment)),
+    m_indirectShader(dust::createRef<dust::render::Shader>(indirectVertex, cubeFragment)),
+    m_camera(dust::createRef<dust::render::Camera3D>(getWindow()->getWidth(), getWindow()->getHeight(), 70, 2000)),
+    m_arena(dust::createScope<dust::render::GeometryArena>(CubeVertexLayout::Format())),
+    m_indirect(dust::createScope<dust::render::IndirectBatch>(CUBE_COUNT)),
+    m_path(RenderPath::Instanced),
+    m_cpuTime(0.),
+    m_drawCalls(0)
+    {
+        m_camera->makeActive();
+        getWindow()->setVSync(false);
+        getRenderer()->setClearColor(.1f, .1f, .12f);
+
+        // shared cube and material, the instanced path uses the instance colors instead
+        m_cube = dust::render::Mesh::createCube(glm::vec3(.8f));
+        auto material = dust::createRef<dust::render::ColorMaterial>(glm::vec3{1.f, .6f, .2f});
+        m_cube->setMaterial(0, material);
+        dust::render::ColorMaterial::SetupMaterialShader(m_modelShader.get());
+
+        std::mt19937 random{42};
+        std::uniform_real_distribution<f32> color{.2f, 1.f};
+
+        // indirect path: a single cube range and a few materials, one command per cube
+        m_cubeRange = AllocateCube(*m_arena, glm::vec3(.8f));
+        for(u32 i = 0; i < INDIRECT_MATERIALS; ++i) {
+            auto indirectMaterial = dust::createRef<dust::render::ColorMaterial>(
+                glm::vec3{color(random), color(random), color(random)});
+            indirectMaterial->upload();
+            m_indirectMaterials.push_back(indirectMaterial);
+        }
+        m_transforms.reserve(CUBE_COUNT);
+        for(u32 i = 0; i < CUBE_COUNT; ++i) {
+            if(i % INSTANCE_BATCH == 0) {
+                m_batches.push_back(dust::createRef<dust::render::InstancedMesh>(m_cube, INSTANCE_BATCH));
+            }
+            const glm::vec3 position{
+                (f32)(i % CUBES_PER_ROW) - CUBES_PER_ROW * .5f,
+                0.f,
+                (f32)(i / CUBES_PER_ROW) - (CUBE_COUNT / CUBES_PER_ROW) * .5f
+            };
+            m_batches.back()->getInstances().add(dust::render::InstanceData{
+                .transform  = glm::translate(glm::mat4(1.f), position),
+                .color      = glm::vec4(color(random), color(random), color(random), 1.f),
+                .materialID = material->getID()
+            });
+
+            m_transforms.push_back(glm::translate(glm::mat4(1.f), position));
+
+            auto model = dust::createRef<dust::render::Model>(m_cube);
+            model->setPosition(position);
+            m_models.push_back(model);
+        }
+        DUST_INFO("Press I to switch between the instanced, indirect and per model paths.");
+    }
+
+    ~InstancingApp() {
+        m_models.clear();
+        m_batches.clear();
+        m_indirect.reset();
+        m_arena.reset();
+        m_indirectMaterials.clear();
+        m_cube.reset();
+        m_instancedShader.reset();
+        m_modelShader.reset();
+        m_indirectShader.reset();
+        m_camera.reset();
+    }
+
+    void update() override
+    {
+        if(getInputManager()->isKey(dust::Key::I, dust::KeyState::Press)) {
+            m_path = (RenderPath)(((u32)m_path + 1) % (u32)RenderPath::Count);
+        }
+        const f32 angle = getTime().time * .1f;
+        m_camera->lookAt(glm::vec3{std::cos(angle) * 150.f, 80.f, std::sin(angle) * 150.f}, glm::vec3(0.f));
+    }
+
+    void render() override
+    {
+        const auto start = std::chrono::steady_clock::now();
+        if(m_path == RenderPath::Instanced) {
+            for(auto &batch : m_batches) {
+                batch->draw(m_instancedShader.get());
+            }
+            m_drawCalls = m_batches.size();
+        } else if(m_path == RenderPath::Indirect) {
+            for(u32 i = 0; i < CUBE_COUNT; ++i) {
+                m_indirect->push(m_cubeRange, m_transforms[i], m_indirectMaterials[i % INDIRECT_MATERIALS]->getID());
+            }
+            m_indirect->submit(*m_arena, m_indirectShader.get());
+            m_drawCalls = 1;
+        } else {
+            auto queue = getRenderQueue();
+            for(auto &model : m_models) {
+                model->submit(*queue, m_modelShader.get());
+            }
+            queue->flush();
+            m_drawCalls = queue->getStats().drawCalls;
+        }
+        const std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        // smoothed
+        m_cpuTime = m_cpuTime * .95 + elapsed.count() * .05;
+
+        if(ImGui::Begin("Instancing")) {
+            ImGui::Text("%u cubes", CUBE_COUNT);
+            ImGui::Text("Path: %s (press I)", RenderPathName(m_path));
+            ImGui::Text("Draw calls: %u", m_drawCalls);
+            ImGui::Text("CPU render time: %.3f ms", m_cpuTime);
+            if(auto *stream = getRenderer()->getStreamBuffer()) {
+                ImGui::Text("Stream buffer: %u KiB, %u waits", stream->getUsed() / 1024, stream->getWaitCount());
+            }
+            ImGui::Text("FPS: %u", (u32)(1. / getTime().delta));
+        }
+        ImGui::End();
+    }
+};
+
+DUST_SIMPLE_ENTRY(InstancingApp)
@@ -0,0 +1,16 @@
+#version 460 core
+
+// position stream of the meshes (see dust::render::Mesh::setPositionStream)
+layout (location = 0) in vec4 aPos;  // xyz: position, dequantized by uModel
+
+layout (std140, binding = 1) uniform ViewData {
+    mat4 uView;
+    mat4 uProj;
+    mat4 uViewProj;
+    vec4 uViewPos;
+};
+uniform mat4 uModel;
+
+void main() {
+    gl_Position = uProj * uView * uModel * vec4(aPos.xyz, 1);
+}
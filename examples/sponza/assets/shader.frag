@@ -31,24 +31,32 @@ uniform material_t uMaterials[MAT_COUNT];
 /***********************************************/
 // Lights
 
+#define MAX_LIGHTS_COUNT 16
 struct light_t {
-    int type;
-
-    vec3 position;
-    vec3 direction;
-    vec3 color;
-    float falloff;
+    vec4 position;  // w: type (0: directional, 1: point, 2: spot)
+    vec4 direction; // w: range
+    vec4 color;
+    vec4 cone;      // x: cos outer angle, y: 1 / (cos inner - cos outer)
+};
+layout (std140, binding = 2) uniform LightData {
+    vec4 uAmbient;
+    int uLightCount;
+    light_t uLights[MAX_LIGHTS_COUNT];
 };
-uniform int uLightCount;
-uniform light_t uLights[10];
 
 /***********************************************/
 // Globals
 
 uniform sampler2D uEnvironnmentMap;
-uniform vec3 uViewPos;
 uniform float uExposure;
 
+layout (std140, binding = 1) uniform ViewData {
+    mat4 uView;
+    mat4 uProj;
+    mat4 uViewProj;
+    vec4 uViewPos;
+};
+
 /***********************************************/
 // Input
 
@@ -220,9 +228,9 @@ void main() {
 
     // inputs
     vec3 normal = calcBumpMapping();                      // Normal
-    vec3 viewDir = normalize(uViewPos - fs_in.fragPos);   // View vector
+    vec3 viewDir = normalize(uViewPos.xyz - fs_in.fragPos); // View vector
     // Lights
-    vec3 lightDir = normalize(uLights[0].direction);      // Light vector
+    vec3 lightDir = normalize(uLights[0].direction.xyz);  // Light vector
     vec3 halfView = normalize(viewDir + lightDir);        // Half View vector
 
     vec3 result = PBR(viewDir, normal, lightDir, halfView);
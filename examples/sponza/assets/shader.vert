@@ -1,11 +1,12 @@
 #version 460 core
 
-layout (location = 0) in vec3 aPos;
+// packed vertices (see dust::render::PackedModelVertex)
+layout (location = 0) in vec4 aPos;      // xyz: position, dequantized by uModel, w: tangent handedness
 layout (location = 1) in vec2 aTexCoord;
-layout (location = 2) in vec3 aNormal;
-layout (location = 3) in vec3 aTangent;
-layout (location = 4) in vec4 aColor;
-layout (location = 5) in float aMatID;
+layout (location = 2) in vec2 aNormal;   // octahedral
+layout (location = 3) in vec2 aTangent;  // octahedral
+layout (location = 4) in float aMatID;
+layout (location = 5) in vec4 aColor;
 
 out VS_OUT {
     vec3 normal;
@@ -18,24 +19,35 @@ out VS_OUT {
     mat3 TBN;
 } vs_out;
 
-uniform mat4 uView;
-uniform mat4 uProj;
+layout (std140, binding = 1) uniform ViewData {
+    mat4 uView;
+    mat4 uProj;
+    mat4 uViewProj;
+    vec4 uViewPos;
+};
 uniform mat4 uModel;
 uniform mat4 uLightViewProj;
 
+vec3 decodeOctahedral(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float fold = max(-v.z, 0.0);
+    v.xy += vec2(v.x >= 0.0 ? -fold : fold, v.y >= 0.0 ? -fold : fold);
+    return normalize(v);
+}
+
 void main() {
-    vs_out.fragPos = (uModel * vec4(aPos, 1)).xyz;
+    vs_out.fragPos = (uModel * vec4(aPos.xyz, 1)).xyz;
     gl_Position = uProj * uView * vec4(vs_out.fragPos, 1.f);
     
-    vs_out.normal   = normalize(mat3(uModel) * aNormal);
-    vs_out.tangent  = normalize(mat3(uModel) * aTangent);
+    vs_out.normal   = normalize(mat3(uModel) * decodeOctahedral(aNormal));
+    vs_out.tangent  = normalize(mat3(uModel) * decodeOctahedral(aTangent));
     vs_out.color    = aColor;
     vs_out.texCoord = aTexCoord;
     vs_out.matID    = aMatID;
     vs_out.lightFragPos = (uLightViewProj * vec4(vs_out.fragPos, 1)).xyz;
 
     // Normal mapping matrix (TBN)
-    vec3 biTangent = cross(vs_out.normal, vs_out.tangent);
+    vec3 biTangent = cross(vs_out.normal, vs_out.tangent) * (aPos.w * 2.0 - 1.0);
     // TBN [Tangent Bitangent Normal] matrix
     vs_out.TBN = mat3(vs_out.tangent, biTangent, vs_out.normal);
 }
\ No newline at end of file
@@ -10,13 +10,17 @@
 
 #include "general_inspector.hpp"
 
+#include <chrono>
 #include <cstdlib>
 #include <format>
+#include <random>
 
 using namespace dust;
 
 constexpr f32 CAMERA_SPEED        = 100.f;
 constexpr f32 CAMERA_ROTATE_SPEED = 50.f;
+/// local lights spread in sponza, a quarter of them are spot lights
+constexpr u32 LOCAL_LIGHTS        = 1024;
 
 ////////////////////////////////////////////////
 
@@ -31,12 +35,25 @@ private:
     render::SkyboxPtr m_skybox;
 
     render::DirectionnalLight m_sun;
+    render::CascadeShadowMapUPtr m_shadows;
+    std::vector<Scope<render::PointLight>> m_localLights;
+    render::LightClustersUPtr m_lightClusters;
 
     render::RenderPassPtr m_simplePass;
     render::PostProcessPassPtr m_postprocessPass;
+    render::OcclusionCullerUPtr m_occlusionCuller;
+
+    ModelTool *m_modelTool;
 
     bool m_wireframe;
     bool m_drawSponza;
+    bool m_frustumCulling;
+    bool m_occlusionCulling;
+    bool m_meshletCulling;
+    bool m_lodSelection;
+    bool m_shadowsEnabled;
+    i32 m_localLightCount;
+    float m_lodError;
     float m_exposure;
 
     friend class GeneralInspector;
@@ -47,8 +64,12 @@ public:
           m_camera(createRef<render::Camera3D>(getWindow()->getWidth(), getWindow()->getHeight(),
                                                90, 2000)),
           m_sun(glm::normalize(glm::vec3(-2.0f, 4.0f, -1.0f)), {1.f, 1.f, 1.f}),
-          m_drawSponza(true), m_wireframe(false), m_simplePass(nullptr),
-          m_postprocessPass(nullptr), m_exposure(1.)
+          m_drawSponza(true), m_frustumCulling(true), m_occlusionCulling(true), m_meshletCulling(true),
+          m_lodSelection(true), m_shadowsEnabled(true), m_localLightCount(256), m_lodError(1.f), m_wireframe(false),
+          m_simplePass(nullptr), m_postprocessPass(nullptr),
+          m_occlusionCuller(createScope<render::OcclusionCuller>()), m_shadows(createScope<render::CascadeShadowMap>()),
+          m_localLights(), m_lightClusters(createScope<render::LightClusters>()),
+          m_modelTool(nullptr), m_exposure(1.)
     {
         getWindow()->setVSync(false);
 
@@ -60,16 +81,28 @@ public:
         m_shader = shader.value();
 
         const auto depthShader =
-            render::Shader::LoadFromFile("assets/shader.vert", "assets/depth.frag");
+            render::Shader::LoadFromFile("assets/depth.vert", "assets/depth.frag");
         if (!depthShader.has_value()) {
             DUST_ERROR("Exiting ... Depth Shader missing");
             exit(EXIT_FAILURE);
         }
         m_depthShader   = depthShader.value();
+        m_depthShader->setPositionOnly(true);
         m_currentShader = m_shader;
 
         m_sponza = io::LoadModel("assets/sponza_gltf/sponza.gltf");
         render::PBRMaterial::SetupMaterialShader(m_shader.get());
+        if (m_sponza.has_value()) {
+            // reach the casters outside of the view
+            render::AABB casters{};
+            for (const auto &mesh : m_sponza.value()->getMeshes()) {
+                if (mesh) casters.extend(mesh->getBounds().transformed(m_sponza.value()->getModelMatrix()));
+            }
+            m_shadows->setCasterBounds(casters);
+            // the distant cascades are refreshed every third frame
+            m_shadows->setUpdateInterval(3);
+            spawnLocalLights(casters);
+        }
 
         m_camera->setPosition(glm::vec3(0.f, 20.f, 0.f));
 
@@ -98,9 +131,9 @@ public:
 
         auto resultBuffer = m_simplePass->getFramebuffer();
         getEditor()->add_tool(new EditorSceneView(resultBuffer));
-        auto modelTool = new ModelTool();
-        modelTool->set_inspected_model(m_sponza.value().get());
-        getEditor()->add_tool(modelTool);
+        m_modelTool = new ModelTool();
+        m_modelTool->set_inspected_model(m_sponza.value().get());
+        getEditor()->add_tool(m_modelTool);
         getEditor()->add_tool(new GeneralInspector());
 
         DUST_INFO("== Example Sponza loaded! ==");
@@ -112,6 +145,8 @@ public:
 
         m_simplePass.reset();
         m_postprocessPass.reset();
+        m_shadows.reset();
+        m_lightClusters.reset();
         m_skybox.reset();
 
         m_sponza.reset();
@@ -124,28 +159,22 @@ public:
         f32 delta = (f32)getTime().delta;
         if (InputManager::IsKeyDown(Key::A)) {
             m_camera->rotate({-CAMERA_ROTATE_SPEED * delta, .0f, .0f});
-            m_camera->bind(m_currentShader.get());
         }
         if (InputManager::IsKeyDown(Key::D)) {
             m_camera->rotate({CAMERA_ROTATE_SPEED * delta, .0f, .0f});
-            m_camera->bind(m_currentShader.get());
         }
 
         if (InputManager::IsKeyDown(Key::W)) {
             m_camera->move(m_camera->forward() * -CAMERA_SPEED * delta);
-            m_camera->bind(m_currentShader.get());
         }
         if (InputManager::IsKeyDown(Key::S)) {
             m_camera->move(m_camera->forward() * CAMERA_SPEED * delta);
-            m_camera->bind(m_currentShader.get());
         }
         if (InputManager::IsKeyDown(Key::Space)) {
             m_camera->move(glm::vec3(0, CAMERA_SPEED * delta, 0));
-            m_camera->bind(m_currentShader.get());
         }
         if (InputManager::IsKeyDown(Key::LeftShift)) {
             m_camera->move(glm::vec3(0, -CAMERA_SPEED * delta, 0));
-            m_camera->bind(m_currentShader.get());
         }
     }
 
@@ -165,18 +194,47 @@ public:
                     getRenderer()->resize(size.x, size.y);
                     m_simplePass->getFramebuffer()->resize(size.x, size.y);
                     m_camera->resize(size.x, size.y);
-                    m_camera->bind(m_currentShader.get()); // update
+                    getRenderer()->setView(m_camera.get()); // update
+                }
+                // pick the mesh under the cursor
+                if (const auto click = editor_scene_view->get_clicked_position()) {
+                    const glm::vec3 nearPoint = m_camera->unproject({click->x, click->y, -1.f});
+                    const glm::vec3 farPoint  = m_camera->unproject({click->x, click->y, 1.f});
+                    const i32 mesh = m_modelTool->pick({nearPoint, farPoint - nearPoint, 1.f});
+                    if (mesh >= 0) {
+                        DUST_INFO("Picked mesh {} ({})", mesh, m_sponza.value()->getMeshes().at(mesh)->getName());
+                    }
                 }
             }
 
+            renderShadows();
+            updateLocalLights();
+
             m_simplePass->preRender();
             {
                 DUST_PROFILE_GPU("Sponza render");
+                getRenderer()->resize(m_simplePass->getFramebuffer()->getWidth(),
+                                      m_simplePass->getFramebuffer()->getHeight());
                 getRenderer()->clear();
                 // sponza
+                auto queue = getRenderQueue();
+                queue->setViewPosition(m_camera->getPosition(), m_camera->getFar());
+                queue->setMeshletCulling(m_meshletCulling);
+                queue->setLODSelection(m_lodSelection ? render::LODSelector::ProjectionScale(
+                                                            m_camera->getProj(), getWindow()->getHeight())
+                                                      : 0.f,
+                                       m_lodError);
+                if (m_frustumCulling) {
+                    queue->setFrustum(m_camera->getFrustum());
+                }
+                if (m_occlusionCulling) {
+                    m_occlusionCuller->begin(m_camera->getViewProj());
+                    queue->setOcclusionCuller(m_occlusionCuller.get());
+                }
                 if (m_drawSponza && m_sponza.has_value()) {
-                    m_sponza.value()->draw(m_currentShader.get());
+                    m_sponza.value()->submit(*queue, m_currentShader.get());
                 }
+                queue->flush();
 
                 // skybox
                 m_skybox->draw(m_camera.get());
@@ -186,11 +244,138 @@ public:
     }
 
 private:
+    /**
+     * @brief Render the sun cascades with the depth shader, only the casters of each cascade are drawn
+     */
+    void renderShadows() {
+        DUST_PROFILE_GPU("Sponza shadows");
+        auto renderer = getRenderer();
+        if (!m_shadowsEnabled || !m_drawSponza || !m_sponza.has_value()) {
+            renderer->setShadowData(render::ShadowData{});
+            return;
+        }
+        m_shadows->update(*m_camera, m_sun);
+        renderer->setShadowData(m_shadows->getShadowData());
+
+        // sponza is static: its depth is cached and drawn again only when a cascade moves
+        auto queue = getRenderQueue();
+        for (u32 c = 0; c < m_shadows->getCascadeCount(); ++c) {
+            if (!m_shadows->needsStaticUpdate(c)) continue;
+            m_shadows->bindStatic(c, queue);
+            renderer->setViewData(m_shadows->getViewData(c));
+            m_sponza.value()->submit(*queue, m_depthShader.get());
+            queue->flush();
+        }
+        m_shadows->unbind();
+        m_shadows->bindTexture(render::SHADOW_MAP_UNIT);
+        renderer->setView(m_camera.get(), true);
+    }
+
+    /**
+     * @brief Colored point and spot lights scattered in the lower half of the scene
+     */
+    void spawnLocalLights(const render::AABB &bounds) {
+        const glm::vec3 size = bounds.max - bounds.min;
+        const f32 range      = std::max({size.x, size.y, size.z}) * .06f;
+        std::mt19937 random{7};
+        std::uniform_real_distribution<f32> unit{0.f, 1.f};
+        for (u32 i = 0; i < LOCAL_LIGHTS; ++i) {
+            const glm::vec3 position = bounds.min + size * glm::vec3(unit(random), unit(random) * .5f, unit(random));
+            // random hue, bright enough at half the range
+            glm::vec3 hue(unit(random), unit(random), unit(random));
+            hue /= std::max({hue.x, hue.y, hue.z, .01f});
+            const glm::vec3 color = hue * range * range * .25f;
+            if (i % 4 == 3) {
+                m_localLights.push_back(createScope<render::SpotLight>(position, glm::vec3(0.f, -1.f, 0.f), color,
+                                                                       range * 2.f, glm::radians(20.f),
+                                                                       glm::radians(35.f)));
+            } else {
+                m_localLights.push_back(createScope<render::PointLight>(position, color, range));
+            }
+        }
+    }
+
+    /**
+     * @brief Assign the local lights to the clusters of the camera view
+     */
+    void updateLocalLights() {
+        m_lightClusters->clear();
+        const u32 count = std::min<u32>(std::max(m_localLightCount, 0), m_localLights.size());
+        for (u32 i = 0; i < count; ++i) m_lightClusters->push(*m_localLights[i]);
+        m_lightClusters->build(*m_camera);
+        m_lightClusters->upload();
+        getRenderer()->setClusterData(m_lightClusters->getClusterData());
+    }
+
+    /**
+     * @brief Time the BVH build and queries against the flat frustum culler over the sponza meshes
+     */
+    void benchmarkBVH() {
+        if (!m_sponza.has_value()) return;
+        using Clock = std::chrono::steady_clock;
+        const auto microseconds = [](Clock::duration d, u32 count) {
+            return std::chrono::duration<double, std::micro>(d).count() / count;
+        };
+        constexpr u32 ITERATIONS = 1000;
+
+        const auto &model = m_sponza.value();
+        std::vector<render::AABB> boxes{};
+        for (const auto &mesh : model->getMeshes()) {
+            if (mesh && mesh->getBounds().isValid()) {
+                boxes.push_back(mesh->getBounds().transformed(model->getModelMatrix()));
+            }
+        }
+
+        scene::BVH bvh{};
+        auto start = Clock::now();
+        for (u32 i = 0; i < ITERATIONS; ++i) bvh.build(boxes);
+        const double buildTime = microseconds(Clock::now() - start, ITERATIONS);
+
+        start = Clock::now();
+        for (u32 i = 0; i < ITERATIONS; ++i) bvh.refit();
+        const double refitTime = microseconds(Clock::now() - start, ITERATIONS);
+
+        const auto &frustum = m_camera->getFrustum();
+        std::vector<u32> visible{};
+        start = Clock::now();
+        for (u32 i = 0; i < ITERATIONS; ++i) {
+            visible.clear();
+            bvh.cull(frustum, visible);
+        }
+        const double cullTime = microseconds(Clock::now() - start, ITERATIONS);
+
+        render::FrustumCuller culler{};
+        for (const auto &box : boxes) culler.push(box);
+        std::vector<u8> visibility{};
+        start = Clock::now();
+        for (u32 i = 0; i < ITERATIONS; ++i) culler.cull(frustum, visibility);
+        const double flatTime = microseconds(Clock::now() - start, ITERATIONS);
+
+        std::mt19937 random{42};
+        std::uniform_real_distribution<f32> ndc{-1.f, 1.f};
+        u32 hits = 0;
+        start = Clock::now();
+        for (u32 i = 0; i < ITERATIONS; ++i) {
+            const glm::vec2 point{ndc(random), ndc(random)};
+            const glm::vec3 origin = m_camera->unproject({point, -1.f});
+            hits += (bool)bvh.intersect({origin, m_camera->unproject({point, 1.f}) - origin, 1.f});
+        }
+        const double rayTime = microseconds(Clock::now() - start, ITERATIONS);
+
+        DUST_INFO("[BVH] Sponza: {} meshes, {} nodes", boxes.size(), bvh.getNodes().size());
+        DUST_INFO("[BVH] build {:.2f} us, refit {:.2f} us", buildTime, refitTime);
+        DUST_INFO("[BVH] frustum cull {:.2f} us ({} visible), flat SIMD cull {:.2f} us", cullTime, visible.size(), flatTime);
+        DUST_INFO("[BVH] ray {:.3f} us ({} hits / {})", rayTime, hits, ITERATIONS);
+    }
+
     void updateUniforms() {
-        m_camera->bind(m_currentShader.get());
-        m_sun.bind(m_currentShader);
-        m_currentShader->setUniform("uLightCount", 1);
+        render::LightData lights{};
+        lights.ambient   = glm::vec4(.03f, .03f, .03f, 1.f);
+        lights.count     = 1;
+        lights.lights[0] = m_sun.getLightEntry();
+        getRenderer()->setLightData(lights);
         m_currentShader->setUniform("uExposure", m_exposure);
+        m_shader->setUniform("uShadowMap", (int)render::SHADOW_MAP_UNIT);
     }
 };
 
@@ -208,6 +393,26 @@ void GeneralInspector::render_ui() {
     {
         ImGui::Text("FPS: %d", (u32)(1. / a->getTime().delta));
 
+        ImGui::SeparatorText("Render Queue");
+        {
+            const auto &stats = a->getRenderQueue()->getStats();
+            ImGui::Text("Packets: %u", stats.packets);
+            ImGui::Text("Visible: %u, culled: %u", stats.visible, stats.culled);
+            const u32 tested = stats.visible + stats.occluded;
+            ImGui::Text("Occluded: %u (%.1f%%), %u occluder triangles", stats.occluded,
+                        tested > 0 ? 100.f * stats.occluded / tested : 0.f,
+                        a->m_occlusionCuller->getStats().occluderTriangles);
+            ImGui::Text("Meshlets: %u, culled: %u", stats.meshlets, stats.culledMeshlets);
+            ImGui::Text("Triangles: %u", stats.triangles);
+            ImGui::Text("Draw calls: %u", stats.drawCalls);
+            ImGui::Text("Shader switches: %u", stats.shaderSwitches);
+            ImGui::Text("Material switches: %u", stats.materialSwitches);
+            ImGui::Text("VAO switches: %u", stats.vaoSwitches);
+
+            const auto &glCalls = render::GLStateCache::GetLastFrameCounters();
+            ImGui::Text("GL calls: %u issued, %u skipped", glCalls.issued, glCalls.skipped);
+        }
+
         ImGui::SeparatorText("Camera");
         {
             ImGui::InputMat4("Projection", a->m_camera->getProj());
@@ -231,6 +436,11 @@ void GeneralInspector::render_ui() {
                 a->m_sun.setColor(sunColor);
                 a->updateUniforms();
             }
+
+            ImGui::SliderInt("Local lights", &a->m_localLightCount, 0, (i32)a->m_localLights.size());
+            const auto &stats = a->m_lightClusters->getStats();
+            ImGui::Text("Clustered: %u visible, %u indices, max %u per cluster", stats.visible, stats.indices,
+                        stats.maxPerCluster);
         }
 
         ImGui::SeparatorText("Shaders");
@@ -239,6 +449,20 @@ void GeneralInspector::render_ui() {
                 a->getRenderer()->setDrawWireframe(a->m_wireframe);
             }
             ImGui::Checkbox("Draw Sponza", &a->m_drawSponza);
+            ImGui::Checkbox("Frustum culling", &a->m_frustumCulling);
+            ImGui::Checkbox("Occlusion culling", &a->m_occlusionCulling);
+            ImGui::Checkbox("Meshlet culling", &a->m_meshletCulling);
+            ImGui::Checkbox("LOD selection", &a->m_lodSelection);
+            ImGui::Checkbox("Shadows", &a->m_shadowsEnabled);
+            if (a->m_shadowsEnabled) {
+                const auto &stats = a->m_shadows->getStats();
+                ImGui::Text("Shadow cascades: %u updated, %u drawn, %u copied", stats.updated, stats.staticRenders,
+                            stats.copies);
+            }
+            ImGui::SliderFloat("LOD error (px)", &a->m_lodError, .1f, 10.f, "%.1f");
+            if (ImGui::Button("Benchmark BVH")) {
+                a->benchmarkBVH();
+            }
 
             if (ImGui::Button("Show Depth")) {
                 a->m_currentShader = a->m_depthShader;
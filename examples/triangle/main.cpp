@@ -1,8 +1,10 @@
 #include "dust/core/log.hpp"
 #include "dust/dust.hpp"
 #include "dust/io/keycodes.hpp"
+#include "dust/render/dynamicMesh.hpp"
 #include "dust/render/mesh.hpp"
 #include "dust/render/shader.hpp"
+#include "glm/gtc/constants.hpp"
 
 std::string vCode = SHADER_SOURCE(
     "#version 460 core",
@@ -31,12 +33,20 @@ std::vector<float> triangleVertices{
      0.0f,  0.5f, 0.f,   0.f, 0.f, 1.f, 1.f,
 };
 
+using ColorVertexLayout = dust::render::VertexLayout<dust::render::Position3f, dust::render::Color4f>;
+static_assert(ColorVertexLayout::Stride == 7 * sizeof(float));
+
+/// sides of the animated polygon, rewritten every frame
+constexpr u32 POLYGON_SIDES = 64;
+
 class TriangleApp
 : public dust::Application
 {
 private:
     dust::render::ShaderPtr m_shader;
     dust::render::MeshPtr m_triangle;
+    dust::render::DynamicMeshPtr m_polygon;
+    std::vector<float> m_polygonVertices;
 
     bool m_polygonLineMode{false};
 
@@ -45,16 +55,16 @@ public:
     : dust::Application("Triangle"),
     m_polygonLineMode(false),
     m_shader(dust::createRef<dust::render::Shader>(vCode, fCode)),
-    m_triangle(dust::createRef<dust::render::Mesh>(triangleVertices, sizeof(float) * 8, 3, 
-    std::vector<dust::render::Attribute>{
-        dust::render::Attribute::Pos3D,
-        dust::render::Attribute::Color
-    }))
-    {  }
+    m_triangle(dust::createRef<dust::render::Mesh>(triangleVertices.data(), 3, ColorVertexLayout::Format())),
+    m_polygon(dust::createRef<dust::render::DynamicMesh>(ColorVertexLayout::Format(), POLYGON_SIDES * 3))
+    {
+        m_polygonVertices.reserve(POLYGON_SIDES * 3 * 7);
+    }
 
     ~TriangleApp() {
         m_shader.reset();
         m_triangle.reset();
+        m_polygon.reset();
     }
 
     void update() override
@@ -64,11 +74,31 @@ public:
             m_polygonLineMode = !m_polygonLineMode;
             getRenderer()->setDrawWireframe(m_polygonLineMode);
         }
+
+        // wobbling polygon in the corner, only a part of it is drawn
+        const f32 time = getTime().time;
+        m_polygonVertices.clear();
+        const auto vertex = [&](f32 x, f32 y, f32 shade) {
+            m_polygonVertices.insert(m_polygonVertices.end(), {x, y, 0.f, shade, .5f, 1.f - shade, 1.f});
+        };
+        for(u32 i = 0; i < POLYGON_SIDES; ++i) {
+            const f32 a0 = glm::two_pi<f32>() * i / POLYGON_SIDES;
+            const f32 a1 = glm::two_pi<f32>() * (i + 1) / POLYGON_SIDES;
+            const f32 r0 = .2f + .03f * sin(a0 * 6.f + time * 3.f);
+            const f32 r1 = .2f + .03f * sin(a1 * 6.f + time * 3.f);
+            vertex(.7f, .6f, .5f);
+            vertex(.7f + cos(a0) * r0, .6f + sin(a0) * r0, (f32)i / POLYGON_SIDES);
+            vertex(.7f + cos(a1) * r1, .6f + sin(a1) * r1, (f32)(i + 1) / POLYGON_SIDES);
+        }
+        m_polygon->updateVertices(0, m_polygonVertices.data(), POLYGON_SIDES * 3);
+        const u32 sides = (u32)((sin(time) * .5f + .5f) * POLYGON_SIDES);
+        m_polygon->setDrawRange(0, sides * 3);
     }
 
     void render() override 
     {
         m_triangle->draw(m_shader.get());
+        m_polygon->draw(m_shader.get());
     }
 };
 
@@ -0,0 +1,139 @@
+#include "dust/core/log.hpp"
+#include "dust/dust.hpp"
+#include "dust/io/keycodes.hpp"
+#include "dust/render/renderAPI.hpp"
+#include "dust/render/shader.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <chrono>
+#include <format>
+#include <unordered_map>
+
+// Compares the uniform setting paths:
+//  - string: name built with std::format / operator+ and looked up in a string map (previous Shader path)
+//  - hashed: StringID name, one integer lookup
+//  - handle: location cached with Shader::getUniformHandle
+
+std::string vCode = SHADER_SOURCE(
+    "#version 460 core",
+    layout (location = 0) in vec3 aPos;
+    uniform mat4 uModel;
+    void main() {
+        gl_Position = uModel * vec4(aPos, 1.f);
+    }
+);
+
+std::string fCode = SHADER_SOURCE(
+    "#version 460 core",
+    struct light_t {
+        vec3 color;
+        float intensity;
+    };
+    uniform light_t uLights[4];
+    out vec4 fragColor;
+    void main() {
+        vec3 color = vec3(0.);
+        for(int i = 0; i < 4; ++i) color += uLights[i].color * uLights[i].intensity;
+        fragColor = vec4(color, 1.);
+    }
+);
+
+constexpr u32 ITERATIONS = 100000;
+constexpr u32 LIGHT_COUNT = 4;
+
+class UniformBenchApp
+: public dust::Application
+{
+private:
+    dust::render::ShaderPtr m_shader;
+
+public:
+    UniformBenchApp()
+    : dust::Application("Uniform Bench"),
+    m_shader(dust::createRef<dust::render::Shader>(vCode, fCode))
+    {
+        DUST_INFO("Press B to run the benchmark again.");
+        runBenchmark();
+    }
+
+    ~UniformBenchApp() {
+        m_shader.reset();
+    }
+
+    void update() override
+    {
+        if(getInputManager()->isKey(dust::Key::B, dust::KeyState::Press)) {
+            runBenchmark();
+        }
+    }
+
+private:
+    template<typename Func>
+    static double measure(Func &&func)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for(u32 i = 0; i < ITERATIONS; ++i) {
+            func(i % LIGHT_COUNT);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const std::chrono::duration<double, std::nano> elapsed = end - start;
+        // 3 uniforms per iteration
+        return elapsed.count() / (ITERATIONS * 3);
+    }
+
+    void runBenchmark()
+    {
+        const u32 program = m_shader->getRenderID();
+        const glm::mat4 model{1.f};
+        const glm::vec3 color{1.f, .5f, .25f};
+
+        // previous path: string keyed map
+        std::unordered_map<std::string, i32> locations;
+        for(u32 i = 0; i < LIGHT_COUNT; ++i) {
+            const std::string loc = std::format("uLights[{}]", i);
+            locations[loc + ".color"]     = glGetUniformLocation(program, (loc + ".color").c_str());
+            locations[loc + ".intensity"] = glGetUniformLocation(program, (loc + ".intensity").c_str());
+        }
+        locations["uModel"] = glGetUniformLocation(program, "uModel");
+        const auto find = [&](const std::string &name) {
+            const auto found = locations.find(name);
+            return found == locations.end() ? -1 : found->second;
+        };
+
+        const double stringTime = measure([&](u32 i) {
+            const std::string loc = std::format("uLights[{}]", i);
+            glProgramUniform3f(program, find(loc + ".color"), color.x, color.y, color.z);
+            glProgramUniform1f(program, find(loc + ".intensity"), 1.f);
+            glProgramUniformMatrix4fv(program, find("uModel"), 1, GL_FALSE, glm::value_ptr(model));
+        });
+
+        const double hashedTime = measure([&](u32 i) {
+            const dust::StringID loc = dust::StringID("uLights").index(i);
+            m_shader->setUniform(loc.append(".color"), color);
+            m_shader->setUniform(loc.append(".intensity"), 1.f);
+            m_shader->setUniform("uModel", model);
+        });
+
+        dust::render::UniformHandle colorHandles[LIGHT_COUNT];
+        dust::render::UniformHandle intensityHandles[LIGHT_COUNT];
+        for(u32 i = 0; i < LIGHT_COUNT; ++i) {
+            const dust::StringID loc = dust::StringID("uLights").index(i);
+            colorHandles[i]     = m_shader->getUniformHandle(loc.append(".color"));
+            intensityHandles[i] = m_shader->getUniformHandle(loc.append(".intensity"));
+        }
+        const auto modelHandle = m_shader->getUniformHandle("uModel");
+        const double handleTime = measure([&](u32 i) {
+            m_shader->setUniform(colorHandles[i], color);
+            m_shader->setUniform(intensityHandles[i], 1.f);
+            m_shader->setUniform(modelHandle, model);
+        });
+
+        DUST_INFO("[UniformBench] {} uniforms per path", ITERATIONS * 3);
+        DUST_INFO("[UniformBench] string : {:.1f} ns/uniform", stringTime);
+        DUST_INFO("[UniformBench] hashed : {:.1f} ns/uniform ({:.2f}x)", hashedTime, stringTime / hashedTime);
+        DUST_INFO("[UniformBench] handle : {:.1f} ns/uniform ({:.2f}x)", handleTime, stringTime / handleTime);
+    }
+};
+
+DUST_SIMPLE_ENTRY(UniformBenchApp)
@@ -13,6 +13,7 @@
 #include <unordered_map>
 
 #include "dust/render/renderer.hpp"
+#include "dust/render/renderQueue.hpp"
 
 #include "dust/io/inputManager.hpp"
 #include "dust/io/resourceManager.hpp"
@@ -32,6 +33,7 @@ private:
     Time m_time;
     Scope<Window> m_window;
     Scope<Renderer> m_renderer;
+    Scope<render::RenderQueue> m_renderQueue;
     Scope<InputManager> m_inputManager;
     Scope<io::ResourceManager> m_resourceManager;
     Scope<ScriptingManager> m_scriptingManager;
@@ -49,6 +51,7 @@ public:
 
     [[nodiscard]] Window* getWindow() const;
     [[nodiscard]] Renderer* getRenderer() const;
+    [[nodiscard]] render::RenderQueue* getRenderQueue() const;
     [[nodiscard]] InputManager* getInputManager() const;
     [[nodiscard]] io::ResourceManager* getResourceManager() const;
     [[nodiscard]] ScriptingManager* getScriptingManager() const;
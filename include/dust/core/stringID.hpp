@@ -0,0 +1,90 @@
+#ifndef _DUST_CORE_STRINGID_HPP_
+#define _DUST_CORE_STRINGID_HPP_
+
+#include "types.hpp"
+
+#include <functional>
+#include <string_view>
+
+namespace dust {
+
+/**
+ * @brief Hashed string identifier (64 bits FNV-1a).
+ *
+ * Literals are hashed at compile time (the constructor is consteval),
+ * runtime strings must go through StringID::Runtime.
+ * The hash is streamed: `StringID("uLights").index(2).append(".color")`
+ * equals `StringID("uLights[2].color")` without building the string.
+ */
+class StringID {
+private:
+    static constexpr u64 FNV_OFFSET = 0xcbf29ce484222325ull;
+    static constexpr u64 FNV_PRIME  = 0x100000001b3ull;
+
+    u64 m_hash;
+
+    constexpr explicit StringID(u64 hash) : m_hash(hash) {}
+
+public:
+    /**
+     * @brief Hash a string literal at compile time
+     */
+    consteval StringID(const char *str) : m_hash(Hash(str)) {}
+
+    /**
+     * @brief Hash a runtime string
+     */
+    static constexpr StringID Runtime(std::string_view str) {
+        return StringID(Hash(str));
+    }
+
+    /**
+     * @brief Continue the hash with another string
+     */
+    constexpr StringID append(std::string_view str) const {
+        return StringID(Hash(str, m_hash));
+    }
+
+    /**
+     * @brief Continue the hash with an array access (`[index]`)
+     */
+    constexpr StringID index(u32 index) const {
+        char digits[10];
+        u32 count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + index % 10);
+            index /= 10;
+        } while (index != 0);
+
+        u64 hash = Hash("[", m_hash);
+        while (count > 0) {
+            hash = (hash ^ static_cast<u8>(digits[--count])) * FNV_PRIME;
+        }
+        return StringID(Hash("]", hash));
+    }
+
+    constexpr u64 get() const { return m_hash; }
+
+    constexpr bool operator==(const StringID &other) const = default;
+
+    static constexpr u64 Hash(std::string_view str, u64 hash = FNV_OFFSET) {
+        for (const char c : str) {
+            hash = (hash ^ static_cast<u8>(c)) * FNV_PRIME;
+        }
+        return hash;
+    }
+};
+
+static_assert(StringID("uLights").index(12).append(".color") == StringID("uLights[12].color"));
+
+}  // namespace dust
+
+template <>
+struct std::hash<dust::StringID> {
+    // already a hash
+    std::size_t operator()(const dust::StringID &id) const noexcept {
+        return static_cast<std::size_t>(id.get());
+    }
+};
+
+#endif  //_DUST_CORE_STRINGID_HPP_
@@ -0,0 +1,57 @@
+#ifndef _DUST_CORE_WORKERPOOL_HPP_
+#define _DUST_CORE_WORKERPOOL_HPP_
+
+#include "types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dust {
+
+/**
+ * @brief Threads waiting for batches of independent tasks.
+ *
+ * `dispatch` runs `task(0..count-1)` on the workers and the calling thread,
+ * tasks are picked one after the other, and returns when all are done.
+ */
+class WorkerPool {
+private:
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const std::function<void(u32)> *m_task;
+    u32 m_taskCount;
+    std::atomic<u32> m_nextTask;
+    u32 m_activeWorkers;
+    u64 m_generation;
+    bool m_stop;
+
+public:
+    /**
+     * @param threadCount worker threads besides the calling thread (0: dispatch runs inline)
+     */
+    explicit WorkerPool(u32 threadCount);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &)            = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /**
+     * @brief Run `task(0..count-1)` on the workers and the calling thread
+     */
+    void dispatch(u32 count, const std::function<void(u32)> &task);
+
+    [[nodiscard]] u32 getThreadCount() const;
+
+private:
+    void workerLoop();
+};
+
+}  // namespace dust
+
+#endif  //_DUST_CORE_WORKERPOOL_HPP_
@@ -3,8 +3,10 @@
 // ---------------------------------
 #include "core/application.hpp"
 #include "core/types.hpp"
+#include "core/stringID.hpp"
 #include "core/log.hpp"
 #include "core/profiling.hpp"
+#include "core/workerPool.hpp"
 
 // ---------------------------------
 // Render includes
@@ -12,15 +14,38 @@
 #include "render/renderer.hpp"
 #include "render/shader.hpp"
 #include "render/mesh.hpp"
+#include "render/instancedMesh.hpp"
+#include "render/geometryArena.hpp"
+#include "render/indirectBatch.hpp"
+#include "render/streamBuffer.hpp"
+#include "render/dynamicMesh.hpp"
+#include "render/culling.hpp"
+#include "render/occlusionCuller.hpp"
+#include "render/meshlet.hpp"
+#include "render/lod.hpp"
+#include "render/meshOptimizer.hpp"
+#include "render/vertexPacking.hpp"
+#include "render/vertexLayout.hpp"
+#include "render/cascadeShadowMap.hpp"
+#include "render/lightClusters.hpp"
 #include "render/model.hpp"
 #include "render/camera.hpp"
 #include "render/framebuffer.hpp"
 #include "render/light.hpp"
 #include "render/material.hpp"
 #include "render/renderPass.hpp"
+#include "render/renderQueue.hpp"
+#include "render/glStateCache.hpp"
+#include "render/uniformBuffer.hpp"
+#include "render/materialTable.hpp"
 #include "render/texture.hpp"
 #include "render/skybox.hpp"
 
+// ---------------------------------
+// Scene includes
+// ---------------------------------
+#include "scene/bvh.hpp"
+
 // ---------------------------------
 // IO includes
 // ---------------------------------
@@ -9,6 +9,8 @@
 
 #include "dust/render/framebuffer.hpp"
 
+#include <optional>
+
 namespace dust {
 
 class EditorSceneView : public EditorTool {
@@ -16,6 +18,8 @@ private:
     render::Framebuffer* m_scene_result_buffer{nullptr};
     glm::vec2 m_size;
     bool m_resized;
+    // normalized device coordinates of this frame click
+    std::optional<glm::vec2> m_clicked;
 
 public:
     explicit EditorSceneView(render::Framebuffer* scene_result_buffer);
@@ -26,6 +30,10 @@ public:
 
     bool was_resized() const;
     glm::vec2 get_size() const;
+    /**
+     * @brief Position (in normalized device coordinates) of the left click on the scene this frame
+     */
+    std::optional<glm::vec2> get_clicked_position() const;
     bool is_panel_tool() const override;
 };
 
@@ -7,12 +7,18 @@
 
 #include "dust/editor/editor.hpp"
 #include "dust/render/model.hpp"
+#include "dust/scene/bvh.hpp"
 
 namespace dust {
 
 class ModelTool : public EditorTool {
 private:
     render::Model* m_inspected_model;
+    // world bounds of the inspected meshes, for picking
+    scene::BVH m_bvh;
+    std::vector<u32> m_bvh_meshes;
+    i32 m_selected_mesh;
+    bool m_scroll_to_selected;
 
 public:
     ModelTool();
@@ -20,6 +26,16 @@ public:
 
     void render_ui() override;
     void set_inspected_model(render::Model *model);
+
+    /**
+     * @brief Select the nearest mesh of the inspected model hit by the ray
+     * @return index of the selected mesh, -1 if none
+     */
+    i32 pick(const scene::Ray &ray);
+    i32 get_selected_mesh() const;
+
+private:
+    void build_bvh();
 };
 
 }
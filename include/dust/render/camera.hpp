@@ -3,7 +3,9 @@
 
 #include "dust/core/types.hpp"
 #include "dust/core/window.hpp"
+#include "dust/render/culling.hpp"
 #include "dust/render/shader.hpp"
+#include "dust/render/uniformBuffer.hpp"
 #include "glm/ext/matrix_float4x4.hpp"
 #include "glm/ext/quaternion_float.hpp"
 #include "glm/ext/vector_float3.hpp"
@@ -33,6 +35,15 @@ protected:
     f32 m_near;
     f32 m_far;
 
+    // view or projection changed since the last upload
+    bool m_dirty;
+
+    // derived from the view and projection, recomputed on demand
+    mutable glm::mat4 m_viewProj;
+    mutable glm::mat4 m_invViewProj;
+    mutable Frustum m_frustum;
+    mutable bool m_frustumDirty;
+
     inline static Camera *s_activeCamera;
 
 protected:
@@ -46,6 +57,15 @@ public:
     virtual void move(glm::vec3 translation) = 0;
 
     [[nodiscard]] virtual CameraFrustrum getFrustrum() const;
+    /**
+     * @brief World space planes of the view frustum (cached until the camera changes)
+     */
+    [[nodiscard]] const Frustum &getFrustum() const;
+    [[nodiscard]] const glm::mat4 &getViewProj() const;
+    /**
+     * @brief World space position of a point in normalized device coordinates
+     */
+    [[nodiscard]] glm::vec3 unproject(glm::vec3 ndc) const;
 
     void makeActive();
     static Camera *GetActive();
@@ -56,8 +76,25 @@ public:
     void setProj(glm::mat4 proj);
     glm::mat4 getProj() const;
 
+    f32 getFar() const;
+    f32 getNear() const;
+
+    /**
+     * @brief Get the `ViewData` uniform block content of this camera
+     */
+    [[nodiscard]] ViewData getViewData() const;
+    [[nodiscard]] bool isDirty() const;
+    void setDirty(bool dirty);
+
 protected:
     virtual void updateViewMatrix() = 0;
+    /**
+     * @brief Flag the view or projection as changed
+     */
+    void invalidate();
+
+private:
+    void updateFrustum() const;
 };
 using CameraPtr = Ref<Camera>;
 using CameraUPtr = Scope<Camera>;
@@ -111,6 +148,7 @@ public:
     void move(glm::vec2 translation) override;
     void move(glm::vec3 translation) override;
     void setPosition(glm::vec3 position);
+    glm::vec3 getPosition() const;
 
     void rotate(glm::vec3 angle);
     void setRotation(glm::vec3 rotation);
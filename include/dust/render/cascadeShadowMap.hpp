@@ -3,17 +3,255 @@
 
 #include "../core/types.hpp"
 #include "dust/render/camera.hpp"
-#include "dust/render/framebuffer.hpp"
+#include "dust/render/culling.hpp"
+#include "dust/render/uniformBuffer.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float3.hpp"
+
+#include <array>
+
+#ifndef DUST_SHADOW_MAP_SIZE
+/**
+ * @brief Default width and height of the shadow maps (texels)
+ */
+#define DUST_SHADOW_MAP_SIZE 2048
+#endif
+
+#ifndef DUST_SHADOW_CENTER_STEP
+/**
+ * @brief Cascades move by steps of this fraction of their radius (see CascadeShadowMap::FitCascade)
+ */
+#define DUST_SHADOW_CENTER_STEP .125f
+#endif
 
 namespace dust {
 namespace render {
 
+class DirectionnalLight;
+class RenderQueue;
+
+/** @brief Texture unit the cascades are usually bound to (`uShadowMap`, see CascadeShadowMap::bindTexture) */
+constexpr u32 SHADOW_MAP_UNIT = 28;
+
+/**
+ * @brief Orthographic shadow projection of a part of the view frustum
+ */
+struct ShadowCascade {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::mat4 viewProj;
+    /// light space volume of the casters that can shadow the cascade
+    Frustum casters;
+    /// light position used to sort and cull the casters (far behind the cascade)
+    glm::vec3 lightPosition;
+    /// distance from the light position to the far end of the cascade
+    f32 depthRange;
+    /// view distances covered by the cascade
+    f32 splitNear;
+    f32 splitFar;
+    /// world size of a texel
+    f32 texelSize;
+};
+
+/**
+ * @brief Directional light shadows over the view frustum split in `DUST_SHADOW_CASCADES` cascades.
+ *
+ * Every cascade is a layer of one depth texture array (sampled as a `sampler2DArrayShadow`).
+ * Its projection is fitted to the bounding sphere of its slice of Camera::getFrustrum
+ * and snapped to the texels, so that the shadows do not shimmer when the camera moves or turns.
+ * The depth is clamped instead of clipped (pancaking): the depth range stays tight around the
+ * slice while the casters between it and the light are still drawn, their culling volume
+ * reaches the caster bounds (setCasterBounds).
+ *
+ * Static casters are cached: their depth is kept in a second texture array and only drawn
+ * again when the light, the cascade projection (its center moves by `DUST_SHADOW_CENTER_STEP`
+ * steps) or a static caster (invalidate) changes. Dynamic casters are drawn each update
+ * over a copy of the cached depth. The distant cascades (all but the first) can be updated
+ * every N frames, one after the other (setUpdateInterval).
+ *
+ * Usage, each frame:
+ * @code
+ * shadows.update(*camera, sun);
+ * renderer->setShadowData(shadows.getShadowData());
+ * for (u32 c = 0; c < shadows.getCascadeCount(); ++c) {
+ *     if (!shadows.needsUpdate(c)) continue;
+ *     if (shadows.needsStaticUpdate(c)) {
+ *         shadows.bindStatic(c, queue);
+ *         renderer->setViewData(shadows.getViewData(c));
+ *         level->submit(*queue, depthShader);
+ *         queue->flush();
+ *     }
+ *     shadows.bind(c, queue);  // only when there are dynamic casters
+ *     renderer->setViewData(shadows.getViewData(c));
+ *     character->submit(*queue, depthShader);
+ *     queue->flush();
+ * }
+ * shadows.unbind();
+ * @endcode
+ */
 class CascadeShadowMap {
+public:
+    /**
+     * @brief Counters of the last frame
+     */
+    struct Stats {
+        /// cascades refitted
+        u32 updated;
+        /// cascades whose static casters were drawn
+        u32 staticRenders;
+        /// cascades whose dynamic casters were drawn
+        u32 dynamicRenders;
+        /// cached depth copied to the cascades
+        u32 copies;
+    };
+
+protected:
+    u32 m_renderID;
+    /// depth of the static casters, a layer per cascade
+    u32 m_staticRenderID;
+    u32 m_framebuffer;
+    u32 m_size;
+    u32 m_cascadeCount;
+    /// blend between the uniform (0) and logarithmic (1) split schemes
+    f32 m_splitLambda;
+    /// view distance covered by the shadows, the camera far plane when 0
+    f32 m_shadowDistance;
+    AABB m_casterBounds;
+    /// frames between two updates of a distant cascade
+    u32 m_updateInterval;
+    u32 m_frame;
+    glm::vec3 m_lightDirection;
+
+    std::array<ShadowCascade, DUST_SHADOW_CASCADES> m_cascades;
+    /// refitted by the last update
+    std::array<bool, DUST_SHADOW_CASCADES> m_scheduled;
+    /// cached static depth matches the cascade projection
+    std::array<bool, DUST_SHADOW_CASCADES> m_staticValid;
+    /// cascade layer holds dynamic casters
+    std::array<bool, DUST_SHADOW_CASCADES> m_dynamic;
+    /// cascade layer must be copied from the cache at unbind
+    std::array<bool, DUST_SHADOW_CASCADES> m_stale;
+    Stats m_stats;
+
+public:
+    /**
+     * @param size width and height of every cascade (texels)
+     * @param cascadeCount number of cascades (1 to DUST_SHADOW_CASCADES)
+     */
+    explicit CascadeShadowMap(u32 size = DUST_SHADOW_MAP_SIZE, u32 cascadeCount = DUST_SHADOW_CASCADES,
+                              f32 splitLambda = .75f);
+    ~CascadeShadowMap();
+
+    CascadeShadowMap(const CascadeShadowMap &)            = delete;
+    CascadeShadowMap &operator=(const CascadeShadowMap &) = delete;
+
+    /**
+     * @brief Fit the cascades updated this frame to the camera frustum,
+     * a new light direction updates and invalidates every cascade
+     */
+    void update(const Camera &camera, const DirectionnalLight &light);
+    void update(const Camera &camera, glm::vec3 lightDirection);
+
+    /**
+     * @brief If the cascade was refitted by the last update and its casters must be drawn
+     */
+    [[nodiscard]] bool needsUpdate(u32 cascade) const;
+    /**
+     * @brief If the cached static casters of an updated cascade must be drawn again (bindStatic)
+     */
+    [[nodiscard]] bool needsStaticUpdate(u32 cascade) const;
+    /**
+     * @brief Drop the cached static casters of every cascade
+     */
+    void invalidate();
+    /**
+     * @brief Drop the cached static casters of the cascades a static caster can shadow
+     * @param bounds world bounds of the caster that changed (before and after a move)
+     */
+    void invalidate(const AABB &bounds);
+
+    /**
+     * @brief Render the static casters of a cascade into its cache (see bind), it is valid until invalidated
+     */
+    void bindStatic(u32 cascade, RenderQueue *queue = nullptr);
+    /**
+     * @brief Render the dynamic casters of a cascade (viewport, depth clamp) over its cached static
+     * casters and cull the casters of the queue against its light space volume at the next flush.
+     * The queue view position is moved behind the cascade and its LOD selection is disabled,
+     * set them again for the next views.
+     * @param queue optional queue the casters are pushed into
+     */
+    void bind(u32 cascade, RenderQueue *queue = nullptr);
+    /**
+     * @brief Copy the static casters to the cascades without dynamic ones,
+     * restore the default framebuffer and depth clipping
+     */
+    void unbind();
+    /**
+     * @brief Bind the depth texture array (with depth comparison) to a texture unit
+     */
+    void bindTexture(u32 unit) const;
+
+    /**
+     * @brief `ViewData` block of a cascade, for the depth shaders reading uViewProj
+     */
+    [[nodiscard]] ViewData getViewData(u32 cascade) const;
+    /**
+     * @brief `ShadowData` block of the cascades, for the shaders sampling the shadows
+     */
+    [[nodiscard]] ShadowData getShadowData() const;
+
+    /**
+     * @brief Update the distant cascades every `frames` frames, one after the other (1: every frame)
+     */
+    void setUpdateInterval(u32 frames);
+    u32 getUpdateInterval() const;
+    void setShadowDistance(f32 distance);
+    f32 getShadowDistance() const;
+    /**
+     * @brief World bounds of every shadow caster, to reach the casters outside of the view (invalid by default)
+     */
+    void setCasterBounds(const AABB &bounds);
+
+    u32 getRenderID() const;
+    u32 getSize() const;
+    u32 getCascadeCount() const;
+    const ShadowCascade &getCascade(u32 cascade) const;
+    [[nodiscard]] const Stats &getStats() const;
+
+    /**
+     * @brief Practical split scheme (Zhang et al. 2006): view distances where the cascades end
+     * @param lambda 0 uniform, 1 logarithmic
+     */
+    static std::array<f32, DUST_SHADOW_CASCADES> ComputeSplits(f32 near, f32 far, u32 count, f32 lambda);
+    /**
+     * @brief Fit a stable orthographic projection to a slice of the view frustum
+     * @param frustrum corners of the view frustum (see Camera::getFrustrum)
+     * @param sliceNear, sliceFar part of the frustum depth covered (0: near plane, 1: far plane)
+     * @param lightDirection direction to the light
+     * @param size shadow map size, the projection is snapped to its texels
+     * @param casterBounds casters to include toward the light, when valid
+     * @param centerStep the cascade center moves by steps of this fraction of its radius (0: follows the slice),
+     * its projection stays the same while the camera moves inside a step
+     */
+    static ShadowCascade FitCascade(const CameraFrustrum &frustrum, f32 sliceNear, f32 sliceFar,
+                                    glm::vec3 lightDirection, u32 size, const AABB &casterBounds = AABB{},
+                                    f32 centerStep = 0.f);
+
 protected:
-    Camera3DPtr m_camera;
+    /**
+     * @brief Render into a layer of the cascades or of the cache
+     */
+    void bindLayer(u32 texture, u32 cascade, RenderQueue *queue);
+    /**
+     * @brief Copy the cached static casters to a cascade
+     */
+    void copyStatic(u32 cascade);
 };
+using CascadeShadowMapPtr  = Ref<CascadeShadowMap>;
+using CascadeShadowMapUPtr = Scope<CascadeShadowMap>;
 
-} // namespace render
-} // namespace dust
+}  // namespace render
+}  // namespace dust
 
-#endif //_DUST_RENDER_CASCADESHADOWMAP_HPP_s
\ No newline at end of file
+#endif  //_DUST_RENDER_CASCADESHADOWMAP_HPP_
@@ -0,0 +1,92 @@
+#ifndef _DUST_RENDER_CULLING_HPP_
+#define _DUST_RENDER_CULLING_HPP_
+
+#include "../core/types.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float3.hpp"
+#include "glm/ext/vector_float4.hpp"
+
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief Axis aligned bounding box, empty (min > max) until a point is added
+ */
+struct AABB {
+    glm::vec3 min{std::numeric_limits<f32>::max()};
+    glm::vec3 max{std::numeric_limits<f32>::lowest()};
+
+    void extend(glm::vec3 point);
+    void extend(const AABB &other);
+    [[nodiscard]] bool isValid() const;
+
+    [[nodiscard]] glm::vec3 getCenter() const;
+    [[nodiscard]] glm::vec3 getExtent() const;
+    /**
+     * @brief Bounding box of this box transformed by `transform`
+     */
+    [[nodiscard]] AABB transformed(const glm::mat4 &transform) const;
+};
+
+/**
+ * @brief World space frustum planes (`xyz` inward normal, `w` distance)
+ */
+struct Frustum {
+    enum Plane : u32 {
+        PLANE_LEFT = 0,
+        PLANE_RIGHT,
+        PLANE_BOTTOM,
+        PLANE_TOP,
+        PLANE_NEAR,
+        PLANE_FAR,
+        PLANE_COUNT
+    };
+    std::array<glm::vec4, PLANE_COUNT> planes;
+
+    /**
+     * @brief Extract the normalized planes of a view projection matrix (Gribb-Hartmann)
+     */
+    static Frustum FromMatrix(const glm::mat4 &viewProj);
+
+    [[nodiscard]] bool intersects(const AABB &box) const;
+};
+
+/**
+ * @brief Test arrays of boxes against a frustum, 4 boxes at a time (SSE).
+ *
+ * Boxes are stored as structure of arrays of centers and extents,
+ * invalid boxes are never culled.
+ */
+class FrustumCuller {
+private:
+    // SoA, padded to a multiple of 4
+    std::vector<f32> m_centerX, m_centerY, m_centerZ;
+    std::vector<f32> m_extentX, m_extentY, m_extentZ;
+    u32 m_count;
+
+public:
+    FrustumCuller();
+
+    /**
+     * @brief Add a world space box
+     * @return index of its visibility in the `cull` result
+     */
+    u32 push(const AABB &box);
+    void clear();
+    [[nodiscard]] u32 size() const;
+
+    /**
+     * @brief Write the visibility (1 visible, 0 culled) of every pushed box
+     * @return number of visible boxes
+     */
+    u32 cull(const Frustum &frustum, std::vector<u8> &visibility) const;
+};
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_CULLING_HPP_
@@ -0,0 +1,82 @@
+#ifndef _DUST_RENDER_DYNAMICMESH_HPP_
+#define _DUST_RENDER_DYNAMICMESH_HPP_
+
+#include "../core/types.hpp"
+#include "mesh.hpp"
+
+#include <span>
+#include <vector>
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief Mesh whose vertices and indices are rewritten at runtime
+ * (procedural geometry, debug shapes, deformations).
+ *
+ * The GL objects are created once: a full rewrite orphans the buffer
+ * so the driver hands a fresh storage instead of waiting for the GPU,
+ * partial updates only upload the changed range. Only the draw range is drawn.
+ */
+class DynamicMesh : public Mesh {
+private:
+    u32 m_stride;
+    u32 m_vertexCapacity;
+    u32 m_indexCapacity;
+    /// vertices and indices currently written
+    u32 m_vertexSize;
+    u32 m_indexSize;
+    /// the draw range follows the written elements
+    bool m_fullRange;
+
+public:
+    /**
+     * @param attributes vertex layout
+     * @param vertexCapacity initial number of vertices
+     * @param indexCapacity initial number of indices (0 to draw without indices)
+     */
+    DynamicMesh(const std::vector<Attribute> &attributes, u32 vertexCapacity, u32 indexCapacity = 0);
+    /**
+     * @param format vertex layout, usually `VertexLayout<...>::Format()`
+     */
+    DynamicMesh(const VertexFormat &format, u32 vertexCapacity, u32 indexCapacity = 0);
+
+    /**
+     * @brief Write `vertexCount` vertices starting at `firstVertex`,
+     * the buffer grows (keeping its content) if needed
+     */
+    void updateVertices(u32 firstVertex, const void *vertices, u32 vertexCount);
+    template <typename T>
+    void updateVertices(u32 firstVertex, std::span<const T> vertices) {
+        updateVertices(firstVertex, vertices.data(), vertices.size_bytes() / m_stride);
+    }
+    /**
+     * @brief Write indices starting at `firstIndex`
+     */
+    void updateIndices(u32 firstIndex, std::span<const u32> indices);
+
+    /**
+     * @brief Elements drawn: indices if the mesh has any, vertices otherwise
+     */
+    void setDrawRange(u32 first, u32 count);
+    /**
+     * @brief Draw every written element
+     */
+    void resetDrawRange();
+
+    u32 getStride() const;
+    u32 getVertexCapacity() const;
+    u32 getIndexCapacity() const;
+
+private:
+    /// upload `count` elements at `first`, orphaning when the whole content is replaced
+    static void Upload(u32 buffer, u32 &capacity, u32 elementSize, u32 &written, u32 first, const void *data,
+                       u32 count);
+};
+using DynamicMeshPtr  = Ref<DynamicMesh>;
+using DynamicMeshUPtr = Scope<DynamicMesh>;
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_DYNAMICMESH_HPP_
@@ -50,9 +50,9 @@ public:
     ~Framebuffer();
 
     /**
-     * @brief Resize framebuffer (recreates it by default)
+     * @brief Resize framebuffer (recreates it and its attachments)
      */
-    void resize(u32 width, u32 height, bool recreate = true);
+    void resize(u32 width, u32 height);
 
 
     void bind();
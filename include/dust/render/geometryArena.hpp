@@ -0,0 +1,92 @@
+#ifndef _DUST_RENDER_GEOMETRYARENA_HPP_
+#define _DUST_RENDER_GEOMETRYARENA_HPP_
+
+#include "../core/types.hpp"
+#include "mesh.hpp"
+
+#include <vector>
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief Vertex and index range sub-allocated in a GeometryArena
+ */
+struct GeometryRange {
+    /// first vertex in the arena vertex buffer
+    u32 baseVertex{0};
+    u32 vertexCount{0};
+    /// first index in the arena index buffer
+    u32 firstIndex{0};
+    u32 indexCount{0};
+};
+
+/**
+ * @brief Large shared vertex and index buffers for one vertex layout.
+ *
+ * Meshes are sub-allocated linearly (indices stay relative to their range),
+ * every range shares the same VAO so their draws can be merged (see IndirectBatch).
+ * The buffers double their size when full.
+ */
+class GeometryArena {
+private:
+    u32 m_renderID;
+    u32 m_vbo;
+    u32 m_ebo;
+
+    u32 m_stride;
+    u32 m_vertexCapacity;
+    u32 m_indexCapacity;
+    u32 m_vertexCount;
+    u32 m_indexCount;
+
+public:
+    /**
+     * @param attributes vertex layout of every range
+     * @param vertexCapacity initial number of vertices
+     * @param indexCapacity initial number of indices
+     */
+    GeometryArena(const std::vector<Attribute> &attributes, u32 vertexCapacity = 1 << 16,
+                  u32 indexCapacity = 1 << 18);
+    /**
+     * @param format vertex layout of every range, usually `VertexLayout<...>::Format()`
+     */
+    GeometryArena(const VertexFormat &format, u32 vertexCapacity = 1 << 16, u32 indexCapacity = 1 << 18);
+    ~GeometryArena();
+
+    GeometryArena(const GeometryArena &)            = delete;
+    GeometryArena &operator=(const GeometryArena &) = delete;
+
+    /**
+     * @brief Copy a mesh into the arena
+     * @param vertices vertex data (vertexCount * stride bytes)
+     * @param indices indices relative to the first vertex
+     * @return the range, empty if the arena could not grow
+     */
+    GeometryRange allocate(const void *vertices, u32 vertexCount, const std::vector<u32> &indices);
+    /**
+     * @brief Drop every range (the buffers keep their size)
+     */
+    void reset();
+
+    void bind() const;
+
+    u32 getRenderID() const;
+    u32 getStride() const;
+    u32 getVertexCount() const;
+    u32 getIndexCount() const;
+
+private:
+    /**
+     * @brief Move to larger buffers, false (and nothing changes) if they can not be created
+     */
+    bool growVertices(u32 capacity);
+    bool growIndices(u32 capacity);
+};
+using GeometryArenaPtr  = Ref<GeometryArena>;
+using GeometryArenaUPtr = Scope<GeometryArena>;
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_GEOMETRYARENA_HPP_
@@ -0,0 +1,122 @@
+#ifndef _DUST_RENDER_GLSTATECACHE_HPP_
+#define _DUST_RENDER_GLSTATECACHE_HPP_
+
+#include "../core/types.hpp"
+
+#include <array>
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief Shadow copy of the OpenGL bindings and fixed function states.
+ *
+ * Every engine wrapper (Shader, Mesh, Texture, Framebuffer, Renderer...) goes through
+ * it so calls that would not change the current state are dropped.
+ * Code issuing raw GL calls behind its back must call GLStateCache::Invalidate().
+ */
+class GLStateCache {
+public:
+    /**
+     * @brief Issued and skipped GL calls
+     */
+    struct Counters {
+        u32 issued;
+        u32 skipped;
+    };
+
+    static constexpr u32 MAX_TEXTURE_UNITS = 32;
+
+private:
+    /// Targets with a cached binding per texture unit
+    enum TextureTarget : u32 {
+        Texture2D = 0,
+        Texture2DArray,
+        TextureCubeMap,
+        TextureTargetCount
+    };
+
+    /// unknown state, the next call is always issued
+    static constexpr u32 UNKNOWN = ~0u;
+
+    inline static u32 s_program     = UNKNOWN;
+    inline static u32 s_vertexArray = UNKNOWN;
+    inline static u32 s_framebuffer = UNKNOWN;
+    inline static u32 s_activeUnit  = UNKNOWN;
+    inline static std::array<std::array<u32, TextureTargetCount>, MAX_TEXTURE_UNITS> s_textures{};
+
+    inline static u32 s_depthTest   = UNKNOWN;
+    inline static u32 s_depthWrite  = UNKNOWN;
+    inline static u32 s_depthFunc   = UNKNOWN;
+    inline static u32 s_depthClamp  = UNKNOWN;
+    inline static u32 s_culling     = UNKNOWN;
+    inline static u32 s_cullFace    = UNKNOWN;
+    inline static u32 s_blending    = UNKNOWN;
+    inline static u32 s_blendSrc    = UNKNOWN;
+    inline static u32 s_blendDst    = UNKNOWN;
+    inline static u32 s_polygonMode = UNKNOWN;
+
+    inline static Counters s_counters{};
+    inline static Counters s_lastFrame{};
+
+public:
+    static void UseProgram(u32 program);
+    static void BindVertexArray(u32 vertexArray);
+    /**
+     * @brief Bind a texture to a texture unit
+     * @param unit texture unit index (not GL_TEXTURE0 based)
+     * @param target GL texture target (GL_TEXTURE_2D, ...)
+     */
+    static void BindTexture(u32 unit, u32 target, u32 texture);
+    /**
+     * @brief Bind a framebuffer for both draw and read (GL_FRAMEBUFFER)
+     */
+    static void BindFramebuffer(u32 framebuffer);
+
+    static void SetDepthTest(bool enabled);
+    static void SetDepthWrite(bool enabled);
+    static void SetDepthFunc(u32 func);
+    static void SetDepthClamp(bool enabled);
+    static void SetCulling(bool enabled);
+    static void SetCullFace(u32 face);
+    static void SetBlending(bool enabled);
+    static void SetBlendFunc(u32 src, u32 dst);
+    static void SetPolygonMode(u32 mode);
+
+    /**
+     * @brief Delete the objects and forget their cached bindings
+     * (names may be reused by the driver)
+     */
+    static void DeleteProgram(u32 program);
+    static void DeleteVertexArray(u32 vertexArray);
+    static void DeleteTexture(u32 texture);
+    static void DeleteFramebuffer(u32 framebuffer);
+
+    /**
+     * @brief Forget every cached state, the next calls will all be issued
+     */
+    static void Invalidate();
+    /**
+     * @brief Store the counters of the ending frame then reset them
+     */
+    static void NewFrame();
+
+    /**
+     * @brief Counters of the current frame
+     */
+    static const Counters &GetCounters();
+    /**
+     * @brief Counters of the last complete frame
+     */
+    static const Counters &GetLastFrameCounters();
+
+private:
+    static bool Changed(u32 &cached, u32 value);
+    static void SetCapability(u32 &cached, u32 capability, bool enabled);
+    static u32 TargetIndex(u32 target);
+};
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_GLSTATECACHE_HPP_
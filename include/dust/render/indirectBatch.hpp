@@ -0,0 +1,94 @@
+#ifndef _DUST_RENDER_INDIRECTBATCH_HPP_
+#define _DUST_RENDER_INDIRECTBATCH_HPP_
+
+#include "../core/types.hpp"
+#include "geometryArena.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "shader.hpp"
+
+#include <vector>
+
+namespace dust {
+namespace render {
+
+/** @brief Shader storage binding point of the per draw data (`DrawData` block) */
+constexpr u32 INDIRECT_DRAW_BINDING = 1;
+
+/**
+ * @brief `glMultiDrawElementsIndirect` command layout
+ */
+struct DrawElementsIndirectCommand {
+    u32 count;
+    u32 instanceCount;
+    u32 firstIndex;
+    i32 baseVertex;
+    u32 baseInstance;
+};
+
+/**
+ * @brief Per draw data (std430), fetched in the shader with `gl_DrawID`
+ */
+struct IndirectDrawData {
+    glm::mat4 transform;
+    /// index in the MaterialTable
+    u32 materialID;
+    u32 _padding[3];
+};
+
+/**
+ * @brief Merge the draws of ranges of one GeometryArena into a single
+ * `glMultiDrawElementsIndirect` call.
+ *
+ * Draws are sorted by material then by range, the commands and their per draw data
+ * are written once per submit, in the renderer StreamBuffer when they fit
+ * (its own buffers otherwise): the CPU cost does not depend on the number of meshes
+ * beyond filling the arrays.
+ */
+class IndirectBatch {
+private:
+    u32 m_commandBuffer;
+    u32 m_drawBuffer;
+    u32 m_capacity;
+
+    std::vector<DrawElementsIndirectCommand> m_commands;
+    std::vector<IndirectDrawData> m_draws;
+    // sort scratch
+    std::vector<u32> m_order;
+    std::vector<DrawElementsIndirectCommand> m_sortedCommands;
+    std::vector<IndirectDrawData> m_sortedDraws;
+
+public:
+    explicit IndirectBatch(u32 capacity = 1024);
+    ~IndirectBatch();
+
+    IndirectBatch(const IndirectBatch &)            = delete;
+    IndirectBatch &operator=(const IndirectBatch &) = delete;
+
+    /**
+     * @brief Add a draw of an arena range, one instance:
+     * the draw data is indexed by `gl_DrawID` only, instances would share its transform
+     */
+    void push(const GeometryRange &range, const glm::mat4 &transform, u32 materialID);
+
+    /**
+     * @brief Sort, upload and draw every pushed range in one call, then clear the batch
+     * @param arena arena of every pushed range
+     * @param shader shader reading the `DrawData` block with `gl_DrawID`
+     */
+    void submit(const GeometryArena &arena, const Shader *shader);
+    void clear();
+
+    u32 getDrawCount() const;
+
+private:
+    void sort();
+    void gather(DrawElementsIndirectCommand *commands, IndirectDrawData *draws) const;
+    void reserve(u32 capacity);
+};
+using IndirectBatchPtr  = Ref<IndirectBatch>;
+using IndirectBatchUPtr = Scope<IndirectBatch>;
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_INDIRECTBATCH_HPP_
@@ -0,0 +1,108 @@
+#ifndef _DUST_RENDER_INSTANCEDMESH_HPP_
+#define _DUST_RENDER_INSTANCEDMESH_HPP_
+
+#include "../core/types.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float4.hpp"
+#include "mesh.hpp"
+
+#include <vector>
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief First vertex attribute location of the instance stream:
+ * - `INSTANCE_ATTRIBUTE_LOCATION + 0..3` mat4 transform
+ * - `INSTANCE_ATTRIBUTE_LOCATION + 4` vec4 color
+ * - `INSTANCE_ATTRIBUTE_LOCATION + 5` uint material id
+ */
+constexpr u32 INSTANCE_ATTRIBUTE_LOCATION = 8;
+static_assert(INSTANCE_ATTRIBUTE_LOCATION >= DUST_MAX_VERTEX_ATTRIBUTES, "the instances overlap the vertex attributes");
+/** @brief Vertex buffer binding index of the instance stream */
+constexpr u32 INSTANCE_BUFFER_BINDING = 15;
+
+/**
+ * @brief Per instance attributes
+ */
+struct InstanceData {
+    glm::mat4 transform{1.f};
+    glm::vec4 color{1.f};
+    /// index in the MaterialTable (0 uses the mesh material)
+    u32 materialID{0};
+    u32 _padding[3]{};
+};
+
+/**
+ * @brief Per instance attribute stream (instanced vertex buffer)
+ */
+class InstanceBuffer {
+private:
+    u32 m_renderID;
+    u32 m_capacity;
+    std::vector<InstanceData> m_instances;
+    bool m_dirty;
+
+public:
+    explicit InstanceBuffer(u32 capacity = 64);
+    ~InstanceBuffer();
+
+    InstanceBuffer(const InstanceBuffer &)            = delete;
+    InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+
+    /**
+     * @brief Add an instance
+     * @return u32 index of the instance
+     */
+    u32 add(const InstanceData &instance);
+    void set(u32 index, const InstanceData &instance);
+    const InstanceData &get(u32 index) const;
+    void clear();
+
+    /**
+     * @brief Upload the instances if they changed, the buffer grows if needed
+     */
+    void upload();
+
+    /**
+     * @brief Attach the instance stream to a vertex array
+     * (attributes at INSTANCE_ATTRIBUTE_LOCATION, divisor 1)
+     */
+    void attach(u32 vertexArray) const;
+
+    u32 getCount() const;
+    u32 getCapacity() const;
+    u32 getRenderID() const;
+};
+using InstanceBufferPtr  = Ref<InstanceBuffer>;
+using InstanceBufferUPtr = Scope<InstanceBuffer>;
+
+/**
+ * @brief Draw many instances of a mesh in one draw call
+ * (`glDrawElementsInstanced`), the instance stream is attached to the mesh VAO.
+ * Several InstancedMesh can share a mesh: `draw` binds its own stream to the VAO.
+ */
+class InstancedMesh {
+private:
+    MeshPtr m_mesh;
+    InstanceBuffer m_instances;
+
+public:
+    explicit InstancedMesh(MeshPtr mesh, u32 capacity = 64);
+    ~InstancedMesh() = default;
+
+    InstanceBuffer &getInstances();
+    MeshPtr getMesh() const;
+
+    /**
+     * @brief Bind the mesh materials and draw every instance
+     */
+    void draw(const Shader *shader);
+};
+using InstancedMeshPtr  = Ref<InstancedMesh>;
+using InstancedMeshUPtr = Scope<InstancedMesh>;
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_INSTANCEDMESH_HPP_
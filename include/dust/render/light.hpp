@@ -4,12 +4,20 @@
 #include "dust/core/types.hpp"
 #include "dust/render/camera.hpp"
 #include "dust/render/framebuffer.hpp"
+#include "dust/render/uniformBuffer.hpp"
 #include "glm/ext/vector_float3.hpp"
 
 namespace dust {
 namespace render {
 
-class Shader;
+/**
+ * @brief Light kind, stored in `LightEntry::position.w`
+ */
+enum LightType : u32 {
+    LIGHT_DIRECTIONAL = 0,
+    LIGHT_POINT       = 1,
+    LIGHT_SPOT        = 2,
+};
 
 class Light {
 protected:
@@ -24,29 +32,105 @@ public:
     Light();
     virtual ~Light()                                         = default;
     virtual void updateRenderPos()                           = 0;
-    virtual void bind(ShaderPtr shader, u32 index = 0) const = 0;
+    /**
+     * @brief Get the light as stored in the `LightData` uniform block or in LightClusters
+     */
+    virtual LightEntry getLightEntry() const = 0;
+    [[nodiscard]] virtual LightType getType() const = 0;
 
     glm::mat4 getView() const;
     glm::mat4 getProj() const;
     glm::mat4 getViewProjMat(bool forceUpdate = false);
 };
 
+/**
+ * @brief Light from a direction (`m_direction` points to the light), its single shadow
+ * map covers the active camera up to the shadow distance (see CascadeShadowMap for cascades)
+ */
 class DirectionnalLight : public Light {
 protected:
     glm::vec3 m_direction;
     glm::vec3 m_color;
+    /// view distance covered by the shadow map
+    f32 m_shadowDistance;
+    /// shadow map size the projection is snapped to
+    u32 m_shadowResolution;
 
 public:
     DirectionnalLight(glm::vec3 direction, glm::vec3 color);
     virtual ~DirectionnalLight();
 
     void updateRenderPos() override;
-    virtual void bind(ShaderPtr shader, u32 index = 0) const override;
+    LightEntry getLightEntry() const override;
+    LightType getType() const override;
 
     glm::vec3 getDirection() const;
     glm::vec3 getColor() const;
     void setDirection(glm::vec3 direction);
     void setColor(glm::vec3 color);
+    /**
+     * @brief Part of the active camera view covered by the shadow map
+     * @param distance view distance, the camera far plane when 0
+     * @param resolution shadow map size
+     */
+    void setShadowRange(f32 distance, u32 resolution);
+};
+
+/**
+ * @brief Light from a position in every direction, it fades out to 0 at its range.
+ * Its projection is the -z face of its cube (point light shadows are not rendered)
+ */
+class PointLight : public Light {
+protected:
+    glm::vec3 m_position;
+    glm::vec3 m_color;
+    /// distance where the light stops
+    f32 m_range;
+
+public:
+    PointLight(glm::vec3 position, glm::vec3 color, f32 range);
+    virtual ~PointLight() = default;
+
+    void updateRenderPos() override;
+    LightEntry getLightEntry() const override;
+    LightType getType() const override;
+
+    glm::vec3 getPosition() const;
+    glm::vec3 getColor() const;
+    f32 getRange() const;
+    void setPosition(glm::vec3 position);
+    void setColor(glm::vec3 color);
+    void setRange(f32 range);
+};
+
+/**
+ * @brief Point light restricted to a cone, it fades out between its inner and outer angles
+ */
+class SpotLight : public PointLight {
+protected:
+    /// direction of the cone (from the light)
+    glm::vec3 m_direction;
+    /// half angles of the cone (radians)
+    f32 m_innerAngle;
+    f32 m_outerAngle;
+
+public:
+    SpotLight(glm::vec3 position, glm::vec3 direction, glm::vec3 color, f32 range, f32 innerAngle, f32 outerAngle);
+    virtual ~SpotLight() = default;
+
+    void updateRenderPos() override;
+    LightEntry getLightEntry() const override;
+    LightType getType() const override;
+
+    glm::vec3 getDirection() const;
+    f32 getInnerAngle() const;
+    f32 getOuterAngle() const;
+    void setDirection(glm::vec3 direction);
+    /**
+     * @param innerAngle half angle (radians) where the light starts to fade out
+     * @param outerAngle half angle (radians) where the light stops
+     */
+    void setAngles(f32 innerAngle, f32 outerAngle);
 };
 
 }  // namespace render
@@ -0,0 +1,172 @@
+#ifndef _DUST_RENDER_LIGHTCLUSTERS_HPP_
+#define _DUST_RENDER_LIGHTCLUSTERS_HPP_
+
+#include "../core/types.hpp"
+#include "../core/workerPool.hpp"
+#include "dust/render/uniformBuffer.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float4.hpp"
+
+#include <span>
+#include <vector>
+
+#ifndef DUST_CLUSTER_X
+/**
+ * @brief Clusters along the screen width, height and the view depth (16x9x24 froxels),
+ * the width must be a multiple of 4
+ */
+#define DUST_CLUSTER_X 16
+#define DUST_CLUSTER_Y 9
+#define DUST_CLUSTER_Z 24
+#endif
+#ifndef DUST_CLUSTER_THREADS
+/// worker threads used besides the calling thread
+#define DUST_CLUSTER_THREADS 3
+#endif
+
+namespace dust {
+namespace render {
+
+class Camera;
+class Light;
+
+/** @brief Shader storage binding point of the clustered lights (`LightList` block) */
+constexpr u32 LIGHT_LIST_BINDING = 2;
+/** @brief Shader storage binding point of the first index and light count of every cluster (`ClusterGrid` block) */
+constexpr u32 CLUSTER_GRID_BINDING = 3;
+/** @brief Shader storage binding point of the light indices of the clusters (`ClusterIndices` block) */
+constexpr u32 CLUSTER_INDEX_BINDING = 4;
+
+/**
+ * @brief Clustered forward lighting: the local (point and spot) lights are assigned
+ * to the froxels of the view frustum, a fragment only shades the lights of its cluster.
+ *
+ * The froxels tile the screen and slice the view depth exponentially between the camera
+ * near and far planes. Every frame: `clear`, `push` the lights, `build` the clusters
+ * (the light bounding spheres are tested against 4 froxels at a time (SSE), one depth
+ * slice per task on the worker threads), then `upload` them to the renderer stream buffer
+ * and set the `ClusterData` block with Renderer::setClusterData.
+ * Directional lights reach every cluster and stay in the `LightData` block.
+ */
+class LightClusters {
+public:
+    static constexpr u32 SIZE_X = DUST_CLUSTER_X;
+    static constexpr u32 SIZE_Y = DUST_CLUSTER_Y;
+    static constexpr u32 SIZE_Z = DUST_CLUSTER_Z;
+    static constexpr u32 COUNT  = SIZE_X * SIZE_Y * SIZE_Z;
+    static_assert(SIZE_X % 4 == 0, "the clusters of a row are tested 4 at a time");
+    static_assert(SIZE_X <= 32, "the clusters of a row touched by a light are stored in a u32 mask");
+
+    struct Stats {
+        /// local lights pushed
+        u32 lights;
+        /// lights inside the view frustum
+        u32 visible;
+        /// light indices of every cluster
+        u32 indices;
+        /// most lights in one cluster
+        u32 maxPerCluster;
+    };
+
+private:
+    WorkerPool m_workers;
+
+    std::vector<LightEntry> m_lights;
+    /// view space bounding sphere of every light (w: radius, negative when culled)
+    std::vector<glm::vec4> m_spheres;
+
+    // view space bounds of the froxels (SoA), rebuilt when the projection changes
+    std::vector<f32> m_minX, m_minY, m_minZ;
+    std::vector<f32> m_maxX, m_maxY, m_maxZ;
+    glm::mat4 m_proj;
+    f32 m_near;
+    f32 m_far;
+
+    /// lights overlapping each depth slice
+    std::vector<std::vector<u32>> m_sliceLights;
+    /// clusters of each row touched by the lights of each depth slice (a bit per cluster)
+    std::vector<std::vector<u32>> m_sliceMasks;
+    /// light indices of each depth slice, grouped by cluster
+    std::vector<std::vector<u32>> m_sliceIndices;
+    /// x: first index, y: light count of every cluster
+    std::vector<u32> m_grid;
+    std::vector<u32> m_indices;
+
+    // fallback storage when the stream buffer is full
+    u32 m_lightBuffer, m_lightCapacity;
+    u32 m_gridBuffer, m_gridCapacity;
+    u32 m_indexBuffer, m_indexCapacity;
+
+    ClusterData m_data;
+    Stats m_stats;
+
+public:
+    explicit LightClusters(u32 threadCount = DUST_CLUSTER_THREADS);
+    ~LightClusters();
+
+    LightClusters(const LightClusters &)            = delete;
+    LightClusters &operator=(const LightClusters &) = delete;
+
+    /**
+     * @brief Remove every light
+     */
+    void clear();
+    /**
+     * @brief Add a local light, directional lights are ignored
+     * @return index of the light in the `LightList` block
+     */
+    u32 push(const Light &light);
+    u32 push(const LightEntry &light);
+
+    /**
+     * @brief Assign the lights to the clusters of the camera view
+     */
+    void build(const Camera &camera);
+    /**
+     * @brief Upload the lights and the clusters and bind their shader storage blocks
+     */
+    void upload();
+
+    /**
+     * @brief `ClusterData` block of the last build, for the shaders reading the clusters
+     */
+    [[nodiscard]] ClusterData getClusterData() const;
+    /**
+     * @brief Indices of the lights of a cluster after the last build
+     */
+    [[nodiscard]] std::span<const u32> getClusterLights(u32 x, u32 y, u32 z) const;
+    [[nodiscard]] std::span<const LightEntry> getLights() const;
+    [[nodiscard]] const Stats &getStats() const;
+
+    /** @brief Index of a cluster in the `ClusterGrid` block */
+    static constexpr u32 Index(u32 x, u32 y, u32 z) { return (z * SIZE_Y + y) * SIZE_X + x; }
+    /**
+     * @brief Depth slice of a view depth, with the slice scale and bias of ClusterData::depth
+     */
+    static u32 Slice(f32 depth, f32 scale, f32 bias);
+    /**
+     * @brief World space bounding sphere of a local light (w: radius)
+     */
+    static glm::vec4 BoundingSphere(const LightEntry &light);
+
+private:
+    /**
+     * @brief View space bounds of the froxels of a projection
+     */
+    void buildFroxels(const glm::mat4 &proj, f32 near, f32 far);
+    /**
+     * @brief Assign the lights of a depth slice to its clusters
+     */
+    void buildSlice(u32 slice);
+    /**
+     * @brief Upload to a fallback buffer, it grows if needed
+     */
+    void uploadBuffer(u32 &buffer, u32 &capacity, u32 binding, const void *data, u32 size);
+};
+using LightClustersPtr  = Ref<LightClusters>;
+using LightClustersUPtr = Scope<LightClusters>;
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_LIGHTCLUSTERS_HPP_
@@ -0,0 +1,101 @@
+#ifndef _DUST_RENDER_LOD_HPP_
+#define _DUST_RENDER_LOD_HPP_
+
+#include "../core/types.hpp"
+#include "culling.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float3.hpp"
+
+#include <span>
+#include <vector>
+
+/// levels of detail per mesh, including the full resolution one
+#define DUST_LOD_COUNT 4
+/// meshes with fewer triangles are not simplified
+#define DUST_LOD_MIN_TRIANGLES 256
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief Level of detail of a mesh: a range of its index buffer
+ */
+struct MeshLOD {
+    /// first index, relative to the first element of the mesh
+    u32 firstIndex;
+    u32 indexCount;
+    /// local space geometric error (distance) compared to the full resolution
+    f32 error;
+};
+
+/**
+ * @brief Quadric error metric simplification (Garland-Heckbert) by half edge collapses.
+ *
+ * Collapsed vertices move onto an existing vertex, so the kept vertices keep their attributes.
+ * Vertices on attribute seams (several vertices at the same position, e.g. UV or normal
+ * discontinuities) and on mesh borders are never collapsed.
+ */
+class MeshSimplifier {
+public:
+    /**
+     * @brief Simplify triangles down to about `targetIndexCount` indices
+     * @param error largest geometric error of the collapses (distance)
+     * @return simplified indices, using the same vertices
+     */
+    static std::vector<u32> Simplify(std::span<const glm::vec3> positions, std::span<const u32> indices,
+                                     u32 targetIndexCount, f32 &error);
+    /**
+     * @brief Append the simplified levels of `indices` to it, each level has about half the
+     * triangles of the previous one; stops early when the mesh cannot be simplified further
+     * @return levels of detail, the first one is `indices` itself
+     */
+    static std::vector<MeshLOD> BuildLODs(std::span<const glm::vec3> positions, std::vector<u32> &indices,
+                                          u32 lodCount = DUST_LOD_COUNT);
+};
+
+/**
+ * @brief Select levels of detail from their projected screen space error.
+ *
+ * The coarsest level whose error stays under the max error (in pixels) is used,
+ * with hysteresis around it to avoid popping back and forth.
+ */
+class LODSelector {
+private:
+    glm::vec3 m_viewPosition;
+    /// pixels per world unit at a distance of 1, 0 disables the selection
+    f32 m_projectionScale;
+    f32 m_maxError;
+    f32 m_hysteresis;
+
+public:
+    LODSelector();
+
+    void setViewPosition(glm::vec3 position);
+    /**
+     * @param projectionScale see ProjectionScale, 0 always selects the full resolution
+     * @param maxError max screen space error in pixels
+     * @param hysteresis fraction of the max error to cross before changing level
+     */
+    void setProjection(f32 projectionScale, f32 maxError = 1.f, f32 hysteresis = .25f);
+    [[nodiscard]] bool isEnabled() const;
+
+    /**
+     * @brief Error in pixels of a level drawn with `model` (local space `bounds`)
+     */
+    [[nodiscard]] f32 getScreenError(const MeshLOD &lod, const glm::mat4 &model, const AABB &bounds) const;
+    /**
+     * @param previous level selected the previous frame
+     */
+    [[nodiscard]] u32 select(std::span<const MeshLOD> lods, const glm::mat4 &model, const AABB &bounds,
+                             u32 previous) const;
+
+    /**
+     * @brief Pixels per world unit at a distance of 1 of a perspective projection
+     */
+    static f32 ProjectionScale(const glm::mat4 &proj, f32 viewportHeight);
+};
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_LOD_HPP_
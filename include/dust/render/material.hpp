@@ -4,6 +4,7 @@
 #include "../core/types.hpp"
 #include "glm/ext/vector_float3.hpp"
 #include "glm/ext/vector_float4.hpp"
+#include "materialTable.hpp"
 #include "shader.hpp"
 #include "texture.hpp"
 
@@ -19,10 +20,15 @@ constexpr u32 MAX_MATERIAL_TEXTURE_COUNT = 5;
  */
 class Material {
 protected:
+    u32 m_id;
     u32 m_boundSlot;
     std::string m_name;
+    bool m_transparent;
+    // parameters changed since the last record upload
+    bool m_dirty;
 
     inline static Shader *s_shader = nullptr;
+    inline static u32 s_nextID     = 1;
 
 public:
     Material();
@@ -33,6 +39,31 @@ public:
 
     void setName(const std::string &name);
     std::string getName() const;
+
+    /** @brief Unique id of the material (never 0) */
+    u32 getID() const;
+
+    /** @brief Transparent materials are drawn after the opaque ones, back to front */
+    void setTransparent(bool transparent);
+    bool isTransparent() const;
+
+    /**
+     * @brief Flag the material parameters as changed,
+     * its record is uploaded to the MaterialTable on its next bind
+     */
+    void markDirty();
+    /**
+     * @brief Upload the record to the MaterialTable without binding the material,
+     * for draws reading the table directly (see IndirectBatch)
+     */
+    void upload();
+
+protected:
+    /**
+     * @brief Upload the material record if it changed or its slot changed
+     */
+    void updateRecord(u32 slot);
+    virtual MaterialRecord getRecord() const = 0;
 };
 using MaterialPtr  = Ref<Material>;
 using MaterialUPtr = Scope<Material>;
@@ -49,6 +80,9 @@ public:
     void bind(u32 slot = 0) override;
     void unbind() override;
     static void SetupMaterialShader(Shader *shader);
+
+protected:
+    MaterialRecord getRecord() const override;
 };
 
 class TextureMaterial : public Material {
@@ -62,26 +96,25 @@ public:
     void bind(u32 slot = 0) override;
     void unbind() override;
     static void SetupMaterialShader(Shader *shader);
+
+protected:
+    MaterialRecord getRecord() const override;
 };
 
 class PBRMaterial : public Material {
 public:
-    // Data
-    // glm::vec3 albedo;
-    // f32 roughness;
-    // TexturePtr albedoTexture;
-    // TexturePtr normalTexture;
-
     glm::vec3 albedo;
     f32 metallic;
     f32 roughness;
     f32 ao;
 
-    TexturePtr albedoTexture;
-    TexturePtr normalTexture;
-    TexturePtr metallicTexture;
-    TexturePtr roughnessTexture;
-    TexturePtr aoTexture;
+    // layers of the MaterialTable texture arrays
+    TextureLayer albedoTexture;
+    TextureLayer normalTexture;
+    /// r: ambient occlusion, g: roughness, b: metallic
+    TextureLayer ormTexture;
+    /// texture arrays of the layers, their MaterialTable slot is released with the last material using them
+    std::vector<TexturePtr> textureArrays;
 
 public:
     PBRMaterial();
@@ -90,6 +123,9 @@ public:
     void bind(u32 slot = 0) override;
     void unbind() override;
     static void SetupMaterialShader(Shader *shader);
+
+protected:
+    MaterialRecord getRecord() const override;
 };
 
 }  // namespace render
@@ -0,0 +1,137 @@
+#ifndef _DUST_RENDER_MATERIALTABLE_HPP_
+#define _DUST_RENDER_MATERIALTABLE_HPP_
+
+#include "../core/types.hpp"
+#include "glm/ext/vector_float4.hpp"
+#include "texture.hpp"
+
+#include <vector>
+
+namespace dust {
+namespace render {
+
+/** @brief Shader storage binding point of the material table */
+constexpr u32 MATERIAL_TABLE_BINDING = 0;
+
+/** @brief Max number of texture arrays shared by the materials */
+constexpr u32 MAX_TEXTURE_ARRAYS = 8;
+/** @brief First texture unit of the texture arrays (`uTextureArrays[i]` is bound to unit `TEXTURE_ARRAY_UNIT + i`) */
+constexpr u32 TEXTURE_ARRAY_UNIT = 16;
+/** @brief Packed texture reference of a material without this texture */
+constexpr u32 NO_TEXTURE_LAYER = 0xFFFFFFFF;
+
+/** @brief Material texture kinds, index of MaterialRecord::textures */
+enum MaterialTextureKind : u32 {
+    TEXTURE_ALBEDO = 0,
+    TEXTURE_NORMAL,
+    /// r: ambient occlusion, g: roughness, b: metallic (glTF layout)
+    TEXTURE_ORM,
+    TEXTURE_KIND_COUNT
+};
+
+/**
+ * @brief Layer of a texture array registered in the MaterialTable
+ */
+struct TextureLayer {
+    u32 array{NO_TEXTURE_LAYER};
+    u32 layer{0};
+
+    bool isValid() const { return array != NO_TEXTURE_LAYER; }
+    /** @brief Packed reference stored in the material record (array << 16 | layer) */
+    u32 pack() const { return isValid() ? (array << 16) | (layer & 0xFFFF) : NO_TEXTURE_LAYER; }
+};
+
+/**
+ * @brief Material flags stored in MaterialRecord::flags
+ */
+enum MaterialFlags : u32 {
+    MATERIAL_EXIST       = 1 << 0,
+    MATERIAL_TEXTURED    = 1 << 1,
+    MATERIAL_TRANSPARENT = 1 << 2,
+    /// textures are sampled from the texture arrays (MaterialRecord::textures)
+    MATERIAL_TEXTURE_ARRAYS = 1 << 3,
+};
+
+/**
+ * @brief Packed material parameters (std430), one per material
+ */
+struct MaterialRecord {
+    /// rgb: albedo/diffuse color, a: opacity
+    glm::vec4 albedo;
+    /// x: metallic, y: roughness, z: ambient occlusion
+    glm::vec4 params;
+    /// MaterialFlags
+    u32 flags;
+    /// Material slot whose texture units hold the material textures
+    u32 textureSlot;
+    /// Packed texture array layers (see TextureLayer::pack), indexed by MaterialTextureKind
+    u32 textures[TEXTURE_KIND_COUNT];
+    u32 _padding[3];
+};
+
+/**
+ * @brief GPU resident table of every material parameters (shader storage buffer),
+ * indexed by Material::getID(). The record 0 is kept empty for meshes without material.
+ *
+ * Records are uploaded when they change only, binding a material then costs
+ * no uniform call.
+ */
+class MaterialTable {
+private:
+    u32 m_renderID;
+    u32 m_capacity;
+    std::vector<MaterialRecord> m_records;
+    std::vector<TexturePtr> m_textureArrays;
+
+    u32 m_uploadCount;
+
+    inline static MaterialTable *s_instance = nullptr;
+
+public:
+    explicit MaterialTable(u32 capacity = 256);
+    ~MaterialTable();
+
+    MaterialTable(const MaterialTable &)            = delete;
+    MaterialTable &operator=(const MaterialTable &) = delete;
+
+    /**
+     * @brief Write a record, the table grows if needed.
+     * Nothing is uploaded if the record did not change.
+     */
+    void update(u32 index, const MaterialRecord &record);
+
+    /**
+     * @brief Bind the table to its shader storage binding point
+     */
+    void bind() const;
+
+    /**
+     * @brief Register a texture array shared by the materials.
+     * The materials sampling it own it (PBRMaterial::textureArrays): the slots of the arrays
+     * no material owns anymore (destroyed models) are released and reused here.
+     * @return u32 index of the array, NO_TEXTURE_LAYER if there is no room left
+     */
+    u32 addTextureArray(TexturePtr textureArray);
+    /**
+     * @brief Bind the texture arrays to their units,
+     * only the first bind of a frame reaches the driver (GLStateCache)
+     */
+    void bindTextureArrays() const;
+    [[nodiscard]] TexturePtr getTextureArray(u32 index) const;
+
+    [[nodiscard]] u32 getCapacity() const;
+    /** @brief Number of record uploads since the table creation */
+    [[nodiscard]] u32 getUploadCount() const;
+
+    static MaterialTable *Get();
+
+private:
+    void grow(u32 capacity);
+};
+using MaterialTablePtr  = Ref<MaterialTable>;
+using MaterialTableUPtr = Scope<MaterialTable>;
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_MATERIALTABLE_HPP_
@@ -2,11 +2,17 @@
 #define _DUST_RENDER_MESH_HPP_
 
 #include <array>
+#include <span>
 #include <vector>
 
 #include "../core/types.hpp"
+#include "../render/culling.hpp"
+#include "../render/lod.hpp"
 #include "../render/material.hpp"
+#include "../render/meshlet.hpp"
 #include "../render/shader.hpp"
+#include "../render/vertexLayout.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
 #include "glm/ext/vector_float2.hpp"
 #include "glm/ext/vector_float3.hpp"
 
@@ -17,20 +23,36 @@
 #define DUST_MATERIAL_SLOTS 6
 #endif
 
+#ifndef DUST_POSITION_STREAMS
+/**
+ * @brief Give the imported meshes a welded position stream for the depth only passes
+ */
+#define DUST_POSITION_STREAMS 1
+#endif
+
 namespace dust {
 namespace render {
 
+/**
+ * @brief Vertex attribute of a layout built at runtime, prefer a VertexLayout known at compile time
+ */
 class Attribute {
 private:
     u32 m_count;
     u32 m_size;
     u32 m_glType;
-    Attribute(u32 count, u32 size, u32 glType);
+    /// fixed point values mapped to [0, 1] (unsigned) or [-1, 1] (signed)
+    bool m_normalized;
+    /// read as integers by the shader (`int`, `uint`, `ivecN`, ...) instead of floats
+    bool m_integer;
+    Attribute(u32 count, u32 size, u32 glType, bool normalized = false, bool integer = false);
 
 public:
     u32 getSize() const;
     u32 getCount() const;
     u32 getGLType() const;
+    bool isNormalized() const;
+    bool isInteger() const;
 
     static Attribute Float;
     static Attribute Float2;
@@ -40,6 +62,28 @@ public:
     static Attribute Pos3D;
     static Attribute Float4;
     static Attribute Color;
+
+    static Attribute Half2;
+    static Attribute Short2Norm;
+    static Attribute UShort4Norm;
+    /// bytes converted to floats (0 to 255)
+    static Attribute UByte4;
+    static Attribute UByte4Norm;
+    static Attribute Int;
+    static Attribute UInt;
+    /// no data, the location is skipped and its shader input reads (0, 0, 0, 1)
+    static Attribute Unused;
+};
+
+/**
+ * @brief VertexFormat of interleaved runtime attributes at the locations 0, 1, ...
+ */
+struct AttributeFormat {
+    std::vector<VertexAttribute> attributes;
+    u32 stride;
+
+    explicit AttributeFormat(const std::vector<Attribute> &attributes);
+    operator VertexFormat() const;
 };
 
 class Mesh {
@@ -48,12 +92,30 @@ protected:
 
     u32 m_vbo;
     u32 m_ebo;
+    /// position only stream (VAO, positions, position welded indices), 0 when the mesh has none
+    u32 m_positionRenderID;
+    u32 m_positionVbo;
+    u32 m_positionEbo;
 
     u32 m_indexCount;
+    /// GL_UNSIGNED_SHORT for meshes with less than 65536 vertices, GL_UNSIGNED_INT otherwise
+    u32 m_indexType;
     u32 m_vertexCount;
+    /// first index (or vertex without indices) drawn
+    u32 m_firstElement;
 
     std::array<MaterialPtr, DUST_MATERIAL_SLOTS> m_materialSlots;
     std::string m_name;
+    /// local space bounds, invalid (never culled) when unknown
+    AABB m_bounds;
+    /// coarse local space triangles used as occluder, empty when it does not occlude
+    std::vector<glm::vec3> m_occluder;
+    /// clusters of the index buffer, empty when the mesh is drawn as a whole
+    std::vector<Meshlet> m_meshlets;
+    /// levels of detail in the index buffer, empty when there is only the full resolution
+    std::vector<MeshLOD> m_lods;
+    /// from the quantized vertex positions to the local space, identity when they are not quantized
+    glm::mat4 m_dequantization;
 
     bool m_hidden;
 
@@ -63,7 +125,11 @@ public:
     Mesh(void *vertexData, u32 vertexDataSize, u32 vertexCount, std::vector<Attribute> attributes);
     Mesh(void *vertexData, u32 vertexDataSize, u32 vertexCount, std::vector<u32> indices,
          std::vector<Attribute> attributes);
-    ~Mesh();
+    /**
+     * @param format layout of the vertices, usually `VertexLayout<...>::Format()`
+     */
+    Mesh(const void *vertexData, u32 vertexCount, const VertexFormat &format, std::vector<u32> indices = {});
+    virtual ~Mesh();
 
     void setName(const std::string &name);
     std::string getName() const;
@@ -71,11 +137,88 @@ public:
     void setHidden(bool hide);
     bool isHidden() const;
 
+    void setBounds(const AABB &bounds);
+    const AABB &getBounds() const;
+
+    /** @brief Occluder triangles (3 points per triangle), see OcclusionCuller */
+    void setOccluder(std::vector<glm::vec3> triangles);
+    const std::vector<glm::vec3> &getOccluder() const;
+
+    /** @brief Meshlets of the index buffer (see Meshlet::Build), culled by the RenderQueue */
+    void setMeshlets(std::vector<Meshlet> meshlets);
+    const std::vector<Meshlet> &getMeshlets() const;
+
+    /**
+     * @brief Levels of detail stored after the full resolution in the index buffer
+     * (see MeshSimplifier::BuildLODs), the mesh alone draws the first one
+     */
+    void setLODs(std::vector<MeshLOD> lods);
+    const std::vector<MeshLOD> &getLODs() const;
+
+    /**
+     * @brief Transform of the quantized vertex positions (see VertexPacking) to the local space,
+     * folded into the model matrix by Model::draw and the RenderQueue
+     */
+    void setDequantization(const glm::mat4 &dequantization);
+    const glm::mat4 &getDequantization() const;
+    bool isQuantized() const;
+    /**
+     * @param model model matrix of the mesh
+     * @return model matrix of the vertex positions
+     */
+    glm::mat4 getVertexTransform(const glm::mat4 &model) const;
+
+    /**
+     * @brief Tightly packed positions drawn instead of the vertices by the position only
+     * shaders (depth, shadows, see Shader::isPositionOnly)
+     * @param format position layout at location 0, transformed by the same dequantization
+     * @param indices the mesh indices remapped to the positions (same count and order so that the
+     * meshlet and LOD ranges still apply), empty when the mesh has no indices
+     */
+    void setPositionStream(const void *positions, u32 positionCount, const VertexFormat &format,
+                           std::span<const u32> indices);
+    bool hasPositionStream() const;
+    /**
+     * @brief VAO to draw the mesh with a shader: the position stream for the position only ones
+     */
+    u32 getVertexArray(const Shader *shader) const;
+
     void setMaterial(u32 index, MaterialPtr material);
     MaterialPtr getMaterial(u32 index) const;
     void draw(const Shader *shader);
 
-    std::array<MaterialPtr, DUST_MATERIAL_SLOTS> getMaterials() const;
+    /**
+     * @brief Bind only the slots that differ from the previously bound mesh
+     * @param previous mesh whose materials are currently bound (can be null)
+     * @return true if at least one slot changed
+     */
+    bool bindMaterials(const Mesh *previous = nullptr);
+    void unbindMaterials();
+    /**
+     * @brief Issue the draw call only, the VAO must already be bound
+     */
+    void drawGeometry() const;
+    /**
+     * @brief Issue an instanced draw call only, the VAO must already be bound
+     */
+    void drawGeometryInstanced(u32 instanceCount) const;
+    /**
+     * @brief Issue one multi draw call of index ranges only, the VAO must already be bound
+     * @param offsets byte offsets in the index buffer
+     */
+    void drawGeometryRanges(const i32 *counts, const void *const *offsets, u32 rangeCount) const;
+
+    const std::array<MaterialPtr, DUST_MATERIAL_SLOTS> &getMaterials() const;
+    /** @brief Id of the first bound material (0 if none), used to sort draws */
+    u32 getMaterialKey() const;
+    /** @brief If any of its materials needs blending */
+    bool isTransparent() const;
+
+    u32 getRenderID() const;
+    u32 getFirstElement() const;
+    /** @brief Size in bytes of an index (offsets in the index buffer) */
+    u32 getIndexSize() const;
+    u32 getTriangleCount() const;
 
     // Meshes
     static Ref<Mesh> createPlane(glm::vec2 size = glm::vec2(1.f),
@@ -84,7 +227,16 @@ public:
                                 bool requestTextureCoordinates = false);
 
 protected:
-    void bindAttributes(const std::vector<Attribute> &attributes);
+    /**
+     * @brief Empty mesh, the derived class creates the GL objects
+     */
+    Mesh();
+    Mesh(const void *vertexData, u32 vertexDataSize, u32 vertexCount, std::vector<u32> indices,
+         const VertexFormat &format);
+    /**
+     * @brief Set the vertex format of the VAO, reading the VBO
+     */
+    void bindFormat(const VertexFormat &format);
 };
 using MeshPtr = Ref<Mesh>;
 using MeshUPtr = Scope<Mesh>;
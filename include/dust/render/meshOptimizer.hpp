@@ -0,0 +1,84 @@
+#ifndef _DUST_RENDER_MESHOPTIMIZER_HPP_
+#define _DUST_RENDER_MESHOPTIMIZER_HPP_
+
+#include "../core/types.hpp"
+#include "glm/ext/vector_float3.hpp"
+#include "meshlet.hpp"
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+/// post transform cache size the index buffers are optimized for
+#define DUST_VERTEX_CACHE_SIZE 16
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief Post transform cache efficiency of an index buffer (FIFO cache simulation)
+ */
+struct VertexCacheStats {
+    /// average cache miss ratio: transformed vertices per triangle (0.5 at best, 3 at worst)
+    f32 acmr;
+    /// average transform to vertex ratio: transformed vertices per referenced vertex (1 at best)
+    f32 atvr;
+};
+
+/**
+ * @brief Index and vertex buffers reordering for the GPU:
+ * post transform cache (Tipsify), overdraw (meshlets sorted outside in)
+ * and vertex fetch locality (vertices in first use order).
+ */
+class MeshOptimizer {
+public:
+    /**
+     * @brief Reorder the triangles for the post transform cache (Tipsify, Sander et al. 2007)
+     */
+    static void OptimizeVertexCache(std::span<u32> indices, u32 cacheSize = DUST_VERTEX_CACHE_SIZE);
+    /**
+     * @brief Reorder the meshlets (and their triangles) so that the ones facing outward,
+     * likely to occlude the others, are drawn first (Sander et al. 2007, with meshlets as clusters)
+     * @param indices indices covered by the meshlets
+     */
+    static void OptimizeOverdraw(std::span<const glm::vec3> positions, std::vector<u32> &indices,
+                                 std::vector<Meshlet> &meshlets);
+    /**
+     * @brief Renumber the vertices in their first use order, unused vertices are dropped
+     * @return new index of every vertex (`NO_VERTEX` if unused)
+     */
+    static std::vector<u32> OptimizeVertexFetch(std::span<u32> indices, u32 vertexCount);
+    /**
+     * @brief Merge the vertices sharing the same position (bitwise), for position only streams
+     * where the seams of the other attributes would only split the vertex cache
+     * @param positionCount unique positions
+     * @return unique position index of every vertex, in first occurrence order
+     */
+    static std::vector<u32> WeldPositions(std::span<const glm::vec3> positions, u32 &positionCount);
+
+    [[nodiscard]] static VertexCacheStats AnalyzeVertexCache(std::span<const u32> indices, u32 vertexCount,
+                                                             u32 cacheSize = DUST_VERTEX_CACHE_SIZE);
+
+    /**
+     * @brief Apply a vertex remap (see OptimizeVertexFetch) to the vertices
+     */
+    template <typename Vertex>
+    static void RemapVertices(std::vector<Vertex> &vertices, std::span<const u32> remap) {
+        u32 count = 0;
+        for (const u32 index : remap) {
+            if (index != NO_VERTEX) count = std::max(count, index + 1);
+        }
+        std::vector<Vertex> remapped(count);
+        for (u32 v = 0; v < vertices.size(); ++v) {
+            if (remap[v] != NO_VERTEX) remapped[remap[v]] = vertices[v];
+        }
+        vertices = std::move(remapped);
+    }
+
+    static constexpr u32 NO_VERTEX = 0xFFFFFFFF;
+};
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_MESHOPTIMIZER_HPP_
@@ -0,0 +1,75 @@
+#ifndef _DUST_RENDER_MESHLET_HPP_
+#define _DUST_RENDER_MESHLET_HPP_
+
+#include "../core/types.hpp"
+#include "culling.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float3.hpp"
+#include "glm/ext/vector_float4.hpp"
+
+#include <array>
+#include <span>
+#include <vector>
+
+/// meshlet limits (the usual mesh shader sizes)
+#define DUST_MESHLET_MAX_VERTICES 64
+#define DUST_MESHLET_MAX_TRIANGLES 124
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief Cluster of nearby triangles stored contiguously in its mesh index buffer,
+ * with the bounds used to cull it as a whole
+ */
+struct Meshlet {
+    /// local space bounding sphere
+    glm::vec3 center;
+    f32 radius;
+    /// normal cone: every triangle normal is within it, a cutoff of 1 is never culled
+    glm::vec3 coneAxis;
+    f32 coneCutoff;
+    /// first index, relative to the first element of the mesh
+    u32 firstIndex;
+    u32 indexCount;
+
+    /**
+     * @brief Split triangles into meshlets: greedily grow each meshlet with the
+     * connected triangles adding the fewest vertices, the indices are reordered
+     * so that every meshlet is a contiguous range
+     */
+    static std::vector<Meshlet> Build(std::span<const glm::vec3> positions, std::vector<u32> &indices,
+                                      u32 maxVertices  = DUST_MESHLET_MAX_VERTICES,
+                                      u32 maxTriangles = DUST_MESHLET_MAX_TRIANGLES);
+};
+
+/**
+ * @brief Culls the meshlets of one draw against a frustum and their normal cone.
+ *
+ * The frustum and view position are moved to the mesh local space once per draw.
+ * The cone test expects back faces to be culled (the renderer default), it is
+ * skipped for transforms that mirror or do not scale uniformly.
+ */
+class MeshletCuller {
+private:
+    std::array<glm::vec4, Frustum::PLANE_COUNT> m_planes;
+    /// largest scale of the transform, local to world radius
+    f32 m_radiusScale;
+    glm::vec3 m_viewPosition;
+    bool m_frustumCulling;
+    bool m_coneCulling;
+
+public:
+    /**
+     * @param frustum world frustum, null to only cull backfacing meshlets
+     * @param viewPosition world view position
+     */
+    MeshletCuller(const glm::mat4 &model, const Frustum *frustum, glm::vec3 viewPosition);
+
+    [[nodiscard]] bool isVisible(const Meshlet &meshlet) const;
+};
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_MESHLET_HPP_
@@ -2,7 +2,11 @@
 #define _DUST_RENDER_MODEL_HPP_
 
 #include "../render/mesh.hpp"
+#include "../render/renderQueue.hpp"
 #include "../render/shader.hpp"
+#include "../render/vertexLayout.hpp"
+
+#include <cstddef>
 
 namespace dust {
 namespace render {
@@ -11,17 +15,30 @@ struct ModelVertex {
     glm::vec3 pos;
     glm::vec2 tex;
     glm::vec3 normal;
-    glm::vec3 tangent;
+    /// w: handedness of the tangent space, the bitangent is `cross(normal, tangent) * w`
+    glm::vec4 tangent;
     glm::vec4 color;
     float materialID;
 };
 
+using ModelVertexLayout = VertexLayout<Position3f, TexCoord2f, Normal3f, Tangent4f, Color4f, MaterialID1f>;
+static_assert(ModelVertexLayout::Describes<ModelVertex>());
+static_assert(ModelVertexLayout::OffsetOf<TexCoord2f>() == offsetof(ModelVertex, tex));
+static_assert(ModelVertexLayout::OffsetOf<Normal3f>() == offsetof(ModelVertex, normal));
+static_assert(ModelVertexLayout::OffsetOf<Tangent4f>() == offsetof(ModelVertex, tangent));
+static_assert(ModelVertexLayout::OffsetOf<Color4f>() == offsetof(ModelVertex, color));
+static_assert(ModelVertexLayout::OffsetOf<MaterialID1f>() == offsetof(ModelVertex, materialID));
+
 class Model {
 private:
     std::vector<MeshPtr> m_meshes;
+    /// level of detail last selected for each mesh
+    std::vector<u8> m_lods;
     glm::mat4 m_modelMat;
 
     glm::vec3 m_position;
+    /// moved since the last `setDirty(false)`, cached draws (shadow maps) are stale
+    bool m_dirty;
 
 public:
     Model(const std::vector<MeshPtr> &mesh);
@@ -31,8 +48,16 @@ public:
     void setPosition(glm::vec3 position);
     glm::vec3 getPosition() const;
     std::vector<MeshPtr> getMeshes() const;
+    glm::mat4 getModelMatrix() const;
+    u32 getMeshLOD(u32 mesh) const;
+    [[nodiscard]] bool isDirty() const;
+    void setDirty(bool dirty);
 
     void draw(Shader *shader);
+    /**
+     * @brief Queue the model meshes instead of drawing them immediately
+     */
+    void submit(RenderQueue &queue, Shader *shader, u8 pass = 0);
 };
 
 using ModelPtr  = Ref<Model>;
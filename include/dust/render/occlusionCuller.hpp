@@ -0,0 +1,112 @@
+#ifndef _DUST_RENDER_OCCLUSIONCULLER_HPP_
+#define _DUST_RENDER_OCCLUSIONCULLER_HPP_
+
+#include "../core/types.hpp"
+#include "../core/workerPool.hpp"
+#include "culling.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float3.hpp"
+
+#include <span>
+#include <vector>
+
+/// resolution of the software depth buffer (width must be a multiple of 4)
+#define DUST_OCCLUSION_WIDTH 256
+#define DUST_OCCLUSION_HEIGHT 128
+/// worker threads used besides the calling thread
+#define DUST_OCCLUSION_THREADS 3
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief CPU occlusion culling against a software rasterized depth buffer.
+ *
+ * Every frame: `begin` with the view projection, add the occluders triangles
+ * (coarse meshes, see Mesh::getOccluder), `rasterize` them into a low resolution
+ * depth buffer and its hierarchical max depth pyramid, then test boxes with `cull`.
+ * Occluders are rasterized conservatively: only the pixels they fully cover are written.
+ * Rasterization (by horizontal bands) and box tests run on worker threads.
+ * It does not use the GPU: it can run and be validated without a context.
+ */
+class OcclusionCuller {
+public:
+    struct Stats {
+        u32 occluderTriangles;
+        u32 tested;
+        u32 occluded;
+    };
+
+private:
+    /// screen space triangle: x, y in pixels, z depth in [0, 1]
+    struct ScreenTriangle {
+        glm::vec3 v0, v1, v2;
+        /// edges (bit 0: v0v1, 1: v1v2, 2: v2v0) shared with a coplanar neighbour, they are not moved inward
+        u8 interior;
+    };
+
+    u32 m_width;
+    u32 m_height;
+    glm::mat4 m_viewProj;
+
+    std::vector<ScreenTriangle> m_triangles;
+    /// max depth pyramid, level 0 is the rasterized depth (farthest depth of the nearest occluder fully covering each pixel)
+    std::vector<std::vector<f32>> m_levels;
+
+    Stats m_stats;
+
+    WorkerPool m_workers;
+
+public:
+    OcclusionCuller(u32 width = DUST_OCCLUSION_WIDTH, u32 height = DUST_OCCLUSION_HEIGHT,
+                    u32 threadCount = DUST_OCCLUSION_THREADS);
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller &)            = delete;
+    OcclusionCuller &operator=(const OcclusionCuller &) = delete;
+
+    /**
+     * @brief Clear the occluders and set the view projection of this frame
+     */
+    void begin(const glm::mat4 &viewProj);
+    /**
+     * @brief Add occluder triangles (3 points per triangle)
+     */
+    void addOccluder(std::span<const glm::vec3> triangles, const glm::mat4 &model);
+    /**
+     * @brief Rasterize the occluders and build the depth pyramid
+     */
+    void rasterize();
+
+    /**
+     * @brief If a world space box is (at least partly) in front of the occluders
+     */
+    [[nodiscard]] bool isVisible(const AABB &box) const;
+    /**
+     * @brief Write the visibility (1 visible, 0 occluded) of every box
+     * @return number of visible boxes
+     */
+    u32 cull(std::span<const AABB> boxes, std::vector<u8> &visibility);
+
+    [[nodiscard]] const Stats &getStats() const;
+    [[nodiscard]] u32 getWidth() const;
+    [[nodiscard]] u32 getHeight() const;
+    [[nodiscard]] u32 getLevelCount() const;
+    /** @brief Depth pyramid level (row major, bottom row first) */
+    [[nodiscard]] std::span<const f32> getLevel(u32 level) const;
+
+private:
+    /**
+     * @brief Flag the edges shared by the coplanar triangles of an occluder, from `first`
+     */
+    void markInteriorEdges(u32 first);
+    void rasterizeBand(u32 firstRow, u32 lastRow);
+    void buildPyramid();
+};
+using OcclusionCullerPtr  = Ref<OcclusionCuller>;
+using OcclusionCullerUPtr = Scope<OcclusionCuller>;
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_OCCLUSIONCULLER_HPP_
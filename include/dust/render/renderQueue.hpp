@@ -0,0 +1,178 @@
+#ifndef _DUST_RENDER_RENDERQUEUE_HPP_
+#define _DUST_RENDER_RENDERQUEUE_HPP_
+
+#include "../core/types.hpp"
+#include "culling.hpp"
+#include "lod.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float3.hpp"
+
+#include <vector>
+
+namespace dust {
+namespace render {
+
+class Mesh;
+class OcclusionCuller;
+class Shader;
+
+/**
+ * @brief A single deferred draw, sorted by its key before submission
+ */
+struct DrawPacket {
+    /// Sort key (see RenderQueue::MakeKey)
+    u64 key;
+    Mesh *mesh;
+    Shader *shader;
+    /// Index of the model matrix in the queue transforms
+    u32 transform;
+    /// visible meshlet index ranges in the queue ranges, the whole mesh is drawn when there are none
+    u32 firstRange;
+    u32 rangeCount;
+};
+
+/**
+ * @brief Collects draw packets during a frame and submits them
+ * sorted by state to minimize program/material/VAO switches.
+ *
+ * Key layout (msb to lsb) for opaque packets:
+ * `pass(4) | shader(12) | material(16) | vao(16) | depth(16)`
+ * Blended packets are stored in their own bucket and sorted back to front:
+ * `pass(4) | ~depth(16) | shader(12) | material(16) | vao(16)`
+ *
+ * When a frustum is set, the packets whose world bounds are outside of it
+ * are culled as one array at flush, before sorting. With an occlusion culler
+ * the occluders of the remaining opaque packets are rasterized and the packets
+ * hidden behind them are culled too. Meshes split into meshlets are then culled
+ * per meshlet (frustum and normal cone) and drawn as the ranges of the visible ones.
+ * Meshes with levels of detail draw the one selected at push (LODSelector).
+ * Position only shaders (Shader::isPositionOnly) draw the mesh position streams,
+ * without binding materials nor sorting by them.
+ *
+ * Packets keep raw pointers on meshes and shaders,
+ * they must outlive the next RenderQueue::flush().
+ */
+class RenderQueue {
+public:
+    /**
+     * @brief Counters of the last flush
+     */
+    struct Stats {
+        u32 packets;
+        /// packets left after culling
+        u32 visible;
+        /// packets outside of the frustum
+        u32 culled;
+        /// packets hidden behind occluders
+        u32 occluded;
+        /// meshlets tested and culled
+        u32 meshlets;
+        u32 culledMeshlets;
+        u32 triangles;
+        u32 drawCalls;
+        u32 shaderSwitches;
+        u32 materialSwitches;
+        u32 vaoSwitches;
+    };
+
+private:
+    std::vector<DrawPacket> m_opaque;
+    std::vector<DrawPacket> m_blended;
+    std::vector<DrawPacket> m_sortBuffer;
+    std::vector<glm::mat4> m_transforms;
+    // world bounds of every packet, indexed like the transforms
+    FrustumCuller m_culler;
+    std::vector<u8> m_visibility;
+    Frustum m_frustum;
+    bool m_culling;
+    OcclusionCuller *m_occlusionCuller;
+    std::vector<AABB> m_bounds;
+    std::vector<AABB> m_occludeeBounds;
+    // transform and world bounds of the packets tested for occlusion
+    std::vector<u32> m_occludees;
+    std::vector<u8> m_occludeeVisibility;
+    // index ranges of the visible meshlets (glMultiDrawElements arrays)
+    bool m_meshletCulling;
+    std::vector<i32> m_rangeCounts;
+    std::vector<const void *> m_rangeOffsets;
+
+    glm::vec3 m_viewPosition;
+    f32 m_depthRange;
+    LODSelector m_lodSelector;
+
+    Stats m_stats;
+
+public:
+    RenderQueue();
+    ~RenderQueue() = default;
+
+    /**
+     * @brief Set the point used to compute the packets depth
+     * @param position view position (in world space)
+     * @param depthRange max distance used to quantize the depth (usually the camera far plane)
+     */
+    void setViewPosition(glm::vec3 position, f32 depthRange = 1000.f);
+    /**
+     * @brief Select the level of detail of the pushed meshes from their screen space error
+     * @param projectionScale see LODSelector::ProjectionScale, 0 disables the selection
+     * @param maxError max error in pixels
+     */
+    void setLODSelection(f32 projectionScale, f32 maxError = 1.f);
+    /**
+     * @brief Cull the packets outside of `frustum` at the next flush
+     * (e.g. Camera::getFrustum), culling is disabled again after it
+     */
+    void setFrustum(const Frustum &frustum);
+    /**
+     * @brief Cull the packets hidden behind occluders at the next flush,
+     * `culler` must have begun the frame (OcclusionCuller::begin) and outlive the flush
+     */
+    void setOcclusionCuller(OcclusionCuller *culler);
+    /**
+     * @brief Enable the per meshlet culling along the frustum culling (enabled by default),
+     * the cone test uses the view position and assumes back faces are culled
+     */
+    void setMeshletCulling(bool enabled);
+
+    /**
+     * @brief Queue a mesh draw
+     * @param pass pass index (only the 4 lower bits are used), lower passes are submitted first
+     * @param lod level of detail selected the previous frame for this draw (updated),
+     * keeps the selection stable between frames
+     */
+    void push(Mesh *mesh, Shader *shader, const glm::mat4 &model, u8 pass = 0, u8 *lod = nullptr);
+
+    /**
+     * @brief Sort both buckets by key (radix sort)
+     */
+    void sort();
+    /**
+     * @brief Sort, submit then clear the queued packets
+     */
+    void flush();
+    /**
+     * @brief Drop every queued packets
+     */
+    void clear();
+
+    [[nodiscard]] bool empty() const;
+    [[nodiscard]] const Stats &getStats() const;
+
+    static u64 MakeKey(u8 pass, u32 shader, u32 material, u32 vao, u16 depth);
+    static u64 MakeBlendedKey(u8 pass, u32 shader, u32 material, u32 vao, u16 depth);
+
+private:
+    void cull();
+    void cullOccluded();
+    void cullMeshlets();
+    void submit(const std::vector<DrawPacket> &packets);
+    u16 quantizeDepth(const glm::mat4 &model) const;
+    static void RadixSort(std::vector<DrawPacket> &packets, std::vector<DrawPacket> &buffer);
+};
+using RenderQueuePtr  = Ref<RenderQueue>;
+using RenderQueueUPtr = Scope<RenderQueue>;
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_RENDERQUEUE_HPP_
@@ -5,9 +5,16 @@
 
 #include "../core/types.hpp"
 #include "../core/window.hpp"
+#include "materialTable.hpp"
+#include "streamBuffer.hpp"
+#include "uniformBuffer.hpp"
 
 namespace dust {
 
+namespace render {
+class Camera;
+}
+
 class Renderer {
 private:
     std::string m_renderApiVersion;
@@ -17,6 +24,17 @@ private:
 
     bool m_depthEnabled{true};
 
+    // shared uniform blocks
+    Scope<render::UniformBuffer> m_frameBuffer;
+    Scope<render::UniformBuffer> m_viewBuffer;
+    Scope<render::UniformBuffer> m_lightBuffer;
+    Scope<render::UniformBuffer> m_shadowBuffer;
+    Scope<render::UniformBuffer> m_clusterBuffer;
+    // per material parameters
+    Scope<render::MaterialTable> m_materialTable;
+    // per frame dynamic data
+    Scope<render::StreamBuffer> m_streamBuffer;
+
 public:
     explicit Renderer(const Window &window);
     ~Renderer();
@@ -37,6 +55,37 @@ public:
     void resize(u32 width, u32 height);
 
     void setDrawWireframe(bool wireframe);
+
+    /**
+     * @brief Upload the `FrameData` uniform block
+     */
+    void setFrameData(const render::FrameData &data);
+    /**
+     * @brief Upload the `ViewData` uniform block (e.g. before rendering another view)
+     */
+    void setViewData(const render::ViewData &data);
+    /**
+     * @brief Upload the camera `ViewData` if it changed since its last upload
+     * @param force upload even if the camera did not change (after a setViewData)
+     */
+    void setView(render::Camera *camera, bool force = false);
+    /**
+     * @brief Upload the `LightData` uniform block
+     */
+    void setLightData(const render::LightData &data);
+    /**
+     * @brief Upload the `ShadowData` uniform block (see render::CascadeShadowMap)
+     */
+    void setShadowData(const render::ShadowData &data);
+    /**
+     * @brief Upload the `ClusterData` uniform block (see render::LightClusters)
+     */
+    void setClusterData(const render::ClusterData &data);
+
+    /**
+     * @brief Ring buffer for data written every frame, see render::StreamBuffer
+     */
+    render::StreamBuffer *getStreamBuffer() const;
 };
 
 }  // namespace dust
@@ -1,6 +1,7 @@
 #ifndef _DUST_RENDER_SHADER_HPP_
 #define _DUST_RENDER_SHADER_HPP_
 
+#include "dust/core/stringID.hpp"
 #include "dust/core/types.hpp"
 #include "dust/io/resourceFile.hpp"
 
@@ -49,6 +50,16 @@ struct Uniform {
     u32 index;
 };
 
+/**
+ * @brief Location of a uniform in a shader program (see Shader::getUniformHandle).
+ * Stays valid until the shader is reloaded.
+ */
+struct UniformHandle {
+    i32 location{-1};
+
+    bool isValid() const { return location >= 0; }
+};
+
 /**
  * @brief Represent a OpenGL Shader
  */
@@ -63,8 +74,12 @@ protected:
     /// File path to the fragment Shader file
     std::string m_fragmentFilePath{};
 
-    /// Map of the Uniforms location in the Shader
-    std::unordered_map<std::string, Uniform> m_uniforms;
+    /// Map of the Uniforms location in the Shader (by hashed name)
+    std::unordered_map<StringID, Uniform> m_uniforms;
+    /// Depth only shader drawing the mesh position streams, see setPositionOnly
+    bool m_positionOnly{false};
+    /// If the only active vertex input is the position (location 0)
+    bool m_readsPositionOnly{false};
 public:
     /**
      * @brief Create a new Shader Program (With vertex and fragment)
@@ -83,55 +98,86 @@ public:
      */
     void use() const;
 
+    /**
+     * @brief Get the OpenGL Shader program ID
+     */
+    u32 getRenderID() const;
+    /**
+     * @brief Flag a depth only shader (depth pre-pass, shadows): the meshes are then drawn
+     * with their position stream (Mesh::setPositionStream) and without material binds.
+     * Refused if the vertex shader reads more than the positions (location 0)
+     */
+    void setPositionOnly(bool positionOnly);
+    bool isPositionOnly() const;
+
+    /**
+     * @brief Get the cached location of an uniform
+     *
+     * @param name hashed uniform name (i.e. `"uModel"` or `StringID("uLights").index(0).append(".color")`)
+     * @return UniformHandle the uniform location, invalid if the uniform is not active
+     */
+    UniformHandle getUniformHandle(StringID name) const;
+
     /**
      * @brief Set an int Uniform
      *
-     * @param name uniform name in the shader
+     * @param handle uniform location (see getUniformHandle)
      * @param value value of this uniform
      */
-    void setUniform(const std::string &name, int value);
+    void setUniform(UniformHandle handle, int value);
     /**
      * @brief Set a bool Uniform
      *
-     * @param name uniform name in the shader
+     * @param handle uniform location (see getUniformHandle)
      * @param value value of this uniform
      */
-    void setUniform(const std::string &name, bool value);
+    void setUniform(UniformHandle handle, bool value);
     /**
      * @brief Set a float Uniform
      *
-     * @param name uniform name in the shader
+     * @param handle uniform location (see getUniformHandle)
      * @param value value of this uniform
      */
-    void setUniform(const std::string &name, float value);
+    void setUniform(UniformHandle handle, float value);
     /**
      * @brief Set a vec2 Uniform
      *
-     * @param name uniform name in the shader
+     * @param handle uniform location (see getUniformHandle)
      * @param value value of this uniform
      */
-    void setUniform(const std::string &name, glm::vec2 value);
+    void setUniform(UniformHandle handle, glm::vec2 value);
     /**
      * @brief Set a vec3 Uniform
      *
-     * @param name uniform name in the shader
+     * @param handle uniform location (see getUniformHandle)
      * @param value value of this uniform
      */
-    void setUniform(const std::string &name, glm::vec3 value);
+    void setUniform(UniformHandle handle, glm::vec3 value);
     /**
      * @brief Set a vec4 Uniform
      *
-     * @param name uniform name in the shader
+     * @param handle uniform location (see getUniformHandle)
      * @param value value of this uniform
      */
-    void setUniform(const std::string &name, glm::vec4 value);
+    void setUniform(UniformHandle handle, glm::vec4 value);
     /**
      * @brief Set a mat4 Uniform
      *
-     * @param name uniform name in the shader
+     * @param handle uniform location (see getUniformHandle)
+     * @param value value of this uniform
+     */
+    void setUniform(UniformHandle handle, glm::mat4 value);
+
+    /**
+     * @brief Set an Uniform by name (one hashed lookup, no allocation)
+     *
+     * @param name hashed uniform name in the shader
      * @param value value of this uniform
      */
-    void setUniform(const std::string &name, glm::mat4 value);
+    template <typename T>
+    void setUniform(StringID name, const T &value) {
+        setUniform(getUniformHandle(name), value);
+    }
 
     /**
      * @brief Reload the Shader Program from previous filePath(s)
@@ -164,13 +210,6 @@ protected:
      */
     u32 internalCreate(const std::string &vertexCode, const std::string &fragmentCode);
 
-    /**
-     * @brief Get the Uniform Location in the m_uniforms map
-     * @param name Name of the uniform
-     * @return u32 the location in the actives uniforms
-     * @return -1 if not found
-     */
-    u32 getUniformLocation(const std::string &name);
     /**
      * @brief Compile a shader
      * @param type the OpenGL shader type (i.e. `GL_FRAGMENT_SHADER`)
@@ -201,6 +240,12 @@ protected:
      * @param program the OpenGL shader program ID
      */
     void queryActiveUniforms(u32 program);
+    /**
+     * @brief Find if the only active vertex input is at the location 0,
+     * a reloaded shader reading more is no longer position only
+     * @param program the OpenGL shader program ID
+     */
+    void queryActiveAttributes(u32 program);
 };
 using ShaderPtr = Ref<Shader>;
 using ShaderUPtr = Scope<Shader>;
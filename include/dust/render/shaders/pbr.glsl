@@ -21,8 +21,12 @@ out VS_OUT {
     mat3 TBN;
 } vs_out;
 
-uniform mat4 uView;
-uniform mat4 uProj;
+layout (std140, binding = 1) uniform ViewData {
+    mat4 uView;
+    mat4 uProj;
+    mat4 uViewProj;
+    vec4 uViewPos;
+};
 uniform mat4 uModel;
 uniform mat4 uLightViewProj;
 
@@ -57,46 +61,90 @@ out vec4 FragColor;
 /***********************************************/
 // Materials
 
-#define MAT_COUNT 6
+#define MATERIAL_EXIST 1u
+#define NO_TEXTURE_LAYER 0xFFFFFFFFu
+#define TEXTURE_ALBEDO    0
+#define TEXTURE_NORMAL    1
+#define TEXTURE_ORM       2 // r: ao, g: roughness, b: metallic
 struct material_t {
-    bool exist;
-
-    vec3 albedo;
-    float metallic;
-    float roughness;
-    float ao;
+    vec4 albedo;
+    vec4 params; // x: metallic, y: roughness, z: ao
+    uint flags;
+    uint textureSlot;
+    uint textures[3]; // packed texture array layers (array << 16 | layer)
+    uint _padding[3];
+};
+layout (std430, binding = 0) readonly buffer MaterialTable {
+    material_t uMaterialTable[];
+};
 
-    sampler2D texAlbedo;
-    sampler2D texNormal;
-    sampler2D texMetallic;
-    sampler2D texRoughness;
-    sampler2D texAO;
+#define MAX_TEXTURE_ARRAYS 8
+uniform sampler2DArray uTextureArrays[MAX_TEXTURE_ARRAYS];
 
-};
-uniform material_t uMaterials[MAT_COUNT];
+// Sample a material texture, white if the material has none
+vec4 sampleMaterial(material_t material, int kind, vec2 uv)
+{
+    uint ref = material.textures[kind];
+    if(ref == NO_TEXTURE_LAYER) return vec4(1.);
+    vec3 coord = vec3(uv, float(ref & 0xFFFFu));
+    // constant indices: the array index is not dynamically uniform
+    switch(ref >> 16) {
+        case 0u: return texture(uTextureArrays[0], coord);
+        case 1u: return texture(uTextureArrays[1], coord);
+        case 2u: return texture(uTextureArrays[2], coord);
+        case 3u: return texture(uTextureArrays[3], coord);
+        case 4u: return texture(uTextureArrays[4], coord);
+        case 5u: return texture(uTextureArrays[5], coord);
+        case 6u: return texture(uTextureArrays[6], coord);
+        case 7u: return texture(uTextureArrays[7], coord);
+    }
+    return vec4(1.);
+}
 
 /***********************************************/
 // Lights
 
-#define MAX_LIGHTS_COUNT 10
+#define MAX_LIGHTS_COUNT 16
 struct light_t {
-    int type;
+    vec4 position;  // w: type (0: directional, 1: point, 2: spot)
+    vec4 direction; // w: range
+    vec4 color;
+    vec4 cone;      // x: cos outer angle, y: 1 / (cos inner - cos outer)
+};
+layout (std140, binding = 2) uniform LightData {
+    vec4 uAmbient;
+    int uLightCount;
+    light_t uLights[MAX_LIGHTS_COUNT];
+};
 
-    vec3 position;
-    vec3 direction;
-    vec3 color;
-    float falloff;
+// local lights clustered in froxels (dust::render::LightClusters)
+layout (std140, binding = 4) uniform ClusterData {
+    uvec4 uClusterSize;  // xyz: clusters along the width, height and depth, w: local light count
+    vec4 uClusterDepth;  // x: near, y: far, z: slice scale, w: slice bias
+};
+layout (std430, binding = 2) readonly buffer LightList {
+    light_t uLocalLights[];
+};
+layout (std430, binding = 3) readonly buffer ClusterGrid {
+    uvec2 uClusters[];   // x: first index, y: light count
+};
+layout (std430, binding = 4) readonly buffer ClusterIndices {
+    uint uClusterIndices[];
 };
-uniform int uLightCount;
-uniform light_t uLights[MAX_LIGHTS_COUNT];
 
 /***********************************************/
 // Globals
 
 uniform sampler2D uEnvironnmentMap;
-uniform vec3 uViewPos;
 uniform float uExposure;
 
+layout (std140, binding = 1) uniform ViewData {
+    mat4 uView;
+    mat4 uProj;
+    mat4 uViewProj;
+    vec4 uViewPos;
+};
+
 const float gamma = 2.2;
 const float inv_gamma = 1./gamma;
 
@@ -128,13 +176,45 @@ float lerp(float a, float b, float t)
 }
 
 // Normal/Bump mapping
-vec3 calcBumpMapping()
+vec3 calcBumpMapping(material_t material)
 {
-    vec3 normal = texture(uMaterials[int(fs_in.matID)].texNormal, fs_in.texCoord).xyz;
-    normal = normal * 2.0 - 1.0;   
+    if(material.textures[TEXTURE_NORMAL] == NO_TEXTURE_LAYER) return normalize(fs_in.normal);
+    // RG8 normal maps: z is rebuilt from the unit length
+    vec3 normal;
+    normal.xy = sampleMaterial(material, TEXTURE_NORMAL, fs_in.texCoord).xy * 2.0 - 1.0;
+    normal.z  = sqrt(max(1.0 - dot(normal.xy, normal.xy), 0.0));
     return normalize(fs_in.TBN * normal); 
 }
 
+// First index and count of the local lights of the fragment cluster
+uvec2 getCluster()
+{
+    vec4 clip   = uViewProj * vec4(fs_in.fragPos, 1.0);
+    vec2 uv     = clamp(clip.xy / clip.w * 0.5 + 0.5, 0.0, 0.99999);
+    float depth = max(-(uView * vec4(fs_in.fragPos, 1.0)).z, uClusterDepth.x);
+    // exponential depth slices
+    float slice = clamp(floor(log(depth) * uClusterDepth.z + uClusterDepth.w), 0.0, float(uClusterSize.z - 1u));
+    uvec2 tile  = uvec2(uv * vec2(uClusterSize.xy));
+    return uClusters[(uint(slice) * uClusterSize.y + tile.y) * uClusterSize.x + tile.x];
+}
+
+// Point and spot lights: windowed inverse square falloff, 0 at the light range
+float calcAttenuation(light_t light, out vec3 L)
+{
+    vec3 toLight   = light.position.xyz - fs_in.fragPos;
+    float distance = length(toLight);
+    L = toLight / max(distance, 0.0001);
+
+    float ratio       = distance / max(light.direction.w, 0.0001);
+    float window      = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    float attenuation = window * window / (distance * distance + 1.0);
+    if(int(light.position.w) == 2) { // spot
+        float cone = clamp((dot(-L, light.direction.xyz) - light.cone.x) * light.cone.y, 0.0, 1.0);
+        attenuation *= cone * cone;
+    }
+    return attenuation;
+}
+
 /***********************************************/
 // BRDF Functions
 
@@ -177,24 +257,53 @@ vec3 fresnelSchlick(float cosTheta, vec3 F0)
     return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
 }
 
+/** Outgoing radiance of a light (Cook-Torrance) */
+vec3 calcBRDF(vec3 N, vec3 V, vec3 L, vec3 radiance, vec3 albedo, float metallic, float roughness)
+{
+    vec3 H = normalize(V + L);
+    float NdotL = max(dot(N, L), 0.0);        
+
+    vec3 F0 = vec3(0.04); // TODO: add parameter for dieletric
+    F0      = mix(F0, albedo, metallic);
+    vec3 F  = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+    // Calculate specular and diffuse term
+    vec3 kS = F;
+    vec3 kD = vec3(1.0) - kS;
+    
+    kD *= 1.0 - metallic;	
+
+    float NDF = DistributionGGX(N, H, roughness);       
+    float G   = GeometrySmith(N, V, L, roughness);
+    // Cook torrance BRDF
+    vec3 numerator    = NDF * G * F;
+    float denominator = 4.0 * max(dot(N, V), 0.0) * NdotL  + 0.0001;
+    vec3 specular     = numerator / denominator;
+
+    return (kD * albedo / PI + specular) * radiance * NdotL;
+}
+
 /***********************************************/
 // Main
 
 void main() {
     // check if material is set otherwise print pink/magenta
-    if(!uMaterials[int(fs_in.matID)].exist) {
+    material_t material = uMaterialTable[int(fs_in.matID)];
+    if((material.flags & MATERIAL_EXIST) == 0u) {
         FragColor = vec4(1, 0, 1, 1);
         return;
     }
 
     // Request scene data
-    vec3 N = calcBumpMapping();
-    vec3 V = normalize(uViewPos - fs_in.fragPos);
+    vec3 N = calcBumpMapping(material);
+    vec3 V = normalize(uViewPos.xyz - fs_in.fragPos);
 
-    vec3 albedo    = texture(uMaterials[int(fs_in.matID)].texAlbedo,    texCoord).rgb * uMaterials[int(fs_in.matID)].albedo    ;
-    vec3 metallic  = texture(uMaterials[int(fs_in.matID)].texMetallic,  texCoord).rgb * uMaterials[int(fs_in.matID)].metallic  ;
-    vec3 roughness = texture(uMaterials[int(fs_in.matID)].texRoughness, texCoord).rgb * uMaterials[int(fs_in.matID)].roughness ;
-    vec3 ao        = texture(uMaterials[int(fs_in.matID)].texAO,        texCoord).rgb * uMaterials[int(fs_in.matID)].ao        ;
+    vec3 albedo    = sampleMaterial(material, TEXTURE_ALBEDO,    texCoord).rgb * material.albedo.rgb;
+    // one fetch for ao, roughness and metallic
+    vec3 orm       = sampleMaterial(material, TEXTURE_ORM,       texCoord).rgb;
+    float metallic  = orm.b * material.params.x;
+    float roughness = orm.g * material.params.y;
+    float ao        = orm.r * material.params.z;
 
     // Calculate lights
     vec3 Lo = vec3(0.0);
@@ -202,34 +311,24 @@ void main() {
     {
         // calculate per light radiance
         light_t light = uLights[i];
-        vec3 L = normalize(light.position - uViewPos);
-        if(light.type == 0) { // directionnal (sun)
-            L = light.direction;
-        } 
-        vec3 H = normalize(V + L);
-        float NdotL = max(dot(N, L), 0.0);        
-        float distance    = length(L) * light.falloff;
-        float attenuation = 1.0 / (distance * distance);
-        vec3 radiance     = light.color * attenuation;
-
-        vec3 F0 = vec3(0.04); // TODO: add parameter for dieletric
-        F0      = mix(F0, albedo, metallic);
-        vec3 F  = fresnelSchlick(max(dot(H, V), 0.0), F0);
-
-        // Calculate specular and diffuse term
-        vec3 kS = F;
-        vec3 kD = vec3(1.0) - kS;
-        
-        kD *= 1.0 - metallic;	
-
-        float NDF = DistributionGGX(N, H, roughness);       
-        float G   = GeometrySmith(N, V, L, roughness);
-        // Cook torrance BRDF
-        vec3 numerator    = NDF * G * F;
-        float denominator = 4.0 * max(dot(N, V), 0.0) * NdotL  + 0.0001;
-        vec3 specular     = numerator / denominator;
-
-        Lo += (kD * albedo / PI + specular) * radiance * NdotL;
+        vec3 L = light.direction.xyz; // directionnal (sun)
+        vec3 radiance = light.color.rgb;
+        if(int(light.position.w) != 0) {
+            radiance *= calcAttenuation(light, L);
+        }
+        Lo += calcBRDF(N, V, L, radiance, albedo, metallic, roughness);
+    }
+
+    // local lights touching the fragment cluster
+    if(uClusterSize.w > 0u) {
+        uvec2 cluster = getCluster();
+        for(uint i = 0u; i < cluster.y; ++i)
+        {
+            light_t light = uLocalLights[uClusterIndices[cluster.x + i]];
+            vec3 L;
+            float attenuation = calcAttenuation(light, L);
+            Lo += calcBRDF(N, V, L, light.color.rgb * attenuation, albedo, metallic, roughness);
+        }
     }
 
     // TODO: add parameter for ambient 'factor'
@@ -0,0 +1,110 @@
+#ifndef _DUST_RENDER_STREAMBUFFER_HPP_
+#define _DUST_RENDER_STREAMBUFFER_HPP_
+
+#include "../core/types.hpp"
+
+#include <cstring>
+#include <vector>
+
+/// size in bytes of one frame region of the renderer stream buffer
+#define DUST_STREAM_REGION_SIZE (16u << 20)
+/// number of frames the GPU can lag behind before the CPU waits
+#define DUST_STREAM_REGION_COUNT 3
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief Part of a StreamBuffer written by the CPU this frame
+ */
+struct StreamAllocation {
+    /// persistently mapped pointer, write only
+    void *data{nullptr};
+    /// offset in the stream buffer (for glBindBufferRange, indirect offsets, ...)
+    u32 offset{0};
+    u32 size{0};
+
+    explicit operator bool() const { return data != nullptr; }
+};
+
+/**
+ * @brief Persistently mapped ring buffer for data written every frame.
+ *
+ * The storage is split into frame regions, each guarded by a fence:
+ * beginFrame waits for the GPU to be done with the region it reuses,
+ * allocations are bumped inside the current region and never re-specify the buffer.
+ */
+class StreamBuffer {
+private:
+    u32 m_renderID;
+    u8 *m_mapped;
+    u32 m_regionSize;
+    u32 m_regionCount;
+
+    u32 m_region;
+    u32 m_head;
+    /// GLsync of every region, null when the region is free
+    std::vector<void *> m_fences;
+
+    u32 m_waitCount;
+    u32 m_storageAlignment;
+
+    inline static StreamBuffer *s_instance = nullptr;
+
+public:
+    /**
+     * @param regionSize size in bytes of one frame region
+     * @param regionCount number of regions (frames in flight)
+     */
+    StreamBuffer(u32 regionSize = DUST_STREAM_REGION_SIZE, u32 regionCount = DUST_STREAM_REGION_COUNT);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer &)            = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+    /**
+     * @brief Move to the next region, waiting for the GPU if it still reads it
+     */
+    void beginFrame();
+    /**
+     * @brief Fence the current region after the frame commands
+     */
+    void endFrame();
+
+    /**
+     * @brief Bump allocate in the current region
+     * @param alignment offset alignment (power of two, e.g. the SSBO offset alignment)
+     * @return an empty allocation when the region is full
+     */
+    [[nodiscard]] StreamAllocation allocate(u32 size, u32 alignment = 16);
+    /**
+     * @brief Allocate and copy `count` elements
+     */
+    template <typename T>
+    [[nodiscard]] StreamAllocation push(const T *data, u32 count, u32 alignment = alignof(T)) {
+        StreamAllocation allocation = allocate(count * sizeof(T), alignment);
+        if (allocation) std::memcpy(allocation.data, data, count * sizeof(T));
+        return allocation;
+    }
+
+    [[nodiscard]] u32 getRenderID() const;
+    [[nodiscard]] u32 getRegionSize() const;
+    /** @brief Bytes allocated in the current region */
+    [[nodiscard]] u32 getUsed() const;
+    /** @brief Number of beginFrame that had to wait for the GPU */
+    [[nodiscard]] u32 getWaitCount() const;
+    /** @brief Offset alignment of shader storage ranges */
+    [[nodiscard]] u32 getStorageAlignment() const;
+
+    /**
+     * @brief Stream buffer of the renderer (the first one created)
+     */
+    static StreamBuffer *Get();
+};
+using StreamBufferPtr  = Ref<StreamBuffer>;
+using StreamBufferUPtr = Scope<StreamBuffer>;
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_STREAMBUFFER_HPP_
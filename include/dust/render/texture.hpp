@@ -21,10 +21,28 @@ enum class TextureWrap : int {
     Mirror,
 };
 
+/**
+ * @brief Sized GPU storage format of a texture
+ */
+enum class TextureFormat : int {
+    /// from the channels of the data (R8, RG8, RGB8 or RGBA8), grey images are swizzled to RGB
+    Auto,
+    /// single channel (roughness, metallic, AO), sampled as (r, r, r, 1)
+    R8,
+    /// two channels (i.e. tangent space normal XY)
+    RG8,
+    RGB8,
+    RGBA8,
+    /// color textures (albedo), decoded to linear by the sampler
+    SRGB8,
+    SRGB8_ALPHA8,
+};
+
 struct TextureParam {
   TextureFilter filter = TextureFilter::Point;
   TextureWrap   wrap   = TextureWrap::NoWrap;
   bool          mipMaps = true;
+  TextureFormat format  = TextureFormat::Auto;
 };
 
 class Texture
@@ -35,7 +53,9 @@ protected:
 
     u16 m_lastIndex;
     u32 m_width, m_height;
+    /// channels of the uploaded data
     u32 m_channels;
+    u32 m_layers;
 
     static Ref<Texture> s_nullTexture;
 private:
@@ -56,13 +76,16 @@ public:
     u32 getWidth() const;
     u32 getHeight() const;
     u32 getChannels() const;
+    /** @brief Layer count of a texture array (1 otherwise) */
+    u32 getLayers() const;
 
     u32 getRenderID() const;
 
     static Ref<Texture> GetNullTexture();
 
     /**
-     * @brief Create Texture 2D
+     * @brief Create Texture 2D with a full mip chain when `param.mipMaps` is set
+     * @param channels Channels count of `data` (8 bits per channel)
      */
     static Ref<Texture> CreateTexture2D(u32 width, u32 height, u32 channels, void* data, const TextureParam& param);
     /**
@@ -75,24 +98,44 @@ public:
     static Ref<Texture> CreateTexture2D(u32 width, u32 height, u32 channels, std::vector<void*> data, const TextureParam& param);
 
     /**
-     * @brief Create Texture 2D with mipMaps layers
+     * @brief Create a block compressed Texture 2D (RGTC for 1-2 channels, BPTC otherwise)
      * @param width Width of the Texture
      * @param height Height of the Texture
      * @param channels Channels count of the texture
+     * @param size Size in bytes of the base level
      * @param data List of the data for each mipmaps level
      */
     static Ref<Texture> CreateTextureCompressed2D(u32 width, u32 height, u32 channels, u32 size, std::vector<void*> data, const TextureParam& param);
 
     static Ref<Texture> CreateTextureCubeMap(u32 width, u32 height, u32 channels, std::vector<void*> faces, const TextureParam& param);
-    static Ref<Texture> CreateTexture2DArray(u32 width, u32 height, u32 channels, std::vector<void*>, const TextureParam& param);
+    /**
+     * @brief Create an immutable Texture 2D Array, every layer has the same size and format
+     * @param width Width of the layers
+     * @param height Height of the layers
+     * @param channels Channels count of the layers data
+     * @param layers data of each layer, `nullptr` layers are only allocated (see uploadLayer)
+     */
+    static Ref<Texture> CreateTexture2DArray(u32 width, u32 height, u32 channels, std::vector<void*> layers, const TextureParam& param);
+
+    /**
+     * @brief Upload the data of a texture array layer (base level, `getChannels()` channels)
+     */
+    void uploadLayer(u32 layer, const void *data);
+    /**
+     * @brief Regenerate the mipmaps (i.e. after uploading layers)
+     */
+    void generateMipmaps();
 
     /**
-     * @brief Create Texture manually, just allocate the gpu texture type for you to use
+     * @brief Create Texture manually, only the texture name is created:
+     * the caller allocates and uploads its levels
      */
     static Ref<Texture> CreateTextureRaw(int apiType, u32 width, u32 height, u32 channels);
 
 private:
     bool internalCreate(u32 apiTextureType);
+    void applyParam(const TextureParam &param, bool mipMaps);
+    static u32 apiInternalFormat(TextureFormat format, u32 channels);
     static u32 apiValue(TextureWrap wrap);
     static u32 apiValue(TextureFilter filter, bool mipMaps);
 };
@@ -0,0 +1,143 @@
+#ifndef _DUST_RENDER_UNIFORMBUFFER_HPP_
+#define _DUST_RENDER_UNIFORMBUFFER_HPP_
+
+#include "../core/types.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float4.hpp"
+#include "glm/ext/vector_uint4.hpp"
+
+/// max global (directional) lights of the `LightData` block, local lights are clustered (see render::LightClusters)
+#define DUST_MAX_LIGHTS 16
+/// max cascades of the directional light shadows (ShadowData stores them in vec4)
+#define DUST_SHADOW_CASCADES 4
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief Fixed binding points of the engine uniform blocks,
+ * shared by every shader program.
+ */
+enum UniformBinding : u32 {
+    FRAME_BINDING   = 0,
+    VIEW_BINDING    = 1,
+    LIGHT_BINDING   = 2,
+    SHADOW_BINDING  = 3,
+    CLUSTER_BINDING = 4,
+};
+
+/**
+ * @brief `FrameData` block (std140), updated once per frame
+ */
+struct FrameData {
+    f32 time;
+    f32 delta;
+    u32 frame;
+    u32 _padding;
+};
+
+/**
+ * @brief `ViewData` block (std140), updated once per view
+ */
+struct ViewData {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::mat4 viewProj;
+    /// xyz: view position
+    glm::vec4 position;
+};
+
+/**
+ * @brief A light inside the `LightData` block (std140) or the clustered light list (std430)
+ */
+struct LightEntry {
+    /// xyz: position, w: light type (see render::LightType)
+    glm::vec4 position;
+    /// xyz: direction (to the light for a directional light, of the cone for a spot light), w: range
+    glm::vec4 direction;
+    /// rgb: color times intensity
+    glm::vec4 color;
+    /// spot cone, x: cosine of the outer angle, y: 1 / (cos inner - cos outer)
+    glm::vec4 cone;
+};
+
+/**
+ * @brief `LightData` block (std140), updated when lights change
+ */
+struct LightData {
+    glm::vec4 ambient;
+    i32 count;
+    i32 _padding[3];
+    LightEntry lights[DUST_MAX_LIGHTS];
+};
+
+/**
+ * @brief `ShadowData` block (std140), the cascades of CascadeShadowMap
+ */
+struct ShadowData {
+    glm::mat4 viewProj[DUST_SHADOW_CASCADES];
+    /// view distance where each cascade ends
+    glm::vec4 splits;
+    /// world size of a texel of each cascade (normal offset bias)
+    glm::vec4 texelSizes;
+    i32 count;
+    i32 _padding[3];
+};
+static_assert(DUST_SHADOW_CASCADES <= 4, "ShadowData stores the cascades splits in a vec4");
+
+/**
+ * @brief `ClusterData` block (std140), the froxel grid of render::LightClusters
+ */
+struct ClusterData {
+    /// xyz: clusters along the screen width, height and the view depth, w: local light count
+    glm::uvec4 size;
+    /// x: near, y: far, z: slice scale, w: slice bias (slice = log(depth) * scale + bias)
+    glm::vec4 depth;
+};
+
+/**
+ * @brief GPU uniform buffer bound at a fixed binding point
+ */
+class UniformBuffer {
+private:
+    u32 m_renderID;
+    u32 m_size;
+    u32 m_binding;
+
+public:
+    /**
+     * @brief Allocate the buffer and bind it to its binding point
+     * @param size size of the buffer in bytes
+     * @param binding uniform block binding point (see UniformBinding)
+     */
+    UniformBuffer(u32 size, u32 binding);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer &)            = delete;
+    UniformBuffer &operator=(const UniformBuffer &) = delete;
+
+    /**
+     * @brief Upload a part of the buffer
+     */
+    void update(const void *data, u32 size, u32 offset = 0);
+    template <typename T>
+    void update(const T &data) {
+        update(&data, sizeof(T));
+    }
+
+    /**
+     * @brief Bind the buffer to its binding point again
+     */
+    void bind() const;
+
+    u32 getRenderID() const;
+    u32 getSize() const;
+    u32 getBinding() const;
+};
+using UniformBufferPtr  = Ref<UniformBuffer>;
+using UniformBufferUPtr = Scope<UniformBuffer>;
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_UNIFORMBUFFER_HPP_
@@ -0,0 +1,229 @@
+#ifndef _DUST_RENDER_VERTEXLAYOUT_HPP_
+#define _DUST_RENDER_VERTEXLAYOUT_HPP_
+
+#include "../core/types.hpp"
+#include "glm/ext/vector_float2.hpp"
+#include "glm/ext/vector_float3.hpp"
+#include "glm/ext/vector_float4.hpp"
+
+#include <array>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+/// vertex attribute locations available to the vertex layouts, the next ones are used by the instances
+#define DUST_MAX_VERTEX_ATTRIBUTES 8
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief Type of the components of a vertex attribute (values of the matching GL enums)
+ */
+enum class ComponentType : u32 {
+    Byte   = 0x1400,
+    UByte  = 0x1401,
+    Short  = 0x1402,
+    UShort = 0x1403,
+    Int    = 0x1404,
+    UInt   = 0x1405,
+    Float  = 0x1406,
+    Half   = 0x140B,
+};
+
+constexpr u32 ComponentSize(ComponentType type) {
+    switch (type) {
+    case ComponentType::Byte:
+    case ComponentType::UByte:  return 1;
+    case ComponentType::Short:
+    case ComponentType::UShort:
+    case ComponentType::Half:   return 2;
+    default:                    return 4;
+    }
+}
+
+/**
+ * @brief Format of a vertex attribute in an interleaved vertex
+ */
+struct VertexAttribute {
+    u32 location;
+    /// components read by the shader (1 to 4)
+    u32 count;
+    ComponentType type;
+    /// fixed point values mapped to [0, 1] (unsigned) or [-1, 1] (signed)
+    bool normalized;
+    /// read as integers by the shader (`int`, `uint`, `ivecN`, ...) instead of floats
+    bool integer;
+    /// byte offset in the vertex
+    u32 offset;
+};
+
+/**
+ * @brief Attributes and stride of interleaved vertices, usually the `Format()` of a VertexLayout
+ */
+struct VertexFormat {
+    std::span<const VertexAttribute> attributes;
+    u32 stride;
+
+    /**
+     * @brief Set the attributes format of a vertex array, reading the buffer bound to `binding`
+     */
+    void apply(u32 vertexArray, u32 binding = 0) const;
+};
+
+/**
+ * @brief Attribute of a VertexLayout: stored as `T` (with its padding), read as `Count` components
+ */
+template <typename T, u32 Count_, ComponentType Type_, bool Normalized_ = false, bool Integer_ = false>
+struct VertexComponent {
+    using Type = T;
+    static constexpr u32 Count            = Count_;
+    static constexpr ComponentType GLType = Type_;
+    static constexpr bool Normalized      = Normalized_;
+    static constexpr bool Integer         = Integer_;
+    static constexpr u32 Size             = sizeof(T);
+
+    static_assert(Count >= 1 && Count <= 4, "a vertex attribute has 1 to 4 components");
+    static_assert(Size >= Count * ComponentSize(Type_), "the storage type is smaller than the components");
+    static_assert(Size % 4 == 0, "vertex attributes must be 4 bytes aligned");
+    static_assert(!(Normalized_ && Integer_), "integer attributes cannot be normalized");
+    static_assert(!Integer_ || (Type_ != ComponentType::Float && Type_ != ComponentType::Half),
+                  "integer attributes need an integer type");
+    static_assert(std::is_trivially_copyable_v<T>, "vertex attributes are copied to the GPU as is");
+};
+
+// Floats
+struct Position2f   : VertexComponent<glm::vec2, 2, ComponentType::Float> {};
+struct Position3f   : VertexComponent<glm::vec3, 3, ComponentType::Float> {};
+struct TexCoord2f   : VertexComponent<glm::vec2, 2, ComponentType::Float> {};
+struct Normal3f     : VertexComponent<glm::vec3, 3, ComponentType::Float> {};
+/// w: handedness of the tangent space
+struct Tangent4f    : VertexComponent<glm::vec4, 4, ComponentType::Float> {};
+struct Color4f      : VertexComponent<glm::vec4, 4, ComponentType::Float> {};
+struct MaterialID1f : VertexComponent<f32, 1, ComponentType::Float> {};
+
+// Packed (see VertexPacking)
+/// unorm16 position in the mesh bounds, w: tangent handedness
+struct Position4un16 : VertexComponent<std::array<u16, 4>, 4, ComponentType::UShort, true> {};
+/// two half floats
+struct TexCoord2h    : VertexComponent<u32, 2, ComponentType::Half> {};
+/// octahedral encoded direction, two snorm16
+struct NormalOct16   : VertexComponent<u32, 2, ComponentType::Short, true> {};
+struct TangentOct16  : VertexComponent<u32, 2, ComponentType::Short, true> {};
+/// unorm8 rgba
+struct Color4un8     : VertexComponent<u32, 4, ComponentType::UByte, true> {};
+/// byte converted to a float by the shader, padded to 4 bytes
+struct MaterialID8   : VertexComponent<std::array<u8, 4>, 1, ComponentType::UByte> {};
+struct MaterialID32  : VertexComponent<u32, 1, ComponentType::UInt, false, true> {};
+
+/**
+ * @brief Offset of each attribute of interleaved vertices without padding
+ */
+template <u32... Sizes>
+constexpr std::array<u32, sizeof...(Sizes)> VertexOffsets() {
+    std::array<u32, sizeof...(Sizes)> offsets{};
+    const std::array<u32, sizeof...(Sizes)> sizes{Sizes...};
+    u32 offset = 0;
+    for (u32 i = 0; i < sizes.size(); ++i) {
+        offsets[i] = offset;
+        offset += sizes[i];
+    }
+    return offsets;
+}
+
+/**
+ * @brief Interleaved vertex layout known at compile time:
+ * the components are at the locations 0, 1, ... in this order, without padding.
+ *
+ * `VertexLayout<Position3f, Normal3f>::Format()` is constexpr data given to the meshes,
+ * `Vertex` stores a vertex of the layout and `Describes<T>()` checks an existing vertex struct.
+ */
+template <typename... Components>
+class VertexLayout {
+public:
+    static constexpr u32 Count  = sizeof...(Components);
+    static constexpr u32 Stride = (0 + ... + Components::Size);
+
+    static_assert(Count > 0, "empty vertex layout");
+    static_assert(Count <= DUST_MAX_VERTEX_ATTRIBUTES, "too many vertex attributes");
+
+private:
+    template <typename Component>
+    static constexpr u32 FindIndex() {
+        constexpr std::array<bool, Count> matches{std::is_same_v<Component, Components>...};
+        u32 found = Count;
+        for (u32 i = 0; i < Count; ++i) {
+            if (matches[i]) {
+                if (found != Count) return Count + 1;  // several times in the layout
+                found = i;
+            }
+        }
+        return found;
+    }
+
+public:
+    static constexpr std::array<u32, Count> Offsets = VertexOffsets<Components::Size...>();
+
+    static constexpr std::array<VertexAttribute, Count> Attributes = [] {
+        std::array<VertexAttribute, Count> attributes{
+            VertexAttribute{0, Components::Count, Components::GLType, Components::Normalized, Components::Integer, 0}...};
+        for (u32 i = 0; i < Count; ++i) {
+            attributes[i].location = i;
+            attributes[i].offset   = Offsets[i];
+        }
+        return attributes;
+    }();
+
+    static constexpr VertexFormat Format() { return VertexFormat{Attributes, Stride}; }
+
+    /** @brief Location of a component in the layout */
+    template <typename Component>
+    static constexpr u32 IndexOf() {
+        constexpr u32 index = FindIndex<Component>();
+        static_assert(index < Count, "the component is not in the layout (or is there more than once)");
+        return index;
+    }
+    template <typename Component>
+    static constexpr u32 OffsetOf() {
+        return Offsets[IndexOf<Component>()];
+    }
+
+    /**
+     * @brief If a vertex struct has the size of the layout, its members offsets
+     * are checked with `OffsetOf`
+     */
+    template <typename T>
+    static constexpr bool Describes() {
+        return sizeof(T) == Stride && std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>;
+    }
+
+    /**
+     * @brief Vertex of the layout, its components are accessed by type
+     */
+    struct Vertex {
+        std::array<u8, Stride> data{};
+
+        Vertex() = default;
+        explicit Vertex(const typename Components::Type &...components) {
+            u32 index = 0;
+            (std::memcpy(data.data() + Offsets[index++], &components, Components::Size), ...);
+        }
+
+        template <typename Component>
+        typename Component::Type get() const {
+            typename Component::Type value;
+            std::memcpy(&value, data.data() + OffsetOf<Component>(), Component::Size);
+            return value;
+        }
+        template <typename Component>
+        void set(const typename Component::Type &value) {
+            std::memcpy(data.data() + OffsetOf<Component>(), &value, Component::Size);
+        }
+    };
+    static_assert(sizeof(Vertex) == Stride);
+};
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_VERTEXLAYOUT_HPP_
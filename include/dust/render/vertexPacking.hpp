@@ -0,0 +1,100 @@
+#ifndef _DUST_RENDER_VERTEXPACKING_HPP_
+#define _DUST_RENDER_VERTEXPACKING_HPP_
+
+#include "../core/types.hpp"
+#include "culling.hpp"
+#include "glm/ext/matrix_float4x4.hpp"
+#include "glm/ext/vector_float2.hpp"
+#include "glm/ext/vector_float3.hpp"
+#include "mesh.hpp"
+#include "model.hpp"
+#include "vertexLayout.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#ifndef DUST_PACKED_VERTICES
+/**
+ * @brief Import models with PackedModelVertex instead of ModelVertex,
+ * their shaders must decode the packed layout
+ */
+#define DUST_PACKED_VERTICES 1
+#endif
+
+namespace dust {
+namespace render {
+
+/**
+ * @brief Quantized ModelVertex: 24 bytes, 28 with colors (68 unpacked).
+ *
+ * Shader inputs:
+ *  - 0 `vec4 aPos`: position in the mesh bounds (unorm16, see Mesh::setDequantization),
+ *    w is the tangent handedness (0: -1, 1: +1)
+ *  - 1 `vec2 aTexCoord`: half floats
+ *  - 2 `vec2 aNormal`, 3 `vec2 aTangent`: octahedral encoded directions (snorm16)
+ *  - 4 `float aMatID`: u8 material id
+ *  - 5 `vec4 aColor`: unorm8, only stored when the mesh has colors (reads (0, 0, 0, 1) otherwise)
+ */
+struct PackedModelVertex {
+    u32 position[2];
+    u32 texCoord;
+    u32 normal;
+    u32 tangent;
+    u8 materialID[4];
+    u32 color;
+};
+
+using PackedModelVertexLayout = VertexLayout<Position4un16, TexCoord2h, NormalOct16, TangentOct16, MaterialID8, Color4un8>;
+/// PackedModelVertex without its color
+using PackedModelVertexLayoutNoColor = VertexLayout<Position4un16, TexCoord2h, NormalOct16, TangentOct16, MaterialID8>;
+static_assert(PackedModelVertexLayout::Describes<PackedModelVertex>());
+static_assert(PackedModelVertexLayout::OffsetOf<TexCoord2h>() == offsetof(PackedModelVertex, texCoord));
+static_assert(PackedModelVertexLayout::OffsetOf<NormalOct16>() == offsetof(PackedModelVertex, normal));
+static_assert(PackedModelVertexLayout::OffsetOf<TangentOct16>() == offsetof(PackedModelVertex, tangent));
+static_assert(PackedModelVertexLayout::OffsetOf<MaterialID8>() == offsetof(PackedModelVertex, materialID));
+static_assert(PackedModelVertexLayout::OffsetOf<Color4un8>() == offsetof(PackedModelVertex, color));
+static_assert(PackedModelVertexLayoutNoColor::Stride == offsetof(PackedModelVertex, color));
+/// position stream of the packed meshes (see Mesh::setPositionStream), 8 bytes per position
+using PackedPositionLayout = VertexLayout<Position4un16>;
+
+/**
+ * @brief Quantization of ModelVertex into PackedModelVertex
+ */
+class VertexPacking {
+public:
+    /** @brief Layout of the packed vertices, the color is only stored when needed */
+    static constexpr VertexFormat Format(bool colors) {
+        return colors ? PackedModelVertexLayout::Format() : PackedModelVertexLayoutNoColor::Format();
+    }
+
+    /** @brief If the vertices can be packed: their material ids fit in a byte */
+    static bool CanPack(std::span<const ModelVertex> vertices);
+    static bool HasColors(std::span<const ModelVertex> vertices);
+
+    /**
+     * @brief Transform from the quantized positions to the mesh local space.
+     * The scale is uniform so that it can be folded into the model matrix
+     * without changing the direction of the normals.
+     */
+    static glm::mat4 Dequantization(const AABB &bounds);
+    /**
+     * @brief Pack the vertices with `Format(colors).stride` bytes each
+     * @param bounds local space bounds of the vertices, see Dequantization
+     */
+    static std::vector<u8> Pack(std::span<const ModelVertex> vertices, const AABB &bounds, bool colors);
+    /**
+     * @brief Quantize positions like Pack (w = 1) with the PackedPositionLayout,
+     * a position gives the same value in both streams
+     */
+    static std::vector<PackedPositionLayout::Vertex> PackPositions(std::span<const glm::vec3> positions, const AABB &bounds);
+
+    /** @brief Unit vector to the [-1, 1] square (Cigolle et al. 2014) */
+    static glm::vec2 EncodeOctahedral(glm::vec3 direction);
+    static glm::vec3 DecodeOctahedral(glm::vec2 encoded);
+};
+
+}  // namespace render
+}  // namespace dust
+
+#endif  //_DUST_RENDER_VERTEXPACKING_HPP_
@@ -0,0 +1,119 @@
+#ifndef _DUST_SCENE_BVH_HPP_
+#define _DUST_SCENE_BVH_HPP_
+
+#include "../core/types.hpp"
+#include "../render/culling.hpp"
+#include "glm/ext/vector_float3.hpp"
+
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace dust {
+namespace scene {
+
+/**
+ * @brief Flattened BVH node: an internal node has its two children
+ * at `leftFirst` and `leftFirst + 1`, a leaf has `count` primitives starting at `leftFirst`
+ */
+struct BVHNode {
+    glm::vec3 min;
+    u32 leftFirst;
+    glm::vec3 max;
+    u32 count;
+
+    [[nodiscard]] bool isLeaf() const { return count > 0; }
+};
+
+struct Ray {
+    glm::vec3 origin;
+    /// does not need to be normalized, distances are in its unit
+    glm::vec3 direction;
+    f32 maxDistance{std::numeric_limits<f32>::max()};
+};
+
+constexpr u32 NO_PRIMITIVE = 0xFFFFFFFF;
+
+struct RayHit {
+    u32 primitive{NO_PRIMITIVE};
+    /// distance to the box entry (0 when the ray starts inside)
+    f32 distance{std::numeric_limits<f32>::max()};
+
+    explicit operator bool() const { return primitive != NO_PRIMITIVE; }
+};
+
+/**
+ * @brief Bounding volume hierarchy over boxes (meshes, models, ...).
+ *
+ * Built top down with a binned surface area heuristic into a flat node array,
+ * primitives are identified by their index in the boxes given to `build`.
+ * Moving primitives update their box then `refit` the hierarchy without rebuilding it,
+ * its quality degrades with large motions: rebuild from time to time.
+ */
+class BVH {
+private:
+    std::vector<BVHNode> m_nodes;
+    u32 m_nodeCount;
+    /// primitives ordered by leaf
+    std::vector<u32> m_indices;
+    std::vector<render::AABB> m_boxes;
+    // build scratch
+    std::vector<glm::vec3> m_centroids;
+
+public:
+    /// number of SAH bins per axis
+    static constexpr u32 BIN_COUNT = 16;
+    /// a node with at most this many primitives is not split if it does not pay off
+    static constexpr u32 MAX_LEAF_SIZE = 4;
+
+    BVH();
+
+    /**
+     * @brief Build the hierarchy over valid boxes
+     */
+    void build(std::span<const render::AABB> boxes);
+    void clear();
+
+    /**
+     * @brief Change the box of a primitive, the hierarchy is updated by `refit`
+     */
+    void setBox(u32 primitive, const render::AABB &box);
+    /**
+     * @brief Recompute every node bounds from the primitive boxes (bottom up)
+     */
+    void refit();
+
+    /**
+     * @brief Append the primitives intersecting the frustum,
+     * subtrees fully inside are appended without further tests
+     */
+    void cull(const render::Frustum &frustum, std::vector<u32> &visible) const;
+    /**
+     * @brief Nearest primitive box hit by the ray
+     */
+    [[nodiscard]] RayHit intersect(const Ray &ray) const;
+    /**
+     * @brief Append the primitives whose box overlaps the sphere
+     */
+    void overlap(glm::vec3 center, f32 radius, std::vector<u32> &primitives) const;
+
+    [[nodiscard]] const render::AABB &getBox(u32 primitive) const;
+    [[nodiscard]] std::span<const BVHNode> getNodes() const;
+    [[nodiscard]] u32 getPrimitiveCount() const;
+    [[nodiscard]] bool empty() const;
+
+private:
+    void updateBounds(BVHNode &node) const;
+    void subdivide(u32 nodeIndex);
+    /**
+     * @return cost of the best split (infinite if none), the split axis and position
+     */
+    f32 findSplit(const BVHNode &node, u32 &axis, f32 &position) const;
+};
+using BVHPtr  = Ref<BVH>;
+using BVHUPtr = Scope<BVH>;
+
+}  // namespace scene
+}  // namespace dust
+
+#endif  //_DUST_SCENE_BVH_HPP_
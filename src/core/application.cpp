@@ -5,6 +5,7 @@
 #include "dust/core/log.hpp"
 #include "dust/io/inputManager.hpp"
 #include "dust/render/renderer.hpp"
+#include "dust/render/camera.hpp"
 #include "dust/core/profiling.hpp"
 #include "dust/editor/editor.hpp"
 
@@ -35,6 +36,7 @@ m_layers()
     m_window = dust::createScope<dust::Window>(name, width, height);
     m_inputManager = dust::createScope<dust::InputManager>(*m_window);
     m_renderer = dust::createScope<dust::Renderer>(*m_window);
+    m_renderQueue = dust::createScope<dust::render::RenderQueue>();
     m_resourceManager = dust::createScope<dust::io::ResourceManager>();
     m_editor = dust::createScope<dust::Editor>(m_window.get());
 
@@ -56,6 +58,7 @@ dust::Application::~Application()
     m_resourceManager.reset();
     m_editor.reset();
     m_inputManager.reset();
+    m_renderQueue.reset();
     m_renderer.reset();
     m_window.reset();
 }
@@ -87,11 +90,15 @@ void dust::Application::run()
         m_resourceManager->update();
 
         m_renderer->newFrame();
+        m_renderer->setFrameData({(f32)m_time.time, (f32)m_time.delta, (u32)m_time.frame, 0u});
+        m_renderer->setView(render::Camera::GetActive());
         m_editor->new_frame();
         for(auto [_, layer] : m_layers) { layer->preRender(); }
         {
             render();
             for(auto [_, layer] : m_layers) { layer->render(); }
+            // draws left in the queue after the passes
+            m_renderQueue->flush();
         }
         for(auto [_, layer] : m_layers) { layer->postRender(); }
         m_editor->render_ui();
@@ -115,6 +122,11 @@ dust::Application::getRenderer() const
 {
     return m_renderer.get();
 }
+dust::render::RenderQueue*
+dust::Application::getRenderQueue() const
+{
+    return m_renderQueue.get();
+}
 dust::InputManager*
 dust::Application::getInputManager() const
 {
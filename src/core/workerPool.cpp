@@ -0,0 +1,64 @@
+#include "dust/core/workerPool.hpp"
+
+#include "dust/core/profiling.hpp"
+
+dust::WorkerPool::WorkerPool(u32 threadCount)
+    : m_workers(), m_mutex(), m_wake(), m_done(), m_task(nullptr), m_taskCount(0), m_nextTask(0),
+      m_activeWorkers(0), m_generation(0), m_stop(false) {
+    for (u32 i = 0; i < threadCount; ++i) m_workers.emplace_back([this] { workerLoop(); });
+}
+
+dust::WorkerPool::~WorkerPool() {
+    DUST_PROFILE;
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &worker : m_workers) worker.join();
+}
+
+void dust::WorkerPool::dispatch(u32 count, const std::function<void(u32)> &task) {
+    if (m_workers.empty() || count <= 1) {
+        for (u32 i = 0; i < count; ++i) task(i);
+        return;
+    }
+    {
+        std::lock_guard lock(m_mutex);
+        m_task          = &task;
+        m_taskCount     = count;
+        m_nextTask      = 0;
+        m_activeWorkers = m_workers.size();
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    // the calling thread works too
+    for (u32 i; (i = m_nextTask.fetch_add(1)) < count;) task(i);
+
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [&] { return m_activeWorkers == 0; });
+    m_task = nullptr;
+}
+
+u32 dust::WorkerPool::getThreadCount() const {
+    return m_workers.size();
+}
+
+void dust::WorkerPool::workerLoop() {
+    u64 generation = 0;
+    while (true) {
+        std::unique_lock lock(m_mutex);
+        m_wake.wait(lock, [&] { return m_stop || m_generation != generation; });
+        if (m_stop) return;
+        generation = m_generation;
+        const auto *task = m_task;
+        const u32 count  = m_taskCount;
+        lock.unlock();
+
+        for (u32 i; (i = m_nextTask.fetch_add(1)) < count;) (*task)(i);
+
+        lock.lock();
+        if (--m_activeWorkers == 0) m_done.notify_one();
+    }
+}
@@ -14,7 +14,7 @@ using namespace dust;
 
 EditorSceneView::EditorSceneView(render::Framebuffer* scene_result_buffer)
     : EditorTool("Scene"), m_scene_result_buffer(scene_result_buffer),
-      m_size({0,0}), m_resized(false) {
+      m_size({0,0}), m_resized(false), m_clicked() {
     if(m_scene_result_buffer != nullptr) {
         m_size = glm::vec2(m_scene_result_buffer->getWidth(), m_scene_result_buffer->getHeight());
     }
@@ -25,6 +25,7 @@ bool EditorSceneView::is_panel_tool() const { return true; }
 
 void EditorSceneView::render_ui() {
     m_resized = false;
+    m_clicked.reset();
     {
         const auto size = ImGui::GetContentRegionAvail();
         if (m_size.x != size.x || m_size.y != size.y) {
@@ -37,6 +38,16 @@ void EditorSceneView::render_ui() {
             const auto renderTexture = m_scene_result_buffer->getAttachment(render::Framebuffer::AttachmentType::COLOR_HDR);
             if (renderTexture.has_value()) {
                 ImGui::Image((void *)(u64)(renderTexture.value().id), ImVec2((float)m_scene_result_buffer->getWidth(), (float)m_scene_result_buffer->getHeight()), ImVec2(0, 1), ImVec2(1, 0));
+                if (ImGui::IsItemClicked(ImGuiMouseButton_Left)) {
+                    const ImVec2 min   = ImGui::GetItemRectMin();
+                    const ImVec2 size  = ImGui::GetItemRectSize();
+                    const ImVec2 mouse = ImGui::GetMousePos();
+                    // the image is flipped: y goes up in NDC
+                    m_clicked = glm::vec2(
+                        (mouse.x - min.x) / size.x * 2.f - 1.f,
+                        1.f - (mouse.y - min.y) / size.y * 2.f
+                    );
+                }
             } else {
                 ImGui::TextColored(ImVec4{1.f, 0.f, 0.f, 1.f}, "Missing render target texture.");
             }
@@ -50,6 +61,10 @@ glm::vec2 EditorSceneView::get_size() const {
     return m_size;
 }
 
+std::optional<glm::vec2> EditorSceneView::get_clicked_position() const {
+    return m_clicked;
+}
+
 bool EditorSceneView::was_resized() const {
     return m_resized;
 }
@@ -4,13 +4,27 @@
 
 #include "dust/editor/model_tool.hpp"
 #include "dust/editor/imgui_extensions.hpp"
+#include "dust/core/profiling.hpp"
+#include "dust/render/materialTable.hpp"
 
 #include <format>
 
 using namespace dust;
 
+static void textureLayerLabel(const char *label, const render::TextureLayer &texture) {
+    const auto table = render::MaterialTable::Get();
+    const auto array = (table && texture.isValid()) ? table->getTextureArray(texture.array) : nullptr;
+    if (array == nullptr) {
+        ImGui::Text("%s: none", label);
+        return;
+    }
+    ImGui::Text("%s: array %u, layer %u (%ux%u)", label, texture.array, texture.layer, array->getWidth(),
+                array->getHeight());
+}
+
 ModelTool::ModelTool()
-    : EditorTool("Model Inspector"), m_inspected_model(nullptr) {}
+    : EditorTool("Model Inspector"), m_inspected_model(nullptr), m_bvh(), m_bvh_meshes(),
+      m_selected_mesh(-1), m_scroll_to_selected(false) {}
 
 void ModelTool::render_ui() {
     if(m_inspected_model == nullptr) {
@@ -24,11 +38,27 @@ void ModelTool::render_ui() {
             ++i;
             continue;
         }
-        const auto meshName = std::format("Mesh {}", i);
+        const bool selected = (i32)i == m_selected_mesh;
+        const auto meshName = std::format("Mesh {}{}", i, selected ? " (selected)" : "");
+        if (selected && m_scroll_to_selected) {
+            ImGui::SetNextItemOpen(true);
+            ImGui::SetScrollHereY();
+            m_scroll_to_selected = false;
+        }
         if (ImGui::TreeNode(meshName.c_str())) {
             ImGui::TextWrapped("Name: %s", mesh->getName().c_str());
             bool hidden = mesh->isHidden();
             if (ImGui::Checkbox("Hidden", &hidden)) mesh->setHidden(hidden);
+            ImGui::Text("Triangles: %u", mesh->getTriangleCount());
+            const auto &lods = mesh->getLODs();
+            if (lods.size() > 1 && ImGui::TreeNode("Levels of detail")) {
+                const u32 current = m_inspected_model->getMeshLOD(i);
+                for (u32 l = 0; l < lods.size(); ++l) {
+                    ImGui::Text("LOD %u: %u triangles, error %.4f%s", l, lods[l].indexCount / 3, lods[l].error,
+                                l == current ? " (drawn)" : "");
+                }
+                ImGui::TreePop();
+            }
             if (ImGui::TreeNode("Materials")) {
                 u32 j = 0;
                 for (auto &mat : mesh->getMaterials()) {
@@ -40,16 +70,15 @@ void ModelTool::render_ui() {
                     const auto matName = std::format("PBR Material {} - {}", j, mat->getName());
                     if (ImGui::TreeNode(matName.c_str())) {
                         auto *m = (render::PBRMaterial *)mat.get();
-                        ImGui::ColorEdit3("Albedo", glm::value_ptr(m->albedo));
-                        ImGui::SliderFloat("Roughness", &(m->roughness), 0.0f, 1.0f);
-                        ImGui::SliderFloat("Metallic", &(m->metallic), 0.0f, 1.0f);
-                        ImGui::SliderFloat("AO", &(m->ao), 0.0f, 1.0f);
+                        bool changed = ImGui::ColorEdit3("Albedo", glm::value_ptr(m->albedo));
+                        changed |= ImGui::SliderFloat("Roughness", &(m->roughness), 0.0f, 1.0f);
+                        changed |= ImGui::SliderFloat("Metallic", &(m->metallic), 0.0f, 1.0f);
+                        changed |= ImGui::SliderFloat("AO", &(m->ao), 0.0f, 1.0f);
+                        if (changed) m->markDirty();
                         if (ImGui::TreeNode("Textures")) {
-                            ImGui::TextureLabelled("Albedo", m->albedoTexture.get());
-                            ImGui::TextureLabelled("Normal", m->normalTexture.get());
-                            ImGui::TextureLabelled("Metalness", m->metallicTexture.get());
-                            ImGui::TextureLabelled("Roughness", m->roughnessTexture.get());
-                            ImGui::TextureLabelled("AO", m->aoTexture.get());
+                            textureLayerLabel("Albedo", m->albedoTexture);
+                            textureLayerLabel("Normal", m->normalTexture);
+                            textureLayerLabel("AO/Roughness/Metalness", m->ormTexture);
                             ImGui::TreePop();
                         }
                         ImGui::TreePop();
@@ -65,5 +94,45 @@ void ModelTool::render_ui() {
 }
 
 void ModelTool::set_inspected_model(render::Model *model) {
+    m_inspected_model = model;
+    m_selected_mesh   = -1;
+    build_bvh();
+}
 
+i32 ModelTool::pick(const scene::Ray &ray) {
+    DUST_PROFILE;
+    if (m_inspected_model == nullptr) return -1;
+    // the model may have moved since the last pick
+    const auto meshes    = m_inspected_model->getMeshes();
+    const auto transform = m_inspected_model->getModelMatrix();
+    for (u32 i = 0; i < m_bvh_meshes.size(); ++i) {
+        m_bvh.setBox(i, meshes.at(m_bvh_meshes[i])->getBounds().transformed(transform));
+    }
+    m_bvh.refit();
+
+    const auto hit = m_bvh.intersect(ray);
+    m_selected_mesh      = hit ? (i32)m_bvh_meshes[hit.primitive] : -1;
+    m_scroll_to_selected = m_selected_mesh >= 0;
+    return m_selected_mesh;
+}
+
+i32 ModelTool::get_selected_mesh() const {
+    return m_selected_mesh;
+}
+
+void ModelTool::build_bvh() {
+    m_bvh.clear();
+    m_bvh_meshes.clear();
+    if (m_inspected_model == nullptr) return;
+
+    const auto meshes    = m_inspected_model->getMeshes();
+    const auto transform = m_inspected_model->getModelMatrix();
+    std::vector<render::AABB> boxes{};
+    for (u32 i = 0; i < meshes.size(); ++i) {
+        // meshes without bounds cannot be picked
+        if (!meshes[i] || !meshes[i]->getBounds().isValid()) continue;
+        boxes.push_back(meshes[i]->getBounds().transformed(transform));
+        m_bvh_meshes.push_back(i);
+    }
+    m_bvh.build(boxes);
 }
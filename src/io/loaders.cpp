@@ -4,9 +4,16 @@
 #include "dust/core/types.hpp"
 #include "dust/io/assetsManager.hpp"
 #include "dust/render/material.hpp"
+#include "dust/render/materialTable.hpp"
 #include "dust/render/mesh.hpp"
+#include "dust/render/meshOptimizer.hpp"
 #include "dust/render/texture.hpp"
+#include "dust/render/vertexPacking.hpp"
 #include <algorithm>
+#include <array>
+#include <functional>
+#include <map>
+#include <tuple>
 #include <thread>
 namespace dr = dust::render;
 namespace dio = dust::io;
@@ -72,7 +79,8 @@ dio::_load_texture_general(const dio::Path &_path)
         DUST_PROFILE_SECTION("io::LoadTexture2D stb_image");
         int width, height, nrChannels;
         stbi_set_flip_vertically_on_load(true);
-        u8* data = stbi_load(path.string().c_str(), &width, &height, &nrChannels, STBI_rgb_alpha);
+        // native channel count, the storage format follows it
+        u8* data = stbi_load(path.string().c_str(), &width, &height, &nrChannels, 0);
         if(data == nullptr) {
             DUST_ERROR("[Texture][StbImage] Failed to load image : {}", stbi_failure_reason());
             return {};
@@ -110,12 +118,205 @@ DUST_DEFINE_LOADER(dr::TexturePtr, Texture2D);
 #include "assimp/scene.h"
 #include "assimp/types.h"
 
+/// ORM channels: source maps merged into one TEXTURE_ORM layer
+enum OrmChannel : u32 {
+    ORM_AO = 0,
+    ORM_ROUGHNESS,
+    ORM_METALLIC,
+    ORM_CHANNEL_COUNT
+};
+
+/// Material texture waiting to be packed into a texture array
+struct PackedTexture {
+    dr::TextureLayer layer{};
+    /// array holding the layer, owned by the materials using it
+    dr::TexturePtr array{};
+};
+/**
+ * @brief Texture layer built from source files: the file itself for albedo and normals,
+ * up to one file per OrmChannel for ORM (the same file for a glTF packed ORM)
+ */
+struct PackedTextureKey {
+    dr::MaterialTextureKind kind;
+    std::array<std::string, ORM_CHANNEL_COUNT> sources{};
+
+    auto operator<=>(const PackedTextureKey &) const = default;
+};
+
+/// Storage format of a material map
+static dr::TextureFormat
+formatOf(dr::MaterialTextureKind kind)
+{
+    switch(kind) {
+        case dr::TEXTURE_ALBEDO: return dr::TextureFormat::SRGB8_ALPHA8;
+        case dr::TEXTURE_NORMAL: return dr::TextureFormat::RG8;
+        default:                 return dr::TextureFormat::RGB8;
+    }
+}
+
+static u32
+channelsOf(dr::TextureFormat format)
+{
+    switch(format) {
+        case dr::TextureFormat::R8:           return 1;
+        case dr::TextureFormat::RG8:          return 2;
+        case dr::TextureFormat::RGB8:
+        case dr::TextureFormat::SRGB8:        return 3;
+        default:                              return 4;
+    }
+}
+
+/// Decoded source image
+struct SourceImage {
+    u8 *data{nullptr};
+    int width{0}, height{0}, channels{0};
+};
+
+/**
+ * @brief Copy the channel `sourceChannel` (RGBA) of `source` into the channel `channel` of `out`,
+ * resampled (nearest) to the layer size. Grey sources fill every color channel,
+ * the alpha of a source without alpha is left as is (opaque)
+ */
+static void
+copyChannel(const SourceImage &source, u32 sourceChannel, std::vector<u8> &out, u32 width, u32 height, u32 channels, u32 channel)
+{
+    if(sourceChannel == 3) {
+        // alpha: last channel of grey + alpha and RGBA sources only
+        if(source.channels != 2 && source.channels != 4) return;
+        sourceChannel = source.channels - 1;
+    } else if(source.channels <= 2) {
+        sourceChannel = 0;
+    }
+    for(u32 y = 0; y < height; ++y) {
+        const u32 sy = y * source.height / height;
+        for(u32 x = 0; x < width; ++x) {
+            const u32 sx = x * source.width / width;
+            out[(y * width + x) * channels + channel] = source.data[(sy * source.width + sx) * source.channels + sourceChannel];
+        }
+    }
+}
+
+/**
+ * @brief Build the layer data of a texture: normals keep XY,
+ * ORM channels are taken from their source (grey maps have every channel equal,
+ * glTF packs AO/roughness/metallic in R/G/B) and missing ones are white
+ * @return false if no source could be loaded
+ */
+static bool
+buildLayer(const PackedTextureKey &key, u32 width, u32 height, u32 channels, std::vector<u8> &out)
+{
+    out.assign(width * height * channels, 0xFF);
+    std::map<std::string, SourceImage> images{};
+    for(const auto &path : key.sources) {
+        if(path.empty() || images.contains(path)) continue;
+        SourceImage image{};
+        image.data = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+        if(image.data == nullptr) {
+            DUST_ERROR("[Texture][StbImage] Failed to load image : {}", stbi_failure_reason());
+            continue;
+        }
+        images.emplace(path, image);
+    }
+
+    for(u32 channel = 0; channel < channels; ++channel) {
+        const auto &path = key.kind == dr::TEXTURE_ORM ? key.sources[channel] : key.sources[0];
+        const auto found = images.find(path);
+        if(found == images.end()) continue;
+        copyChannel(found->second, channel, out, width, height, channels, channel);
+    }
+    for(auto &[path, image] : images) stbi_image_free(image.data);
+    return !images.empty();
+}
+
+/**
+ * @brief Pack the textures into arrays of same size and format (one array per size and format),
+ * the layers are decoded and uploaded one by one with only the channels their kind needs.
+ */
+static void
+packTextureArrays(std::map<PackedTextureKey, PackedTexture> &textures)
+{
+    DUST_PROFILE_SECTION("io::LoadModel packTextureArrays");
+    auto table = dr::MaterialTable::Get();
+    if(table == nullptr) {
+        DUST_ERROR("[Texture] No material table to register the texture arrays.");
+        return;
+    }
+
+    // layer size: the largest source
+    using GroupKey = std::tuple<u32, u32, dr::TextureFormat>;
+    std::map<GroupKey, std::vector<std::pair<const PackedTextureKey, PackedTexture>*>> groups;
+    for(auto &texture : textures) {
+        int width = 0, height = 0;
+        for(const auto &path : texture.first.sources) {
+            int sourceWidth, sourceHeight, nrChannels;
+            if(path.empty()) continue;
+            if(!stbi_info(path.c_str(), &sourceWidth, &sourceHeight, &nrChannels)) {
+                DUST_ERROR("[Texture][StbImage] Failed to read {} : {}", path, stbi_failure_reason());
+                continue;
+            }
+            width  = std::max(width, sourceWidth);
+            height = std::max(height, sourceHeight);
+        }
+        if(width == 0 || height == 0) continue;
+        groups[{width, height, formatOf(texture.first.kind)}].push_back(&texture);
+    }
+
+    stbi_set_flip_vertically_on_load(true);
+    std::vector<u8> layerData{};
+    for(auto &[key, group] : groups) {
+        const auto [width, height, format] = key;
+        const u32 channels = channelsOf(format);
+        auto textureArray = dr::Texture::CreateTexture2DArray(
+            width,
+            height,
+            channels,
+            std::vector<void*>(group.size(), nullptr),
+            {
+                dr::TextureFilter::Linear, 
+                dr::TextureWrap::NoWrap, 
+                true,
+                format
+            }
+        );
+        if(textureArray == dr::Texture::GetNullTexture()) continue;
+        const u32 arrayIndex = table->addTextureArray(textureArray);
+        if(arrayIndex == dr::NO_TEXTURE_LAYER) break;
+
+        for(u32 layer = 0; layer < group.size(); ++layer) {
+            auto &[textureKey, texture] = *group.at(layer);
+            if(!buildLayer(textureKey, width, height, channels, layerData)) continue;
+            textureArray->uploadLayer(layer, layerData.data());
+            texture.layer = dr::TextureLayer{arrayIndex, layer};
+            texture.array = textureArray;
+        }
+        textureArray->generateMipmaps();
+        DUST_DEBUG("[Texture] Packed {} textures into array {} ({}x{}, {} channels)", group.size(), arrayIndex, width, height, channels);
+    }
+}
+
 static std::vector<dr::MaterialPtr> 
 processMaterials(const aiScene *scene, const std::filesystem::path& basePath)
 {
     DUST_PROFILE_SECTION("io::LoadModel processMaterials");
-    std::vector<dr::MaterialPtr> materials{};
-    materials.reserve(scene->mNumMaterials);
+    struct TextureSource {
+        aiTextureType type;
+        dr::MaterialTextureKind kind;
+        /// source slot in the packed texture (OrmChannel for ORM)
+        u32 channel;
+    };
+    static constexpr TextureSource textureSources[] = {
+        { aiTextureType_DIFFUSE,           dr::TEXTURE_ALBEDO, 0              },
+        { aiTextureType_HEIGHT,            dr::TEXTURE_NORMAL, 0              },
+        { aiTextureType_AMBIENT_OCCLUSION, dr::TEXTURE_ORM,    ORM_AO         },
+        { aiTextureType_DIFFUSE_ROUGHNESS, dr::TEXTURE_ORM,    ORM_ROUGHNESS  },
+        { aiTextureType_METALNESS,         dr::TEXTURE_ORM,    ORM_METALLIC   },
+    };
+
+    std::vector<Ref<dr::PBRMaterial>> pbrMaterials{};
+    pbrMaterials.reserve(scene->mNumMaterials);
+    // textures are shared between materials, keyed by their sources
+    std::map<PackedTextureKey, PackedTexture> textures{};
+    std::vector<std::array<PackedTextureKey, dr::TEXTURE_KIND_COUNT>> materialTextures(scene->mNumMaterials);
     for(int i = 0; i < scene->mNumMaterials; ++i) {
         const auto material = scene->mMaterials[i];
         Ref<render::PBRMaterial> mat = createRef<render::PBRMaterial>();
@@ -124,59 +325,41 @@ processMaterials(const aiScene *scene, const std::filesystem::path& basePath)
         ai_real factor;
         aiColor4D color;
 
-        // albedo
-        if(material->GetTexture(aiTextureType_DIFFUSE, 0, &filePath) == AI_SUCCESS) {
-            const dio::Path texPath = basePath / dio::Path(filePath.C_Str());
-            const auto texture = dio::LoadTexture2D(texPath);
-            if(texture.has_value()) {
-                mat->albedoTexture = texture.value();
+        // textures
+        auto &keys = materialTextures[i];
+        for(u32 kind = 0; kind < dr::TEXTURE_KIND_COUNT; ++kind) keys[kind].kind = (dr::MaterialTextureKind)kind;
+        for(const auto &[type, kind, channel] : textureSources) {
+            if(material->GetTexture(type, 0, &filePath) != AI_SUCCESS) continue;
+            const auto texPath = dio::AssetsManager::FromAssetsDir(basePath / dio::Path(filePath.C_Str()));
+            if(!fs::exists(texPath)) {
+                DUST_ERROR("[Texture] {} doesn't exists.", texPath.string());
+                continue;
             }
+            keys[kind].sources[channel] = texPath.string();
         }
-        if(material->Get(AI_MATKEY_COLOR_DIFFUSE, color) == AI_SUCCESS) {
-            mat->albedo = {color.r, color.g, color.b};
+        for(const auto &key : keys) {
+            const bool used = std::any_of(key.sources.begin(), key.sources.end(), [](const std::string &path) {
+                return !path.empty();
+            });
+            if(used) textures.try_emplace(key);
         }
 
-        // Normals
-        if(material->GetTexture(aiTextureType_HEIGHT, 0, &filePath) == AI_SUCCESS) {
-            const dio::Path texPath = basePath / dio::Path(filePath.C_Str());
-            const auto texture = dio::LoadTexture2D(texPath);
-            if(texture.has_value()) {
-                mat->normalTexture = texture.value();
-            }
+        // albedo
+        if(material->Get(AI_MATKEY_COLOR_DIFFUSE, color) == AI_SUCCESS) {
+            mat->albedo = {color.r, color.g, color.b};
         }
 
         // Roughness
-        if(material->GetTexture(aiTextureType_DIFFUSE_ROUGHNESS, 0, &filePath) == AI_SUCCESS) {
-            const dio::Path texPath = basePath / dio::Path(filePath.C_Str());
-            const auto texture = dio::LoadTexture2D(texPath);
-            if(texture.has_value()) {
-                mat->roughnessTexture = texture.value();
-            }
-        }
         if(material->Get(AI_MATKEY_ROUGHNESS_FACTOR, factor) == aiReturn_SUCCESS) {
             mat->roughness = factor;
         }
 
         // Metallic
-        if(material->GetTexture(aiTextureType_METALNESS, 0, &filePath) == AI_SUCCESS) {
-            const dio::Path texPath = basePath / dio::Path(filePath.C_Str());
-            const auto texture = dio::LoadTexture2D(texPath);
-            if(texture.has_value()) {
-                mat->metallicTexture = texture.value();
-            }
-        }
         if(material->Get(AI_MATKEY_METALLIC_FACTOR, factor) == aiReturn_SUCCESS) {
             mat->metallic = factor;
         }
 
         // AO
-        if(material->GetTexture(aiTextureType_AMBIENT_OCCLUSION, 0, &filePath) == AI_SUCCESS) {
-            const dio::Path texPath = basePath / dio::Path(filePath.C_Str());
-            const auto texture = dio::LoadTexture2D(texPath);
-            if(texture.has_value()) {
-                mat->aoTexture = texture.value();
-            }
-        }
         mat->ao = 1.f;
 
         // Name
@@ -184,25 +367,225 @@ processMaterials(const aiScene *scene, const std::filesystem::path& basePath)
             mat->setName(filePath.C_Str());
         }
 
+        pbrMaterials.push_back(mat);
+    }
+
+    packTextureArrays(textures);
+
+    std::vector<dr::MaterialPtr> materials{};
+    materials.reserve(pbrMaterials.size());
+    for(u32 i = 0; i < pbrMaterials.size(); ++i) {
+        auto &mat = pbrMaterials.at(i);
+        const auto layerOf = [&](dr::MaterialTextureKind kind) {
+            const auto found = textures.find(materialTextures[i][kind]);
+            if(found == textures.end() || !found->second.layer.isValid()) return dr::TextureLayer{};
+            // the material keeps the array registered in the table
+            if(std::find(mat->textureArrays.begin(), mat->textureArrays.end(), found->second.array) == mat->textureArrays.end()) {
+                mat->textureArrays.push_back(found->second.array);
+            }
+            return found->second.layer;
+        };
+        mat->albedoTexture = layerOf(dr::TEXTURE_ALBEDO);
+        mat->normalTexture = layerOf(dr::TEXTURE_NORMAL);
+        mat->ormTexture    = layerOf(dr::TEXTURE_ORM);
         materials.push_back(mat);
     }
     return materials;
 }
 
+/// at most this many triangles per occluder
+constexpr u32 OCCLUDER_MAX_TRIANGLES = 128;
+/// smallest occluder triangle, relative to the largest face of the mesh bounds
+constexpr f32 OCCLUDER_MIN_AREA = 0.02f;
+
+/**
+ * @brief Coarse occluder of a mesh: its largest triangles (walls, floors, ...),
+ * small meshes and thin details do not occlude and get none
+ */
+static std::vector<glm::vec3>
+buildOccluder(const std::vector<dr::ModelVertex> &vertices, const std::vector<u32> &indices, const dr::AABB &bounds)
+{
+    if(!bounds.isValid()) return {};
+    const glm::vec3 size = bounds.max - bounds.min;
+    const f32 minArea = OCCLUDER_MIN_AREA * std::max({size.x * size.y, size.y * size.z, size.z * size.x});
+    if(minArea <= 0.f) return {};
+
+    std::vector<std::pair<f32, u32>> candidates{};
+    for(u32 i = 0; i + 2 < indices.size(); i += 3) {
+        const glm::vec3 &a = vertices[indices[i]].pos;
+        const glm::vec3 &b = vertices[indices[i + 1]].pos;
+        const glm::vec3 &c = vertices[indices[i + 2]].pos;
+        const f32 area = glm::length(glm::cross(b - a, c - a)) * .5f;
+        if(area >= minArea) candidates.emplace_back(area, i);
+    }
+    const u32 count = std::min<u32>(candidates.size(), OCCLUDER_MAX_TRIANGLES);
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), std::greater<>());
+
+    std::vector<glm::vec3> occluder{};
+    occluder.reserve(count * 3);
+    for(u32 i = 0; i < count; ++i) {
+        const u32 first = candidates[i].second;
+        for(u32 v = 0; v < 3; ++v) occluder.push_back(vertices[indices[first + v]].pos);
+    }
+    return occluder;
+}
+
+/// Geometry derived from the full resolution mesh
+struct CookedGeometry {
+    std::vector<dr::Meshlet> meshlets;
+    std::vector<glm::vec3> occluder;
+    std::vector<dr::MeshLOD> lods;
+};
+
+/// Post transform cache efficiency of the imported meshes, before and after optimization
+struct CacheReport {
+    f64 trianglesBefore{0.}, missesBefore{0.}, verticesBefore{0.};
+    f64 trianglesAfter{0.}, missesAfter{0.}, verticesAfter{0.};
+
+    void add(const dr::VertexCacheStats &before, const dr::VertexCacheStats &after, u32 triangleCount) {
+        const f64 misses[2] = {before.acmr * triangleCount, after.acmr * triangleCount};
+        trianglesBefore += triangleCount;
+        trianglesAfter  += triangleCount;
+        missesBefore    += misses[0];
+        missesAfter     += misses[1];
+        verticesBefore  += before.atvr > 0.f ? misses[0] / before.atvr : 0.;
+        verticesAfter   += after.atvr > 0.f ? misses[1] / after.atvr : 0.;
+    }
+    void log(const char *name) const {
+        if(trianglesBefore <= 0.) return;
+        DUST_INFO("[Model] {} vertex cache: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", name,
+                  missesBefore / trianglesBefore, missesAfter / trianglesAfter,
+                  missesBefore / std::max(verticesBefore, 1.), missesAfter / std::max(verticesAfter, 1.));
+    }
+};
+
+/**
+ * @brief Optimize the mesh buffers and build its derived geometry:
+ *  - triangles ordered for the post transform cache (Tipsify), then split into meshlets
+ *    each reordered for the cache and sorted outside in against overdraw
+ *  - occluder and levels of detail (appended to the indices, also ordered for the cache)
+ *  - vertices renumbered in first use order for the vertex fetch
+ */
+static CookedGeometry
+cookGeometry(std::vector<dr::ModelVertex> &vertices, std::vector<u32> &indices, const dr::AABB &bounds, CacheReport &report)
+{
+    DUST_PROFILE_SECTION("io::LoadModel cookGeometry");
+    const auto before = dr::MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+
+    std::vector<glm::vec3> positions(vertices.size());
+    std::transform(vertices.begin(), vertices.end(), positions.begin(), [](const dr::ModelVertex &vertex) { return vertex.pos; });
+    CookedGeometry geometry{};
+    dr::MeshOptimizer::OptimizeVertexCache(indices);
+    geometry.meshlets = dr::Meshlet::Build(positions, indices);
+    for(const auto &meshlet : geometry.meshlets) {
+        dr::MeshOptimizer::OptimizeVertexCache(std::span<u32>(indices).subspan(meshlet.firstIndex, meshlet.indexCount));
+    }
+    dr::MeshOptimizer::OptimizeOverdraw(positions, indices, geometry.meshlets);
+    geometry.occluder = buildOccluder(vertices, indices, bounds);
+
+    const u32 fullIndexCount = indices.size();
+    geometry.lods = dr::MeshSimplifier::BuildLODs(positions, indices);
+    for(u32 l = 1; l < geometry.lods.size(); ++l) {
+        const auto &lod = geometry.lods[l];
+        dr::MeshOptimizer::OptimizeVertexCache(std::span<u32>(indices).subspan(lod.firstIndex, lod.indexCount));
+    }
+
+    const auto remap = dr::MeshOptimizer::OptimizeVertexFetch(indices, vertices.size());
+    dr::MeshOptimizer::RemapVertices(vertices, remap);
+
+    const auto after = dr::MeshOptimizer::AnalyzeVertexCache(std::span<const u32>(indices).first(fullIndexCount), vertices.size());
+    report.add(before, after, fullIndexCount / 3);
+    DUST_DEBUG("[Model] {} triangles, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", fullIndexCount / 3,
+               before.acmr, after.acmr, before.atvr, after.atvr);
+    return geometry;
+}
+
+/// Vertex and index memory of the imported meshes, unpacked and as uploaded
+struct MemoryReport {
+    f64 vertexBytes{0.}, packedVertexBytes{0.};
+    f64 indexBytes{0.}, packedIndexBytes{0.};
+    /// position streams (positions and indices)
+    f64 positionBytes{0.};
+    u64 vertexCount{0}, positionCount{0};
+
+    void log(const char *name) const {
+        if(vertexBytes <= 0.) return;
+        DUST_INFO("[Model] {} memory: vertices {:.2f} MiB -> {:.2f} MiB, indices {:.2f} MiB -> {:.2f} MiB", name,
+                  vertexBytes / (1 << 20), packedVertexBytes / (1 << 20),
+                  indexBytes / (1 << 20), packedIndexBytes / (1 << 20));
+        if(positionCount == 0) return;
+        DUST_INFO("[Model] {} position streams: {:.2f} MiB, {} vertices welded to {} positions", name,
+                  positionBytes / (1 << 20), vertexCount, positionCount);
+    }
+};
+
+/**
+ * @brief Welded positions of the cooked vertices for the depth only passes,
+ * in the first use order of their indices
+ * @param indices remapped to the positions
+ */
+static std::vector<glm::vec3>
+weldPositions(const std::vector<dr::ModelVertex> &vertices, std::vector<u32> &indices, MemoryReport &report)
+{
+    DUST_PROFILE_SECTION("io::LoadModel weldPositions");
+    std::vector<glm::vec3> positions(vertices.size());
+    for(u32 v = 0; v < vertices.size(); ++v) positions[v] = vertices[v].pos;
+
+    u32 positionCount = 0;
+    const auto weld = dr::MeshOptimizer::WeldPositions(positions, positionCount);
+    std::vector<glm::vec3> welded(positionCount);
+    for(u32 v = 0; v < vertices.size(); ++v) welded[weld[v]] = positions[v];
+    for(u32 &index : indices) index = weld[index];
+
+    const auto remap = dr::MeshOptimizer::OptimizeVertexFetch(indices, positionCount);
+    dr::MeshOptimizer::RemapVertices(welded, remap);
+    report.vertexCount   += vertices.size();
+    report.positionCount += welded.size();
+    return welded;
+}
+
+/**
+ * @brief Create the mesh of the cooked vertices, packed (see VertexPacking) when enabled and possible
+ */
+static dr::MeshPtr
+createMesh(std::vector<dr::ModelVertex> &vertices, const std::vector<u32> &indices, const dr::AABB &bounds, MemoryReport &report)
+{
+    DUST_PROFILE_SECTION("io::LoadModel createMesh");
+    report.vertexBytes      += vertices.size() * sizeof(dr::ModelVertex);
+    report.indexBytes       += indices.size() * sizeof(u32);
+    report.packedIndexBytes += indices.size() * (vertices.size() <= 0x10000 ? sizeof(u16) : sizeof(u32));
+#if DUST_PACKED_VERTICES
+    if(dr::VertexPacking::CanPack(vertices)) {
+        const bool colors = dr::VertexPacking::HasColors(vertices);
+        auto packed = dr::VertexPacking::Pack(vertices, bounds, colors);
+        report.packedVertexBytes += packed.size();
+        auto mesh = createRef<render::Mesh>(packed.data(), vertices.size(), dr::VertexPacking::Format(colors), indices);
+        mesh->setDequantization(dr::VertexPacking::Dequantization(bounds));
+#if DUST_POSITION_STREAMS
+        std::vector<u32> positionIndices = indices;
+        const auto positions = dr::VertexPacking::PackPositions(weldPositions(vertices, positionIndices, report), bounds);
+        report.positionBytes += positions.size() * dr::PackedPositionLayout::Stride + mesh->getIndexSize() * positionIndices.size();
+        mesh->setPositionStream(positions.data(), positions.size(), dr::PackedPositionLayout::Format(), positionIndices);
+#endif
+        return mesh;
+    }
+    DUST_WARN("[Model] Material ids above 255, vertices are not packed");
+#endif
+    report.packedVertexBytes += vertices.size() * sizeof(dr::ModelVertex);
+    auto mesh = createRef<render::Mesh>(vertices.data(), vertices.size(), dr::ModelVertexLayout::Format(), indices);
+#if DUST_POSITION_STREAMS
+    std::vector<u32> positionIndices = indices;
+    const auto positions = weldPositions(vertices, positionIndices, report);
+    report.positionBytes += positions.size() * sizeof(glm::vec3) + mesh->getIndexSize() * positionIndices.size();
+    mesh->setPositionStream(positions.data(), positions.size(), dr::VertexLayout<dr::Position3f>::Format(), positionIndices);
+#endif
+    return mesh;
+}
+
 static std::vector<dr::MeshPtr> 
 processMeshes(const aiScene *scene, std::vector<dr::MaterialPtr> materials)
 {   
     DUST_PROFILE_SECTION("io::LoadModel processMeshes");
-    // Attributes
-    std::vector<dr::Attribute> attributes {
-        dr::Attribute::Pos3D,
-        dr::Attribute::TexCoords,
-        dr::Attribute::Pos3D,     // normals
-        dr::Attribute::Pos3D,     // tangents
-        dr::Attribute::Color,
-        dr::Attribute::Float      // matID
-    };
-
     // batch all of the model into as less draw calls as possible
     const u32 batchCount = std::ceil((float)materials.size() / (float)DUST_MATERIAL_SLOTS); 
     // pre calculate the number of vertices
@@ -218,6 +601,7 @@ processMeshes(const aiScene *scene, std::vector<dr::MaterialPtr> materials)
     std::vector<std::vector<dr::ModelVertex>> vertices(batchCount);
     std::vector<std::vector<u32>> indices(batchCount);
     std::vector<std::string> batchMeshesName(batchCount, "");
+    std::vector<dr::AABB> batchBounds(batchCount);
     for(int i = 0; i < batchCount; ++i) {
         vertices.push_back(std::vector<dr::ModelVertex>(numTotalVertices[i]));
         indices.push_back(std::vector<u32>(numTotalIndices[i]));
@@ -237,6 +621,7 @@ processMeshes(const aiScene *scene, std::vector<dr::MaterialPtr> materials)
                 const auto pos    = mesh->mVertices[i];
 
                 dr::ModelVertex vertex = {{ pos.x, pos.y, pos.z }};
+                batchBounds[batchIdx].extend(vertex.pos);
                 if(mesh->HasTextureCoords(0)) { 
                     const auto tex   = mesh->mTextureCoords[0][i];
                     vertex.tex = { tex.x, tex.y }; 
@@ -246,23 +631,23 @@ processMeshes(const aiScene *scene, std::vector<dr::MaterialPtr> materials)
                     vertex.normal = { normal.x, normal.y, normal.z};
                 }
                 if(mesh->HasTangentsAndBitangents()) {
-                    const auto tangent = mesh->mTangents[i];
-                    vertex.tangent = { tangent.x, tangent.y, tangent.z };
+                    const auto tangent_ = mesh->mTangents[i];
+                    const auto tangent  = glm::vec3{tangent_.x, tangent_.y, tangent_.z};
 
                     // orthonormalize tangent
-                    vertex.tangent = glm::normalize(vertex.tangent - glm::dot(vertex.normal, vertex.tangent) * vertex.normal);
+                    const auto orthonormal = glm::normalize(tangent - glm::dot(vertex.normal, tangent) * vertex.normal);
                     const auto bitangent_ = mesh->mBitangents[i];
                     const auto bitangent  = glm::vec3{bitangent_.x, bitangent_.y, bitangent_.z};
-                    // for right-handed tbn
-                    if(glm::dot(glm::cross(vertex.normal, vertex.tangent), bitangent) < 0.f)
-                        vertex.tangent *= -1;
+                    // handedness for right-handed tbn, mirrored uvs are left-handed
+                    const f32 handedness = glm::dot(glm::cross(vertex.normal, orthonormal), bitangent) < 0.f ? -1.f : 1.f;
+                    vertex.tangent = glm::vec4(orthonormal, handedness);
                 }
 
                 if(mesh->HasVertexColors(i)) {
                     const auto color = mesh->mColors[0][i];
                     vertex.color = { color.r, color.g, color.b, color.a };
                 }
-                vertex.materialID = (float)(matId % DUST_MATERIAL_SLOTS); // matId in batch 
+                vertex.materialID = (float)materials[matId]->getID(); // index in the material table
 
                 vertices[batchIdx].push_back(vertex);
             }
@@ -281,25 +666,28 @@ processMeshes(const aiScene *scene, std::vector<dr::MaterialPtr> materials)
     // create meshes
     u32 materialI = 0;
     std::vector<dr::MeshPtr> res(batchCount);
+    CacheReport cacheReport{};
+    MemoryReport memoryReport{};
     {
         DUST_PROFILE_SECTION("io::LoadModel create meshes");
         for(int i = 0; i < batchCount; ++i) {
-            auto mesh = createRef<render::Mesh>(
-                &vertices[i].front(),
-                sizeof(dr::ModelVertex),
-                vertices[i].size(),
-                indices[i],
-                attributes
-            );
+            auto geometry = cookGeometry(vertices[i], indices[i], batchBounds[i], cacheReport);
+            auto mesh = createMesh(vertices[i], indices[i], batchBounds[i], memoryReport);
             for(int m = 0; m < DUST_MATERIAL_SLOTS; ++m) {
                 if(materialI >= materials.size()) break;
                 mesh->setMaterial(m, materials.at(materialI));
                 materialI += 1;
             }
             mesh->setName(batchMeshesName.at(i));
+            mesh->setBounds(batchBounds[i]);
+            mesh->setOccluder(std::move(geometry.occluder));
+            mesh->setMeshlets(std::move(geometry.meshlets));
+            mesh->setLODs(std::move(geometry.lods));
             res[i] = mesh;
         }
     }
+    cacheReport.log("Batches");
+    memoryReport.log("Batches");
     return res;
 }
 
@@ -308,25 +696,18 @@ static std::vector<dr::MeshPtr>
 processMeshesNoBatch(const aiScene *scene, std::vector<dr::MaterialPtr> materials)
 {
     DUST_PROFILE_SECTION("io::LoadModel processMeshes");
-    // Attributes
-    std::vector<dr::Attribute> attributes {
-        dr::Attribute::Pos3D,
-        dr::Attribute::TexCoords,
-        dr::Attribute::Pos3D,     // normals
-        dr::Attribute::Pos3D,     // tangents
-        dr::Attribute::Color,
-        dr::Attribute::Float      // matID
-    };
-
     std::vector<dr::MeshPtr> results{};
     results.reserve(scene->mNumMeshes);
+    CacheReport cacheReport{};
+    MemoryReport memoryReport{};
     // parse all meshes
     {
         DUST_PROFILE_SECTION("io::LoadModel parse meshes");
         for (int mesh_i = 0; mesh_i < scene->mNumMeshes; ++mesh_i) {
             auto mesh = scene->mMeshes[mesh_i];
             std::vector<dr::ModelVertex> vertices;
-            std::vector<unsigned int> indices;
+            std::vector<u32> indices;
+            dr::AABB bounds{};
             vertices.reserve(mesh->mNumVertices);
             indices.reserve(mesh->mNumVertices * 3);
             // process vertices
@@ -334,6 +715,7 @@ processMeshesNoBatch(const aiScene *scene, std::vector<dr::MaterialPtr> material
                 const auto pos    = mesh->mVertices[i];
 
                 dr::ModelVertex vertex = {{ pos.x, pos.y, pos.z }};
+                bounds.extend(vertex.pos);
                 if(mesh->HasTextureCoords(0)) {
                     const auto tex   = mesh->mTextureCoords[0][i];
                     vertex.tex = { tex.x, tex.y };
@@ -343,23 +725,23 @@ processMeshesNoBatch(const aiScene *scene, std::vector<dr::MaterialPtr> material
                     vertex.normal = { normal.x, normal.y, normal.z};
                 }
                 if(mesh->HasTangentsAndBitangents()) {
-                    const auto tangent = mesh->mTangents[i];
-                    vertex.tangent = { tangent.x, tangent.y, tangent.z };
+                    const auto tangent_ = mesh->mTangents[i];
+                    const auto tangent  = glm::vec3{tangent_.x, tangent_.y, tangent_.z};
 
                     // orthonormalize tangent
-                    vertex.tangent = glm::normalize(vertex.tangent - glm::dot(vertex.normal, vertex.tangent) * vertex.normal);
+                    const auto orthonormal = glm::normalize(tangent - glm::dot(vertex.normal, tangent) * vertex.normal);
                     const auto bitangent_ = mesh->mBitangents[i];
                     const auto bitangent  = glm::vec3{bitangent_.x, bitangent_.y, bitangent_.z};
-                    // for right-handed tbn
-                    if(glm::dot(glm::cross(vertex.normal, vertex.tangent), bitangent) < 0.f)
-                        vertex.tangent *= -1;
+                    // handedness for right-handed tbn, mirrored uvs are left-handed
+                    const f32 handedness = glm::dot(glm::cross(vertex.normal, orthonormal), bitangent) < 0.f ? -1.f : 1.f;
+                    vertex.tangent = glm::vec4(orthonormal, handedness);
                 }
 
                 if(mesh->HasVertexColors(i)) {
                     const auto color = mesh->mColors[0][i];
                     vertex.color = { color.r, color.g, color.b, color.a };
                 }
-                vertex.materialID = 0;
+                vertex.materialID = (float)materials.at(mesh->mMaterialIndex)->getID();
 
                 vertices.push_back(vertex);
             }
@@ -373,18 +755,19 @@ processMeshesNoBatch(const aiScene *scene, std::vector<dr::MaterialPtr> material
                 indices.push_back(face.mIndices[2]);
             }
 
-            auto created_mesh = createRef<render::Mesh>(
-                &vertices.front(),
-                sizeof(dr::ModelVertex),
-                vertices.size(),
-                indices,
-                attributes
-            );
-            created_mesh->setMaterial(0, materials.at(mesh_i));
+            auto geometry = cookGeometry(vertices, indices, bounds, cacheReport);
+            auto created_mesh = createMesh(vertices, indices, bounds, memoryReport);
+            created_mesh->setMaterial(0, materials.at(mesh->mMaterialIndex));
             created_mesh->setName(std::string(mesh->mName.C_Str()));
+            created_mesh->setBounds(bounds);
+            created_mesh->setOccluder(std::move(geometry.occluder));
+            created_mesh->setMeshlets(std::move(geometry.meshlets));
+            created_mesh->setLODs(std::move(geometry.lods));
             results.push_back(created_mesh);
         }
     }
+    cacheReport.log("Meshes");
+    memoryReport.log("Meshes");
     return results;
 }
 
@@ -11,7 +11,9 @@ namespace dr = dust::render;
 
 dr::Camera::Camera()
 : m_far(1000), m_near(0),
-m_proj(1.f), m_view(1.f)
+m_proj(1.f), m_view(1.f),
+m_dirty(true),
+m_viewProj(1.f), m_invViewProj(1.f), m_frustum(), m_frustumDirty(true)
 { 
     DUST_PROFILE;
     if(s_activeCamera == nullptr) s_activeCamera = this;
@@ -39,17 +41,84 @@ glm::mat4 dr::Camera::getProj() const
 void dr::Camera::setProj(glm::mat4 proj)
 {
     m_proj = proj;
+    invalidate();
 }
 
 void dr::Camera::setView(glm::mat4 view)
 {
     m_view = view;
+    invalidate();
+}
+
+f32 dr::Camera::getFar() const
+{
+    return m_far;
+}
+f32 dr::Camera::getNear() const
+{
+    return m_near;
+}
+
+dr::ViewData dr::Camera::getViewData() const
+{
+    DUST_PROFILE;
+    return ViewData {
+        .view     = m_view,
+        .proj     = m_proj,
+        .viewProj = getViewProj(),
+        .position = glm::inverse(m_view)[3]
+    };
+}
+bool dr::Camera::isDirty() const
+{
+    return m_dirty;
+}
+void dr::Camera::setDirty(bool dirty)
+{
+    m_dirty = dirty;
+    if(dirty) m_frustumDirty = true;
+}
+
+void dr::Camera::invalidate()
+{
+    m_dirty        = true;
+    m_frustumDirty = true;
+}
+
+void dr::Camera::updateFrustum() const
+{
+    if(!m_frustumDirty) return;
+    DUST_PROFILE_SECTION("Camera::updateFrustum");
+    m_viewProj     = m_proj * m_view;
+    m_invViewProj  = glm::inverse(m_viewProj);
+    m_frustum      = Frustum::FromMatrix(m_viewProj);
+    m_frustumDirty = false;
+}
+
+const dr::Frustum &dr::Camera::getFrustum() const
+{
+    updateFrustum();
+    return m_frustum;
+}
+
+const glm::mat4 &dr::Camera::getViewProj() const
+{
+    updateFrustum();
+    return m_viewProj;
+}
+
+glm::vec3 dr::Camera::unproject(glm::vec3 ndc) const
+{
+    updateFrustum();
+    const glm::vec4 world = m_invViewProj * glm::vec4(ndc, 1.f);
+    return glm::vec3(world) / world.w;
 }
 
 [[nodiscard]]
 dr::CameraFrustrum dr::Camera::getFrustrum() const {
     DUST_PROFILE_SECTION("Camera::getFrustrum");
-    const auto inv = glm::inverse(m_proj * m_view);
+    updateFrustum();
+    const auto &inv = m_invViewProj;
     dr::CameraFrustrum res{};
 
     res.farTopLeft       = inv * glm::vec4(-1.f,  1.f, 1.f, 1.f); 
@@ -105,6 +174,7 @@ void dr::Camera2D::resize(u32 width, u32 height)
     const f32 halfHeight = height * .5f;
     m_proj = glm::ortho(-halfWidth, halfWidth, -halfHeight, halfHeight, m_near, m_far);
     m_size = glm::vec2(width, height);
+    invalidate();
 }
 
 void dr::Camera2D::move(glm::vec2 translation)
@@ -163,6 +233,7 @@ void dr::Camera2D::updateViewMatrix()
         glm::rotate(glm::mat4(1.f), glm::radians(m_rotation), glm::vec3(0.f, 0.f, 1.f)),
         glm::vec3(m_position.x, m_position.y, 0.f)
     );
+    invalidate();
 }
 
 
@@ -199,6 +270,7 @@ void dr::Camera3D::resize(u32 width, u32 height)
     DUST_PROFILE;
     m_aspectRatio = (f32)width / (f32)height;
     m_proj = glm::perspective(glm::radians(m_fov), m_aspectRatio, m_near, m_far);
+    invalidate();
 }
 
 void dr::Camera3D::move(glm::vec2 translation)
@@ -220,6 +292,10 @@ void dr::Camera3D::setPosition(glm::vec3 position)
     m_position = position;
     updateViewMatrix();
 }
+glm::vec3 dr::Camera3D::getPosition() const
+{
+    return m_position;
+}
 
 void dr::Camera3D::rotate(glm::vec3 angle)
 {
@@ -253,6 +329,7 @@ void dr::Camera3D::updateViewMatrix()
 {
     DUST_PROFILE;
     m_view = glm::lookAt(m_position, m_position - m_forward, m_up);
+    invalidate();
 }
 
 glm::vec3 dr::Camera3D::forward() const
@@ -0,0 +1,344 @@
+#include "dust/render/cascadeShadowMap.hpp"
+
+#include "dust/core/log.hpp"
+#include "dust/core/profiling.hpp"
+#include "dust/render/glStateCache.hpp"
+#include "dust/render/light.hpp"
+#include "dust/render/renderAPI.hpp"
+#include "dust/render/renderQueue.hpp"
+
+#include "glm/common.hpp"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/ext/matrix_transform.hpp"
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dr = dust::render;
+
+/// distance of the light position behind the cascades (in radius), far enough
+/// for the meshlet cone culling to see the casters as from a directional light
+constexpr f32 LIGHT_DISTANCE = 64.f;
+
+dr::CascadeShadowMap::CascadeShadowMap(u32 size, u32 cascadeCount, f32 splitLambda)
+    : m_renderID(0), m_staticRenderID(0), m_framebuffer(0), m_size(std::max(size, 1u)),
+      m_cascadeCount(std::clamp<u32>(cascadeCount, 1u, DUST_SHADOW_CASCADES)),
+      m_splitLambda(std::clamp(splitLambda, 0.f, 1.f)), m_shadowDistance(0.f), m_casterBounds(),
+      m_updateInterval(1), m_frame(0), m_lightDirection(0.f), m_cascades(), m_scheduled(), m_staticValid(),
+      m_dynamic(), m_stale(), m_stats() {
+    DUST_PROFILE;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_renderID);
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_staticRenderID);
+    if (m_renderID == 0 || m_staticRenderID == 0) {
+        DUST_ERROR("[OpenGL][CascadeShadowMap] Failed to create the depth texture arrays");
+        return;
+    }
+    {
+        DUST_PROFILE_GPU("TextureStorage3D (Cascades)");
+        glTextureStorage3D(m_renderID, 1, GL_DEPTH_COMPONENT32F, m_size, m_size, m_cascadeCount);
+        glTextureStorage3D(m_staticRenderID, 1, GL_DEPTH_COMPONENT32F, m_size, m_size, m_cascadeCount);
+        // nothing cached yet: far depth
+        const f32 far = 1.f;
+        glClearTexImage(m_staticRenderID, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &far);
+        glClearTexImage(m_renderID, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &far);
+    }
+    // hardware PCF, lit outside of the cascades
+    glTextureParameteri(m_renderID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(m_renderID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(m_renderID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTextureParameteri(m_renderID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTextureParameteri(m_renderID, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTextureParameteri(m_renderID, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    const f32 borderColor[] = {1.f, 1.f, 1.f, 1.f};
+    glTextureParameterfv(m_renderID, GL_TEXTURE_BORDER_COLOR, borderColor);
+
+    glCreateFramebuffers(1, &m_framebuffer);
+    if (m_framebuffer == 0) {
+        DUST_ERROR("[OpenGL][CascadeShadowMap] Failed to create the framebuffer");
+        return;
+    }
+    glNamedFramebufferDrawBuffer(m_framebuffer, GL_NONE);
+    glNamedFramebufferReadBuffer(m_framebuffer, GL_NONE);
+    glNamedFramebufferTextureLayer(m_framebuffer, GL_DEPTH_ATTACHMENT, m_renderID, 0, 0);
+    const u32 status = glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        DUST_ERROR("[OpenGL][CascadeShadowMap] Incomplete framebuffer {}: {:#x}", m_framebuffer, status);
+    }
+    DUST_DEBUG("[OpenGL] Created CascadeShadowMap {} ({} cascades of {}x{})", m_renderID, m_cascadeCount, m_size,
+               m_size);
+}
+
+dr::CascadeShadowMap::~CascadeShadowMap() {
+    DUST_PROFILE;
+    if (m_framebuffer) GLStateCache::DeleteFramebuffer(m_framebuffer);
+    if (m_renderID) GLStateCache::DeleteTexture(m_renderID);
+    if (m_staticRenderID) GLStateCache::DeleteTexture(m_staticRenderID);
+}
+
+void dr::CascadeShadowMap::update(const Camera &camera, const DirectionnalLight &light) {
+    update(camera, light.getDirection());
+}
+
+void dr::CascadeShadowMap::update(const Camera &camera, glm::vec3 lightDirection) {
+    DUST_PROFILE_SECTION("CascadeShadowMap::update");
+    const f32 near     = camera.getNear();
+    const f32 far      = camera.getFar();
+    const f32 distance = m_shadowDistance > 0.f ? std::min(m_shadowDistance, far) : far;
+    const auto splits  = ComputeSplits(near, distance, m_cascadeCount, m_splitLambda);
+    const auto frustrum = camera.getFrustrum();
+
+    // the light moved: every cascade is drawn again
+    const bool lightChanged = lightDirection != m_lightDirection;
+    if (lightChanged) {
+        m_lightDirection = lightDirection;
+        invalidate();
+    }
+
+    m_stats = Stats{};
+    ++m_frame;
+    // frustum corners are interpolated linearly with the view depth
+    const auto slice = [&](f32 depth) { return far > near ? (depth - near) / (far - near) : 1.f; };
+    f32 previous = near;
+    for (u32 c = 0; c < m_cascadeCount; ++c) {
+        const f32 splitNear = previous;
+        previous            = splits[c];
+        // the first cascade every frame, the distant ones round robin
+        m_scheduled[c] = c == 0 || lightChanged || m_updateInterval <= 1 ||
+                         m_frame % m_updateInterval == (c - 1) % m_updateInterval;
+        if (!m_scheduled[c]) continue;
+
+        const auto cascade = FitCascade(frustrum, slice(splitNear), slice(splits[c]), lightDirection, m_size,
+                                        m_casterBounds, DUST_SHADOW_CENTER_STEP);
+        if (cascade.viewProj != m_cascades[c].viewProj) m_staticValid[c] = false;
+        m_cascades[c]           = cascade;
+        m_cascades[c].splitNear = splitNear;
+        m_cascades[c].splitFar  = splits[c];
+        // the dynamic casters of the last update are erased at unbind unless drawn again
+        if (m_dynamic[c] || !m_staticValid[c]) m_stale[c] = true;
+        m_dynamic[c] = false;
+        ++m_stats.updated;
+    }
+}
+
+bool dr::CascadeShadowMap::needsUpdate(u32 cascade) const {
+    return cascade < m_cascadeCount && m_scheduled[cascade];
+}
+
+bool dr::CascadeShadowMap::needsStaticUpdate(u32 cascade) const {
+    return needsUpdate(cascade) && !m_staticValid[cascade];
+}
+
+void dr::CascadeShadowMap::invalidate() {
+    m_staticValid.fill(false);
+}
+
+void dr::CascadeShadowMap::invalidate(const AABB &bounds) {
+    for (u32 c = 0; c < m_cascadeCount; ++c) {
+        if (m_cascades[c].casters.intersects(bounds)) m_staticValid[c] = false;
+    }
+}
+
+void dr::CascadeShadowMap::bindStatic(u32 cascade, RenderQueue *queue) {
+    DUST_PROFILE_GPU("CascadeShadowMap::bindStatic");
+    cascade = std::min(cascade, m_cascadeCount - 1);
+    bindLayer(m_staticRenderID, cascade, queue);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    m_staticValid[cascade] = true;
+    m_stale[cascade]       = true;
+    ++m_stats.staticRenders;
+}
+
+void dr::CascadeShadowMap::bind(u32 cascade, RenderQueue *queue) {
+    DUST_PROFILE_GPU("CascadeShadowMap::bind");
+    cascade = std::min(cascade, m_cascadeCount - 1);
+    copyStatic(cascade);
+    bindLayer(m_renderID, cascade, queue);
+    m_dynamic[cascade] = true;
+    ++m_stats.dynamicRenders;
+}
+
+void dr::CascadeShadowMap::unbind() {
+    DUST_PROFILE_GPU("CascadeShadowMap::unbind");
+    for (u32 c = 0; c < m_cascadeCount; ++c) {
+        if (m_stale[c]) copyStatic(c);
+    }
+    GLStateCache::SetDepthClamp(false);
+    GLStateCache::BindFramebuffer(0);
+}
+
+void dr::CascadeShadowMap::bindLayer(u32 texture, u32 cascade, RenderQueue *queue) {
+    const auto &current = m_cascades[cascade];
+    glNamedFramebufferTextureLayer(m_framebuffer, GL_DEPTH_ATTACHMENT, texture, 0, cascade);
+    GLStateCache::BindFramebuffer(m_framebuffer);
+    glViewport(0, 0, m_size, m_size);
+    GLStateCache::SetDepthWrite(true);
+    // casters in front of the near plane are flattened on it instead of clipped
+    GLStateCache::SetDepthClamp(true);
+
+    if (queue != nullptr) {
+        queue->setFrustum(current.casters);
+        queue->setViewPosition(current.lightPosition, current.depthRange);
+        queue->setLODSelection(0.f);
+    }
+}
+
+void dr::CascadeShadowMap::copyStatic(u32 cascade) {
+    DUST_PROFILE_GPU("CascadeShadowMap::copyStatic");
+    glCopyImageSubData(m_staticRenderID, GL_TEXTURE_2D_ARRAY, 0, 0, 0, cascade,
+                       m_renderID, GL_TEXTURE_2D_ARRAY, 0, 0, 0, cascade, m_size, m_size, 1);
+    m_stale[cascade] = false;
+    ++m_stats.copies;
+}
+
+void dr::CascadeShadowMap::bindTexture(u32 unit) const {
+    GLStateCache::BindTexture(unit, GL_TEXTURE_2D_ARRAY, m_renderID);
+}
+
+dr::ViewData dr::CascadeShadowMap::getViewData(u32 cascade) const {
+    const auto &current = m_cascades[std::min(cascade, m_cascadeCount - 1)];
+    return ViewData{
+        .view     = current.view,
+        .proj     = current.proj,
+        .viewProj = current.viewProj,
+        .position = glm::vec4(current.lightPosition, 1.f),
+    };
+}
+
+dr::ShadowData dr::CascadeShadowMap::getShadowData() const {
+    ShadowData data{};
+    for (u32 c = 0; c < DUST_SHADOW_CASCADES; ++c) {
+        // unused cascades repeat the last one
+        const auto &cascade = m_cascades[std::min(c, m_cascadeCount - 1)];
+        data.viewProj[c]    = cascade.viewProj;
+        data.splits[c]      = c < m_cascadeCount ? cascade.splitFar : 0.f;
+        data.texelSizes[c]  = cascade.texelSize;
+    }
+    data.count = static_cast<i32>(m_cascadeCount);
+    return data;
+}
+
+void dr::CascadeShadowMap::setUpdateInterval(u32 frames) {
+    m_updateInterval = std::max(frames, 1u);
+}
+u32 dr::CascadeShadowMap::getUpdateInterval() const {
+    return m_updateInterval;
+}
+
+void dr::CascadeShadowMap::setShadowDistance(f32 distance) {
+    m_shadowDistance = std::max(distance, 0.f);
+}
+f32 dr::CascadeShadowMap::getShadowDistance() const {
+    return m_shadowDistance;
+}
+void dr::CascadeShadowMap::setCasterBounds(const AABB &bounds) {
+    m_casterBounds = bounds;
+}
+
+u32 dr::CascadeShadowMap::getRenderID() const {
+    return m_renderID;
+}
+u32 dr::CascadeShadowMap::getSize() const {
+    return m_size;
+}
+u32 dr::CascadeShadowMap::getCascadeCount() const {
+    return m_cascadeCount;
+}
+const dr::ShadowCascade &dr::CascadeShadowMap::getCascade(u32 cascade) const {
+    return m_cascades[std::min(cascade, m_cascadeCount - 1)];
+}
+const dr::CascadeShadowMap::Stats &dr::CascadeShadowMap::getStats() const {
+    return m_stats;
+}
+
+std::array<f32, DUST_SHADOW_CASCADES> dr::CascadeShadowMap::ComputeSplits(f32 near, f32 far, u32 count, f32 lambda) {
+    std::array<f32, DUST_SHADOW_CASCADES> splits{};
+    count = std::clamp<u32>(count, 1u, DUST_SHADOW_CASCADES);
+    near  = std::max(near, 1e-3f);
+    far   = std::max(far, near);
+    for (u32 i = 0; i < count; ++i) {
+        const f32 p           = static_cast<f32>(i + 1) / count;
+        const f32 logarithmic = near * std::pow(far / near, p);
+        const f32 uniform     = near + (far - near) * p;
+        splits[i]             = lambda * logarithmic + (1.f - lambda) * uniform;
+    }
+    splits[count - 1] = far;
+    for (u32 i = count; i < DUST_SHADOW_CASCADES; ++i) splits[i] = far;
+    return splits;
+}
+
+dr::ShadowCascade dr::CascadeShadowMap::FitCascade(const CameraFrustrum &frustrum, f32 sliceNear, f32 sliceFar,
+                                                   glm::vec3 lightDirection, u32 size, const AABB &casterBounds,
+                                                   f32 centerStep) {
+    const std::array<glm::vec3, 4> nearCorners{glm::vec3(frustrum.nearTopRight), glm::vec3(frustrum.nearTopLeft),
+                                               glm::vec3(frustrum.nearBottomRight), glm::vec3(frustrum.nearBottomLeft)};
+    const std::array<glm::vec3, 4> farCorners{glm::vec3(frustrum.farTopRight), glm::vec3(frustrum.farTopLeft),
+                                              glm::vec3(frustrum.farBottomRight), glm::vec3(frustrum.farBottomLeft)};
+    std::array<glm::vec3, 8> corners{};
+    glm::vec3 center(0.f);
+    for (u32 i = 0; i < 4; ++i) {
+        corners[i]     = nearCorners[i] + (farCorners[i] - nearCorners[i]) * sliceNear;
+        corners[i + 4] = nearCorners[i] + (farCorners[i] - nearCorners[i]) * sliceFar;
+        center += corners[i] + corners[i + 4];
+    }
+    center *= .125f;
+
+    // the bounding sphere does not change with the camera rotation,
+    // rounded so that its size does not flicker with the float errors
+    f32 radius = 0.f;
+    for (const auto &corner : corners) radius = std::max(radius, glm::length(corner - center));
+    radius = std::max(std::ceil(radius * 16.f) / 16.f, 1e-3f);
+
+    const f32 length          = glm::length(lightDirection);
+    const glm::vec3 direction = length > 0.f ? lightDirection / length : glm::vec3(0.f, 1.f, 0.f);
+    const glm::vec3 up        = std::abs(direction.y) > .99f ? glm::vec3(0.f, 0.f, 1.f) : glm::vec3(0.f, 1.f, 0.f);
+
+    if (centerStep > 0.f) {
+        // snap the center to a grid of the light space (basis of the light view),
+        // the padded sphere still contains the slice
+        const glm::vec3 right  = glm::normalize(glm::cross(-direction, up));
+        const glm::vec3 upward = glm::cross(right, -direction);
+        const f32 step         = radius * centerStep;
+        const glm::vec3 snapped =
+            glm::round(glm::vec3(glm::dot(right, center), glm::dot(upward, center), glm::dot(direction, center)) / step) * step;
+        center = right * snapped.x + upward * snapped.y + direction * snapped.z;
+        radius += step;
+    }
+
+    ShadowCascade cascade{};
+    cascade.view = glm::lookAt(center + direction * radius, center, up);
+    cascade.proj = glm::ortho(-radius, radius, -radius, radius, 0.f, 2.f * radius);
+
+    // snap the origin to a texel: the projection only moves by whole texels
+    const f32 halfSize     = size * .5f;
+    const glm::vec4 origin = cascade.proj * cascade.view * glm::vec4(0.f, 0.f, 0.f, 1.f);
+    const glm::vec2 texel  = glm::vec2(origin.x, origin.y) * halfSize;
+    const glm::vec2 offset = (glm::round(texel) - texel) / halfSize;
+    cascade.proj[3].x += offset.x;
+    cascade.proj[3].y += offset.y;
+    cascade.viewProj  = cascade.proj * cascade.view;
+    cascade.texelSize = 2.f * radius / size;
+
+    // casters volume: the cascade box extended toward the light up to the casters bounds
+    f32 casterNear = 0.f;
+    if (casterBounds.isValid()) {
+        for (u32 i = 0; i < 8; ++i) {
+            const glm::vec3 corner((i & 1) ? casterBounds.max.x : casterBounds.min.x,
+                                   (i & 2) ? casterBounds.max.y : casterBounds.min.y,
+                                   (i & 4) ? casterBounds.max.z : casterBounds.min.z);
+            casterNear = std::min(casterNear, (cascade.view * glm::vec4(corner, 1.f)).z * -1.f);
+        }
+    }
+    glm::mat4 casterProj = glm::ortho(-radius, radius, -radius, radius, casterNear, 2.f * radius);
+    casterProj[3].x += offset.x;
+    casterProj[3].y += offset.y;
+    cascade.casters = Frustum::FromMatrix(casterProj * cascade.view);
+    if (!casterBounds.isValid()) {
+        // every caster toward the light
+        cascade.casters.planes[Frustum::PLANE_NEAR] = glm::vec4(0.f, 0.f, 0.f, 1.f);
+    }
+    const f32 lightDistance = radius - casterNear + LIGHT_DISTANCE * radius;
+    cascade.lightPosition   = center + direction * lightDistance;
+    cascade.depthRange      = lightDistance + radius;
+    return cascade;
+}
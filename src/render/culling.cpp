@@ -0,0 +1,171 @@
+#include "dust/render/culling.hpp"
+
+#include "dust/core/profiling.hpp"
+
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define DUST_CULLING_SSE
+#endif
+
+namespace dr = dust::render;
+
+void dr::AABB::extend(glm::vec3 point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+void dr::AABB::extend(const AABB &other) {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+}
+bool dr::AABB::isValid() const {
+    return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+}
+
+glm::vec3 dr::AABB::getCenter() const {
+    return (min + max) * .5f;
+}
+glm::vec3 dr::AABB::getExtent() const {
+    return (max - min) * .5f;
+}
+
+dr::AABB dr::AABB::transformed(const glm::mat4 &transform) const {
+    if (!isValid()) return *this;
+    // Arvo: the extent goes through the absolute rotation/scale
+    const glm::vec3 center = glm::vec3(transform * glm::vec4(getCenter(), 1.f));
+    const glm::vec3 extent = getExtent();
+    const glm::vec3 worldExtent = glm::abs(glm::vec3(transform[0])) * extent.x
+                                + glm::abs(glm::vec3(transform[1])) * extent.y
+                                + glm::abs(glm::vec3(transform[2])) * extent.z;
+    return AABB{center - worldExtent, center + worldExtent};
+}
+
+dr::Frustum dr::Frustum::FromMatrix(const glm::mat4 &viewProj) {
+    const auto row = [&](u32 i) {
+        return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+    };
+    Frustum frustum{};
+    frustum.planes[PLANE_LEFT]   = row(3) + row(0);
+    frustum.planes[PLANE_RIGHT]  = row(3) - row(0);
+    frustum.planes[PLANE_BOTTOM] = row(3) + row(1);
+    frustum.planes[PLANE_TOP]    = row(3) - row(1);
+    frustum.planes[PLANE_NEAR]   = row(3) + row(2);
+    frustum.planes[PLANE_FAR]    = row(3) - row(2);
+    for (auto &plane : frustum.planes) plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool dr::Frustum::intersects(const AABB &box) const {
+    if (!box.isValid()) return true;
+    const glm::vec3 center = box.getCenter();
+    const glm::vec3 extent = box.getExtent();
+    for (const auto &plane : planes) {
+        const glm::vec3 normal(plane);
+        if (glm::dot(normal, center) + glm::dot(glm::abs(normal), extent) + plane.w < 0.f) return false;
+    }
+    return true;
+}
+
+dr::FrustumCuller::FrustumCuller()
+    : m_centerX(), m_centerY(), m_centerZ(), m_extentX(), m_extentY(), m_extentZ(), m_count(0) {
+}
+
+u32 dr::FrustumCuller::push(const AABB &box) {
+    // keep every array padded to a multiple of 4 (padding boxes are visible)
+    if (m_count % 4 == 0) {
+        for (auto *array : {&m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ}) {
+            array->resize(m_count + 4, 0.f);
+        }
+    }
+    glm::vec3 center(0.f);
+    // an invalid box contains everything
+    glm::vec3 extent(std::numeric_limits<f32>::max());
+    if (box.isValid()) {
+        center = box.getCenter();
+        extent = box.getExtent();
+    }
+    m_centerX[m_count] = center.x;
+    m_centerY[m_count] = center.y;
+    m_centerZ[m_count] = center.z;
+    m_extentX[m_count] = extent.x;
+    m_extentY[m_count] = extent.y;
+    m_extentZ[m_count] = extent.z;
+    return m_count++;
+}
+
+void dr::FrustumCuller::clear() {
+    m_count = 0;
+    for (auto *array : {&m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ}) {
+        array->clear();
+    }
+}
+
+u32 dr::FrustumCuller::size() const {
+    return m_count;
+}
+
+u32 dr::FrustumCuller::cull(const Frustum &frustum, std::vector<u8> &visibility) const {
+    DUST_PROFILE_SECTION("FrustumCuller::cull");
+    visibility.resize(m_count);
+    u32 visible = 0;
+    u32 i = 0;
+#ifdef DUST_CULLING_SSE
+    // planes splatted once: n.c + |n|.e + d < 0 culls the box
+    __m128 planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT], planeZ[Frustum::PLANE_COUNT];
+    __m128 absX[Frustum::PLANE_COUNT], absY[Frustum::PLANE_COUNT], absZ[Frustum::PLANE_COUNT];
+    __m128 planeW[Frustum::PLANE_COUNT];
+    for (u32 p = 0; p < Frustum::PLANE_COUNT; ++p) {
+        const glm::vec4 &plane = frustum.planes[p];
+        planeX[p] = _mm_set1_ps(plane.x);
+        planeY[p] = _mm_set1_ps(plane.y);
+        planeZ[p] = _mm_set1_ps(plane.z);
+        absX[p]   = _mm_set1_ps(std::abs(plane.x));
+        absY[p]   = _mm_set1_ps(std::abs(plane.y));
+        absZ[p]   = _mm_set1_ps(std::abs(plane.z));
+        planeW[p] = _mm_set1_ps(plane.w);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    for (; i < m_count; i += 4) {
+        const __m128 cx = _mm_loadu_ps(&m_centerX[i]);
+        const __m128 cy = _mm_loadu_ps(&m_centerY[i]);
+        const __m128 cz = _mm_loadu_ps(&m_centerZ[i]);
+        const __m128 ex = _mm_loadu_ps(&m_extentX[i]);
+        const __m128 ey = _mm_loadu_ps(&m_extentY[i]);
+        const __m128 ez = _mm_loadu_ps(&m_extentZ[i]);
+
+        __m128 outside = _mm_setzero_ps();
+        for (u32 p = 0; p < Frustum::PLANE_COUNT; ++p) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(planeX[p], cx), planeW[p]);
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeY[p], cy));
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeZ[p], cz));
+            __m128 radius = _mm_mul_ps(absX[p], ex);
+            radius = _mm_add_ps(radius, _mm_mul_ps(absY[p], ey));
+            radius = _mm_add_ps(radius, _mm_mul_ps(absZ[p], ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        const int mask = _mm_movemask_ps(outside);
+        const u32 lanes = std::min(4u, m_count - i);
+        for (u32 lane = 0; lane < lanes; ++lane) {
+            const u8 isVisible = ((mask >> lane) & 1) == 0;
+            visibility[i + lane] = isVisible;
+            visible += isVisible;
+        }
+    }
+#else
+    for (; i < m_count; ++i) {
+        const AABB box{
+            glm::vec3(m_centerX[i] - m_extentX[i], m_centerY[i] - m_extentY[i], m_centerZ[i] - m_extentZ[i]),
+            glm::vec3(m_centerX[i] + m_extentX[i], m_centerY[i] + m_extentY[i], m_centerZ[i] + m_extentZ[i]),
+        };
+        visibility[i] = frustum.intersects(box);
+        visible += visibility[i];
+    }
+#endif
+    return visible;
+}
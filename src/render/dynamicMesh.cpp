@@ -0,0 +1,127 @@
+#include "dust/render/dynamicMesh.hpp"
+
+#include "dust/core/log.hpp"
+#include "dust/core/profiling.hpp"
+#include "dust/render/renderAPI.hpp"
+
+#include <algorithm>
+
+namespace dr = dust::render;
+
+dr::DynamicMesh::DynamicMesh(const std::vector<Attribute> &attributes, u32 vertexCapacity, u32 indexCapacity)
+    : DynamicMesh(AttributeFormat(attributes), vertexCapacity, indexCapacity) {}
+
+dr::DynamicMesh::DynamicMesh(const VertexFormat &format, u32 vertexCapacity, u32 indexCapacity)
+    : Mesh(), m_stride(format.stride), m_vertexCapacity(std::max(vertexCapacity, 1u)), m_indexCapacity(indexCapacity),
+      m_vertexSize(0), m_indexSize(0), m_fullRange(true) {
+    DUST_PROFILE;
+
+    DUST_PROFILE_GPU("CreateVertexArrays (Dynamic)");
+    glCreateVertexArrays(1, &m_renderID);
+    if (m_renderID == 0) {
+        DUST_ERROR("[OpenGL][DynamicMesh] Failed to create VAO");
+        return;
+    }
+
+    // mutable storage, orphaned on full rewrites
+    glCreateBuffers(1, &m_vbo);
+    if (m_vbo == 0) {
+        DUST_ERROR("[OpenGL][DynamicMesh] Failed to create VBO");
+        return;
+    }
+    glNamedBufferData(m_vbo, m_vertexCapacity * m_stride, nullptr, GL_DYNAMIC_DRAW);
+
+    if (m_indexCapacity > 0) {
+        glCreateBuffers(1, &m_ebo);
+        if (m_ebo == 0) {
+            DUST_ERROR("[OpenGL][DynamicMesh] Failed to create EBO");
+            return;
+        }
+        glNamedBufferData(m_ebo, m_indexCapacity * sizeof(u32), nullptr, GL_DYNAMIC_DRAW);
+        glVertexArrayElementBuffer(m_renderID, m_ebo);
+    }
+
+    bindFormat(format);
+    DUST_DEBUG("[OpenGL] Created DynamicMesh {} ({} vertices, {} indices)", m_renderID, m_vertexCapacity,
+               m_indexCapacity);
+}
+
+void dr::DynamicMesh::updateVertices(u32 firstVertex, const void *vertices, u32 vertexCount) {
+    DUST_PROFILE;
+    if (vertexCount == 0) return;
+    Upload(m_vbo, m_vertexCapacity, m_stride, m_vertexSize, firstVertex, vertices, vertexCount);
+    if (m_fullRange) resetDrawRange();
+}
+
+void dr::DynamicMesh::updateIndices(u32 firstIndex, std::span<const u32> indices) {
+    DUST_PROFILE;
+    if (indices.empty()) return;
+    if (m_ebo == 0) {
+        DUST_ERROR("[DynamicMesh] {} was created without indices", m_renderID);
+        return;
+    }
+    Upload(m_ebo, m_indexCapacity, sizeof(u32), m_indexSize, firstIndex, indices.data(), indices.size());
+    if (m_fullRange) resetDrawRange();
+}
+
+void dr::DynamicMesh::setDrawRange(u32 first, u32 count) {
+    m_fullRange    = false;
+    m_firstElement = first;
+    if (m_ebo != 0) {
+        m_indexCount = std::min(count, m_indexSize - std::min(first, m_indexSize));
+    } else {
+        m_vertexCount = std::min(count, m_vertexSize - std::min(first, m_vertexSize));
+    }
+}
+
+void dr::DynamicMesh::resetDrawRange() {
+    m_fullRange    = true;
+    m_firstElement = 0;
+    m_indexCount   = m_indexSize;
+    m_vertexCount  = m_vertexSize;
+}
+
+u32 dr::DynamicMesh::getStride() const {
+    return m_stride;
+}
+u32 dr::DynamicMesh::getVertexCapacity() const {
+    return m_vertexCapacity;
+}
+u32 dr::DynamicMesh::getIndexCapacity() const {
+    return m_indexCapacity;
+}
+
+void dr::DynamicMesh::Upload(u32 buffer, u32 &capacity, u32 elementSize, u32 &written, u32 first,
+                             const void *data, u32 count) {
+    const u32 end          = first + count;
+    const bool fullRewrite = first == 0 && count >= written;
+
+    if (end > capacity) {
+        DUST_PROFILE_SECTION("DynamicMesh::grow");
+        u32 newCapacity = capacity;
+        while (newCapacity < end) newCapacity *= 2;
+        // the VAO keeps the buffer name: the kept content goes through a temporary copy
+        u32 copy = 0;
+        if (!fullRewrite && first > 0) {
+            glCreateBuffers(1, &copy);
+            glNamedBufferData(copy, first * elementSize, nullptr, GL_STREAM_COPY);
+            glCopyNamedBufferSubData(buffer, copy, 0, 0, first * elementSize);
+        }
+        glNamedBufferData(buffer, newCapacity * elementSize, nullptr, GL_DYNAMIC_DRAW);
+        if (copy != 0) {
+            glCopyNamedBufferSubData(copy, buffer, 0, 0, first * elementSize);
+            glDeleteBuffers(1, &copy);
+        }
+        capacity = newCapacity;
+        // only the copied prefix survives a growth
+        written = std::min(written, first);
+    } else if (fullRewrite) {
+        // orphan: the GPU keeps reading the previous storage
+        DUST_PROFILE_GPU("NamedBufferData (Orphan)");
+        glNamedBufferData(buffer, capacity * elementSize, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    DUST_PROFILE_GPU("NamedBufferSubData (Dynamic)");
+    glNamedBufferSubData(buffer, first * elementSize, count * elementSize, data);
+    written = fullRewrite ? count : std::max(written, end);
+}
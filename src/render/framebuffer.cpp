@@ -4,6 +4,7 @@
 #include "dust/core/profiling.hpp"
 #include "dust/core/types.hpp"
 #include "dust/core/window.hpp"
+#include "dust/render/glStateCache.hpp"
 #include "dust/render/renderAPI.hpp"
 
 #include <algorithm>
@@ -37,31 +38,6 @@ inline constexpr static u32 getGLAttachment(const drf::AttachmentType &type) {
     }
 }
 
-inline constexpr static u32 getGLFormat(const drf::AttachmentType &type) {
-    switch (type) {
-    case drf::AttachmentType::DEPTH:
-    case drf::AttachmentType::DEPTH32:
-        return GL_DEPTH_COMPONENT;
-
-    case drf::AttachmentType::STENCIL:
-        return GL_DEPTH_STENCIL;
-
-    case drf::AttachmentType::DEPTH_STENCIL:
-    case drf::AttachmentType::DEPTH32_STENCIL:
-        return GL_DEPTH_STENCIL;
-
-    case drf::AttachmentType::COLOR:
-        return GL_RGB;
-    case drf::AttachmentType::COLOR_RGBA:
-        return GL_RGBA;
-    case drf::AttachmentType::COLOR_SRGB:
-        return GL_SRGB;
-    case drf::AttachmentType::COLOR_HDR:
-        return GL_RGBA;
-    }
-    return 0;
-}
-
 inline constexpr static u32 getGLInternalFormat(const drf::AttachmentType &type) {
     switch (type) {
     case drf::AttachmentType::DEPTH:
@@ -76,43 +52,17 @@ inline constexpr static u32 getGLInternalFormat(const drf::AttachmentType &type)
         return GL_DEPTH32F_STENCIL8;
 
     case drf::AttachmentType::COLOR:
-        return GL_RGB;
+        return GL_RGB8;
     case drf::AttachmentType::COLOR_RGBA:
-        return GL_RGBA;
+        return GL_RGBA8;
     case drf::AttachmentType::COLOR_SRGB:
-        return GL_SRGB;
+        return GL_SRGB8;
     case drf::AttachmentType::COLOR_HDR:
         return GL_RGB16F;
     }
     return 0;
 }
 
-inline constexpr static u32 getGLType(const drf::AttachmentType &type) {
-    switch (type) {
-    case drf::AttachmentType::DEPTH:
-        return GL_FLOAT;
-    case drf::AttachmentType::DEPTH32:
-        return GL_DOUBLE;
-
-    case drf::AttachmentType::STENCIL:
-        return GL_UNSIGNED_BYTE;
-
-    case drf::AttachmentType::DEPTH_STENCIL:
-        return GL_FLOAT;
-    case drf::AttachmentType::DEPTH32_STENCIL:
-        return GL_DOUBLE;
-
-    case drf::AttachmentType::COLOR:
-    case drf::AttachmentType::COLOR_RGBA:
-    case drf::AttachmentType::COLOR_SRGB:
-        return GL_UNSIGNED_BYTE;
-    case drf::AttachmentType::COLOR_HDR:
-        return GL_FLOAT;
-    default:
-        return GL_INT;
-    }
-}
-
 #define ERROR_CASE(GL_ERROR)                                                                       \
     case GL_ERROR:                                                                                 \
         return #GL_ERROR
@@ -150,12 +100,11 @@ void drf::createInternal() {
     DUST_PROFILE_SECTION("Framebuffer::createInternal");
     DUST_PROFILE_GPU("Framebuffer creation");
     u32 renderID = 0;
-    glGenFramebuffers(1, &renderID);
+    glCreateFramebuffers(1, &renderID);
     if (renderID == 0) {
         DUST_ERROR("[OpenGL][Framebuffer] Failed to generate a framebuffer");
         return;
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, renderID);
 
     // attachments
     u32 colorAttachmentCount = 0;
@@ -167,47 +116,41 @@ void drf::createInternal() {
         }
 
         // texture
-        u32 format  = getGLFormat(attachment.type);
         u32 iformat = getGLInternalFormat(attachment.type);
         u32 binding = getGLAttachment(attachment.type) + (u32)newAttachment.index;
         if (attachment.isReadable) {
-            glGenTextures(1, &newAttachment.id);
+            glCreateTextures(GL_TEXTURE_2D, 1, &newAttachment.id);
             if (newAttachment.id == 0) {
                 DUST_ERROR("[OpenGL][Framebuffer] Failed to create texture.");
                 continue;
             }
-            glBindTexture(GL_TEXTURE_2D, newAttachment.id);
-            DUST_PROFILE_GPU("TexImage2D");
-            glTexImage2D(GL_TEXTURE_2D, 0, iformat, m_width, m_height, 0, format,
-                         getGLType(attachment.type), nullptr);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+            DUST_PROFILE_GPU("TextureStorage2D");
+            glTextureStorage2D(newAttachment.id, 1, iformat, m_width, m_height);
+            glTextureParameteri(newAttachment.id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTextureParameteri(newAttachment.id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTextureParameteri(newAttachment.id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+            glTextureParameteri(newAttachment.id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
             // avoid shadows outside
             if (attachment.type == AttachmentType::DEPTH ||
                 attachment.type == AttachmentType::DEPTH32) {
                 float borderColor[] = {1.0, 1.0, 1.0, 1.0};
-                glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+                glTextureParameterfv(newAttachment.id, GL_TEXTURE_BORDER_COLOR, borderColor);
             }
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, binding, GL_TEXTURE_2D, newAttachment.id, 0);
+            glNamedFramebufferTexture(renderID, binding, newAttachment.id, 0);
 
             DUST_DEBUG("[OpenGL][Framebuffer] Create texture {} [index {}]", newAttachment.id,
                        newAttachment.index);
         }
         // renderbuffer
         else {
-            glGenRenderbuffers(1, &newAttachment.id);
+            glCreateRenderbuffers(1, &newAttachment.id);
             if (newAttachment.id == 0) {
                 DUST_ERROR("[OpenGL][Framebuffer] Failed to create renderbuffer.");
                 continue;
             }
-            glBindRenderbuffer(GL_RENDERBUFFER, newAttachment.id);
-            DUST_PROFILE_GPU("RenderbufferStorage");
-            glRenderbufferStorage(GL_RENDERBUFFER, iformat, m_width, m_height);
-            glBindRenderbuffer(GL_RENDERBUFFER, 0);
-            glFramebufferRenderbuffer(GL_FRAMEBUFFER, binding, GL_RENDERBUFFER, newAttachment.id);
+            DUST_PROFILE_GPU("NamedRenderbufferStorage");
+            glNamedRenderbufferStorage(newAttachment.id, iformat, m_width, m_height);
+            glNamedFramebufferRenderbuffer(renderID, binding, GL_RENDERBUFFER, newAttachment.id);
             DUST_DEBUG("[OpenGL][Framebuffer] Create renderbuffer {}", newAttachment.id);
         }
         attachments.push_back(newAttachment);
@@ -215,12 +158,13 @@ void drf::createInternal() {
 
     // No color buffer
     if (colorAttachmentCount == 0) {
-        glDrawBuffer(GL_NONE);
-        glReadBuffer(GL_NONE);
+        glNamedFramebufferDrawBuffer(renderID, GL_NONE);
+        glNamedFramebufferReadBuffer(renderID, GL_NONE);
     }
 
     // Check state
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
+    const u32 status = glCheckNamedFramebufferStatus(renderID, GL_FRAMEBUFFER);
+    if (status == GL_FRAMEBUFFER_COMPLETE) {
         DUST_DEBUG("[OpenGL] Created framebuffer {}.", renderID);
         // check if there was a previous framebuffer generated
         if (m_renderID != 0) {
@@ -234,26 +178,21 @@ void drf::createInternal() {
         m_attachments          = attachments;
         m_renderID             = renderID;
     } else {
-        DUST_ERROR("[OpenGL] Error while creating framebuffer {}: {}", renderID, getGLErrorType(glGetError()));
+        DUST_ERROR("[OpenGL] Error while creating framebuffer {}: {}", renderID, getGLErrorType(status));
         deleteInternal(renderID, attachments);
     }
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void drf::deleteInternal(u32 renderID, const std::vector<Attachment> &attachments) {
     DUST_PROFILE;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
     for (auto attachment : attachments) {
         if (attachment.isReadable) {
-            glDeleteTextures(1, &attachment.id);
+            GLStateCache::DeleteTexture(attachment.id);
         } else {
             glDeleteRenderbuffers(1, &attachment.id);
         }
     }
-    glDeleteFramebuffers(1, &renderID);
+    GLStateCache::DeleteFramebuffer(renderID);
 }
 
 drf::~Framebuffer() {
@@ -261,42 +200,19 @@ drf::~Framebuffer() {
     deleteInternal(m_renderID, m_attachments);
 }
 
-void drf::resize(u32 width, u32 height, bool recreate) {
+void drf::resize(u32 width, u32 height) {
     DUST_PROFILE;
     m_width  = width;
     m_height = height;
-    if (recreate) {
-        createInternal();
-        return;
-    }
-
-    // else resize all attachments
-    bind();
-    for (auto attachment : m_attachments) {
-        u32 format = getGLFormat(attachment.type);
-        if (attachment.isReadable) {
-            glBindTexture(GL_TEXTURE_2D, attachment.id);
-            DUST_PROFILE_GPU("TexImage2D");
-            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE,
-                         NULL);
-            glBindTexture(GL_TEXTURE_2D, 0);
-        } else {
-            glBindRenderbuffer(GL_RENDERBUFFER, attachment.id);
-            DUST_PROFILE_GPU("RenderbufferStorage");
-            glRenderbufferStorage(GL_RENDERBUFFER, format, width, height);
-            glBindRenderbuffer(GL_RENDERBUFFER, 0);
-        }
-    }
-    unbind();
+    // attachments have an immutable storage
+    createInternal();
 }
 
 void drf::bind() {
-    DUST_PROFILE_GPU("BindFramebuffer");
-    glBindFramebuffer(GL_FRAMEBUFFER, m_renderID);
+    GLStateCache::BindFramebuffer(m_renderID);
 }
 void drf::unbind() {
-    DUST_PROFILE_GPU("BindFramebuffer");
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLStateCache::BindFramebuffer(0);
 }
 
 u32 drf::getWidth() const { return m_width; }
@@ -320,7 +236,6 @@ void drf::bindAttachment(u32 bindIndex, AttachmentType type, u32 index) {
     decltype(auto) found = this->getAttachment(type, index);
     if (found.has_value() && found.value().isReadable) {
         // DUST_DEBUG("[Framebuffer] Binding texture to {}", bindIndex);
-        glActiveTexture(GL_TEXTURE0 + bindIndex);
-        glBindTexture(GL_TEXTURE_2D, found.value().id);
+        GLStateCache::BindTexture(bindIndex, GL_TEXTURE_2D, found.value().id);
     }
 }
@@ -0,0 +1,124 @@
+#include "dust/render/geometryArena.hpp"
+
+#include "dust/core/log.hpp"
+#include "dust/core/profiling.hpp"
+#include "dust/render/glStateCache.hpp"
+#include "dust/render/renderAPI.hpp"
+
+#include <algorithm>
+
+namespace dr = dust::render;
+
+/// Create a buffer of `size` bytes, copying the first `used` bytes of `previous`
+/// 0 on failure, the previous buffer is then kept
+static u32 reallocateBuffer(u32 previous, u32 size, u32 used) {
+    u32 buffer = 0;
+    glCreateBuffers(1, &buffer);
+    if (buffer == 0) {
+        DUST_ERROR("[OpenGL][GeometryArena] Failed to create buffer");
+        return 0;
+    }
+    DUST_PROFILE_GPU("NamedBufferStorage (Arena)");
+    glNamedBufferStorage(buffer, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    if (previous != 0) {
+        if (used > 0) glCopyNamedBufferSubData(previous, buffer, 0, 0, used);
+        glDeleteBuffers(1, &previous);
+    }
+    return buffer;
+}
+
+dr::GeometryArena::GeometryArena(const std::vector<Attribute> &attributes, u32 vertexCapacity,
+                                 u32 indexCapacity)
+    : GeometryArena(AttributeFormat(attributes), vertexCapacity, indexCapacity) {}
+
+dr::GeometryArena::GeometryArena(const VertexFormat &format, u32 vertexCapacity, u32 indexCapacity)
+    : m_renderID(0), m_vbo(0), m_ebo(0), m_stride(format.stride), m_vertexCapacity(0), m_indexCapacity(0),
+      m_vertexCount(0), m_indexCount(0) {
+    DUST_PROFILE;
+    glCreateVertexArrays(1, &m_renderID);
+    if (m_renderID == 0) {
+        DUST_ERROR("[OpenGL][GeometryArena] Failed to create VAO");
+        return;
+    }
+    format.apply(m_renderID);
+
+    growVertices(std::max(vertexCapacity, 1u));
+    growIndices(std::max(indexCapacity, 1u));
+    DUST_DEBUG("[OpenGL] Created GeometryArena {} ({} vertices, {} indices)", m_renderID, m_vertexCapacity,
+               m_indexCapacity);
+}
+
+dr::GeometryArena::~GeometryArena() {
+    DUST_PROFILE;
+    GLStateCache::DeleteVertexArray(m_renderID);
+    if (m_vbo) glDeleteBuffers(1, &m_vbo);
+    if (m_ebo) glDeleteBuffers(1, &m_ebo);
+}
+
+dr::GeometryRange dr::GeometryArena::allocate(const void *vertices, u32 vertexCount,
+                                              const std::vector<u32> &indices) {
+    DUST_PROFILE;
+    const u32 indexCount = indices.size();
+    if (m_vertexCount + vertexCount > m_vertexCapacity) {
+        u32 capacity = std::max(m_vertexCapacity, 1u);
+        while (capacity < m_vertexCount + vertexCount) capacity *= 2;
+        if (!growVertices(capacity)) return GeometryRange{};
+    }
+    if (m_indexCount + indexCount > m_indexCapacity) {
+        u32 capacity = std::max(m_indexCapacity, 1u);
+        while (capacity < m_indexCount + indexCount) capacity *= 2;
+        if (!growIndices(capacity)) return GeometryRange{};
+    }
+
+    const GeometryRange range{m_vertexCount, vertexCount, m_indexCount, indexCount};
+    DUST_PROFILE_GPU("NamedBufferSubData (Arena)");
+    glNamedBufferSubData(m_vbo, range.baseVertex * m_stride, vertexCount * m_stride, vertices);
+    if (indexCount > 0) {
+        glNamedBufferSubData(m_ebo, range.firstIndex * sizeof(u32), indexCount * sizeof(u32), indices.data());
+    }
+    m_vertexCount += vertexCount;
+    m_indexCount += indexCount;
+    return range;
+}
+
+void dr::GeometryArena::reset() {
+    m_vertexCount = 0;
+    m_indexCount  = 0;
+}
+
+void dr::GeometryArena::bind() const {
+    GLStateCache::BindVertexArray(m_renderID);
+}
+
+bool dr::GeometryArena::growVertices(u32 capacity) {
+    DUST_PROFILE_SECTION("GeometryArena::growVertices");
+    const u32 vbo = reallocateBuffer(m_vbo, capacity * m_stride, m_vertexCount * m_stride);
+    if (vbo == 0) return false;
+    m_vbo            = vbo;
+    m_vertexCapacity = capacity;
+    glVertexArrayVertexBuffer(m_renderID, 0, m_vbo, 0, m_stride);
+    return true;
+}
+
+bool dr::GeometryArena::growIndices(u32 capacity) {
+    DUST_PROFILE_SECTION("GeometryArena::growIndices");
+    const u32 ebo = reallocateBuffer(m_ebo, capacity * sizeof(u32), m_indexCount * sizeof(u32));
+    if (ebo == 0) return false;
+    m_ebo           = ebo;
+    m_indexCapacity = capacity;
+    glVertexArrayElementBuffer(m_renderID, m_ebo);
+    return true;
+}
+
+u32 dr::GeometryArena::getRenderID() const {
+    return m_renderID;
+}
+u32 dr::GeometryArena::getStride() const {
+    return m_stride;
+}
+u32 dr::GeometryArena::getVertexCount() const {
+    return m_vertexCount;
+}
+u32 dr::GeometryArena::getIndexCount() const {
+    return m_indexCount;
+}
@@ -0,0 +1,191 @@
+#include "dust/render/glStateCache.hpp"
+
+#include "dust/core/profiling.hpp"
+#include "dust/render/renderAPI.hpp"
+
+namespace dr = dust::render;
+
+bool dr::GLStateCache::Changed(u32 &cached, u32 value) {
+    if (cached == value) {
+        ++s_counters.skipped;
+        return false;
+    }
+    cached = value;
+    ++s_counters.issued;
+    return true;
+}
+
+void dr::GLStateCache::SetCapability(u32 &cached, u32 capability, bool enabled) {
+    if (!Changed(cached, enabled ? 1u : 0u)) return;
+    if (enabled) {
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+}
+
+u32 dr::GLStateCache::TargetIndex(u32 target) {
+    switch (target) {
+    case GL_TEXTURE_2D:       return Texture2D;
+    case GL_TEXTURE_2D_ARRAY: return Texture2DArray;
+    case GL_TEXTURE_CUBE_MAP: return TextureCubeMap;
+    default:                  return TextureTargetCount;
+    }
+}
+
+void dr::GLStateCache::UseProgram(u32 program) {
+    if (!Changed(s_program, program)) return;
+    DUST_PROFILE_GPU("UseProgram");
+    glUseProgram(program);
+}
+
+void dr::GLStateCache::BindVertexArray(u32 vertexArray) {
+    if (!Changed(s_vertexArray, vertexArray)) return;
+    glBindVertexArray(vertexArray);
+}
+
+void dr::GLStateCache::BindTexture(u32 unit, u32 target, u32 texture) {
+    const u32 targetIndex = TargetIndex(target);
+    // uncached target or unit, always issue
+    if (unit >= MAX_TEXTURE_UNITS || targetIndex == TextureTargetCount) {
+        s_activeUnit = unit;
+        s_counters.issued += 2;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        return;
+    }
+
+    if (!Changed(s_textures[unit][targetIndex], texture)) return;
+    if (s_activeUnit != unit) {
+        s_activeUnit = unit;
+        ++s_counters.issued;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    DUST_PROFILE_GPU("BindTexture");
+    glBindTexture(target, texture);
+}
+
+void dr::GLStateCache::BindFramebuffer(u32 framebuffer) {
+    if (!Changed(s_framebuffer, framebuffer)) return;
+    DUST_PROFILE_GPU("BindFramebuffer");
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void dr::GLStateCache::SetDepthTest(bool enabled) {
+    SetCapability(s_depthTest, GL_DEPTH_TEST, enabled);
+}
+
+void dr::GLStateCache::SetDepthWrite(bool enabled) {
+    if (!Changed(s_depthWrite, enabled ? 1u : 0u)) return;
+    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void dr::GLStateCache::SetDepthFunc(u32 func) {
+    if (!Changed(s_depthFunc, func)) return;
+    glDepthFunc(func);
+}
+
+void dr::GLStateCache::SetDepthClamp(bool enabled) {
+    SetCapability(s_depthClamp, GL_DEPTH_CLAMP, enabled);
+}
+
+void dr::GLStateCache::SetCulling(bool enabled) {
+    SetCapability(s_culling, GL_CULL_FACE, enabled);
+}
+
+void dr::GLStateCache::SetCullFace(u32 face) {
+    if (!Changed(s_cullFace, face)) return;
+    glCullFace(face);
+}
+
+void dr::GLStateCache::SetBlending(bool enabled) {
+    SetCapability(s_blending, GL_BLEND, enabled);
+}
+
+void dr::GLStateCache::SetBlendFunc(u32 src, u32 dst) {
+    if (s_blendSrc == src && s_blendDst == dst) {
+        ++s_counters.skipped;
+        return;
+    }
+    s_blendSrc = src;
+    s_blendDst = dst;
+    ++s_counters.issued;
+    glBlendFunc(src, dst);
+}
+
+void dr::GLStateCache::SetPolygonMode(u32 mode) {
+    if (!Changed(s_polygonMode, mode)) return;
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void dr::GLStateCache::DeleteProgram(u32 program) {
+    if (program == 0) return;
+    if (s_program == program) {
+        UseProgram(0);
+    }
+    glDeleteProgram(program);
+}
+
+void dr::GLStateCache::DeleteVertexArray(u32 vertexArray) {
+    if (vertexArray == 0) return;
+    // deleting a bound vertex array reverts the binding to 0
+    if (s_vertexArray == vertexArray) {
+        s_vertexArray = 0;
+    }
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+void dr::GLStateCache::DeleteTexture(u32 texture) {
+    if (texture == 0) return;
+    // deleted textures are unbound from every unit
+    for (auto &unit : s_textures) {
+        for (auto &bound : unit) {
+            if (bound == texture) bound = 0;
+        }
+    }
+    glDeleteTextures(1, &texture);
+}
+
+void dr::GLStateCache::DeleteFramebuffer(u32 framebuffer) {
+    if (framebuffer == 0) return;
+    if (s_framebuffer == framebuffer) {
+        s_framebuffer = 0;
+    }
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+void dr::GLStateCache::Invalidate() {
+    s_program     = UNKNOWN;
+    s_vertexArray = UNKNOWN;
+    s_framebuffer = UNKNOWN;
+    s_activeUnit  = UNKNOWN;
+    for (auto &unit : s_textures) {
+        unit.fill(UNKNOWN);
+    }
+
+    s_depthTest   = UNKNOWN;
+    s_depthWrite  = UNKNOWN;
+    s_depthFunc   = UNKNOWN;
+    s_depthClamp  = UNKNOWN;
+    s_culling     = UNKNOWN;
+    s_cullFace    = UNKNOWN;
+    s_blending    = UNKNOWN;
+    s_blendSrc    = UNKNOWN;
+    s_blendDst    = UNKNOWN;
+    s_polygonMode = UNKNOWN;
+}
+
+void dr::GLStateCache::NewFrame() {
+    DUST_PROFILE_VALUE("GL calls issued", static_cast<int64_t>(s_counters.issued));
+    DUST_PROFILE_VALUE("GL calls skipped", static_cast<int64_t>(s_counters.skipped));
+    s_lastFrame = s_counters;
+    s_counters  = Counters{};
+}
+
+const dr::GLStateCache::Counters &dr::GLStateCache::GetCounters() {
+    return s_counters;
+}
+
+const dr::GLStateCache::Counters &dr::GLStateCache::GetLastFrameCounters() {
+    return s_lastFrame;
+}
@@ -0,0 +1,137 @@
+#include "dust/render/indirectBatch.hpp"
+
+#include "dust/core/log.hpp"
+#include "dust/core/profiling.hpp"
+#include "dust/render/glStateCache.hpp"
+#include "dust/render/materialTable.hpp"
+#include "dust/render/renderAPI.hpp"
+#include "dust/render/streamBuffer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace dr = dust::render;
+
+static_assert(sizeof(dr::DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand must match the GL layout");
+static_assert(sizeof(dr::IndirectDrawData) == 80, "IndirectDrawData must match its std430 layout");
+
+dr::IndirectBatch::IndirectBatch(u32 capacity)
+    : m_commandBuffer(0), m_drawBuffer(0), m_capacity(0), m_commands(), m_draws(), m_order(),
+      m_sortedCommands(), m_sortedDraws() {
+    DUST_PROFILE;
+    glCreateBuffers(1, &m_commandBuffer);
+    glCreateBuffers(1, &m_drawBuffer);
+    if (m_commandBuffer == 0 || m_drawBuffer == 0) {
+        DUST_ERROR("[OpenGL][IndirectBatch] Failed to create buffers");
+        return;
+    }
+    reserve(std::max(capacity, 1u));
+    DUST_DEBUG("[OpenGL] Created IndirectBatch {} ({} draws)", m_commandBuffer, m_capacity);
+}
+
+dr::IndirectBatch::~IndirectBatch() {
+    DUST_PROFILE;
+    if (m_commandBuffer) glDeleteBuffers(1, &m_commandBuffer);
+    if (m_drawBuffer) glDeleteBuffers(1, &m_drawBuffer);
+}
+
+void dr::IndirectBatch::push(const GeometryRange &range, const glm::mat4 &transform, u32 materialID) {
+    if (range.indexCount == 0) return;
+    m_commands.push_back(DrawElementsIndirectCommand{
+        .count         = range.indexCount,
+        .instanceCount = 1,
+        .firstIndex    = range.firstIndex,
+        .baseVertex    = (i32)range.baseVertex,
+        .baseInstance  = 0,
+    });
+    m_draws.push_back(IndirectDrawData{.transform = transform, .materialID = materialID, ._padding = {}});
+}
+
+void dr::IndirectBatch::submit(const GeometryArena &arena, const Shader *shader) {
+    DUST_PROFILE;
+    if (m_commands.empty()) return;
+    sort();
+    const u32 count = m_order.size();
+
+    // written straight in the mapped stream buffer, draws after the commands in one allocation:
+    // either both fit or the region is left untouched
+    StreamAllocation allocation;
+    u32 drawsOffset = 0;
+    if (auto *stream = StreamBuffer::Get()) {
+        const u32 alignment = stream->getStorageAlignment();
+        drawsOffset = (count * sizeof(DrawElementsIndirectCommand) + alignment - 1) / alignment * alignment;
+        allocation  = stream->allocate(drawsOffset + count * sizeof(IndirectDrawData), alignment);
+    }
+
+    u32 commandBuffer = m_commandBuffer;
+    u32 commandOffset = 0;
+    if (allocation) {
+        u8 *data = static_cast<u8 *>(allocation.data);
+        gather((DrawElementsIndirectCommand *)data, (IndirectDrawData *)(data + drawsOffset));
+        commandBuffer = StreamBuffer::Get()->getRenderID();
+        commandOffset = allocation.offset;
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, INDIRECT_DRAW_BINDING, commandBuffer,
+                          allocation.offset + drawsOffset, count * sizeof(IndirectDrawData));
+    } else {
+        if (count > m_capacity) {
+            u32 capacity = m_capacity;
+            while (capacity < count) capacity *= 2;
+            reserve(capacity);
+        }
+        m_sortedCommands.resize(count);
+        m_sortedDraws.resize(count);
+        gather(m_sortedCommands.data(), m_sortedDraws.data());
+        DUST_PROFILE_GPU("NamedBufferSubData (Indirect)");
+        glNamedBufferSubData(m_commandBuffer, 0, count * sizeof(DrawElementsIndirectCommand),
+                             m_sortedCommands.data());
+        glNamedBufferSubData(m_drawBuffer, 0, count * sizeof(IndirectDrawData), m_sortedDraws.data());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INDIRECT_DRAW_BINDING, m_drawBuffer);
+    }
+
+    if (auto *table = MaterialTable::Get()) table->bindTextureArrays();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    shader->use();
+    arena.bind();
+    {
+        DUST_PROFILE_GPU("MultiDrawElementsIndirect");
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void *)(uintptr_t)commandOffset, count, 0);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    clear();
+}
+
+void dr::IndirectBatch::clear() {
+    m_commands.clear();
+    m_draws.clear();
+}
+
+u32 dr::IndirectBatch::getDrawCount() const {
+    return m_commands.size();
+}
+
+void dr::IndirectBatch::sort() {
+    DUST_PROFILE_SECTION("IndirectBatch::sort");
+    const u32 count = m_commands.size();
+    m_order.resize(count);
+    for (u32 i = 0; i < count; ++i) m_order[i] = i;
+    // by material, then by range: neighbouring draws read neighbouring geometry
+    std::sort(m_order.begin(), m_order.end(), [&](u32 a, u32 b) {
+        if (m_draws[a].materialID != m_draws[b].materialID) return m_draws[a].materialID < m_draws[b].materialID;
+        return m_commands[a].firstIndex < m_commands[b].firstIndex;
+    });
+}
+
+void dr::IndirectBatch::gather(DrawElementsIndirectCommand *commands, IndirectDrawData *draws) const {
+    DUST_PROFILE_SECTION("IndirectBatch::gather");
+    for (u32 i = 0; i < m_order.size(); ++i) {
+        commands[i] = m_commands[m_order[i]];
+        draws[i]    = m_draws[m_order[i]];
+    }
+}
+
+void dr::IndirectBatch::reserve(u32 capacity) {
+    DUST_PROFILE_GPU("NamedBufferData (Indirect)");
+    m_capacity = capacity;
+    glNamedBufferData(m_commandBuffer, m_capacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
+    glNamedBufferData(m_drawBuffer, m_capacity * sizeof(IndirectDrawData), nullptr, GL_DYNAMIC_DRAW);
+}
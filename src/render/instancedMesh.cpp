@@ -0,0 +1,145 @@
+#include "dust/render/instancedMesh.hpp"
+
+#include "dust/core/log.hpp"
+#include "dust/core/profiling.hpp"
+#include "dust/render/glStateCache.hpp"
+#include "dust/render/renderAPI.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace dr = dust::render;
+
+static_assert(sizeof(dr::InstanceData) == 96, "InstanceData must stay tightly packed");
+
+/**********************************************************/
+// InstanceBuffer
+
+dr::InstanceBuffer::InstanceBuffer(u32 capacity)
+    : m_renderID(0), m_capacity(std::max(capacity, 1u)), m_instances(), m_dirty(false) {
+    DUST_PROFILE;
+    m_instances.reserve(m_capacity);
+    glCreateBuffers(1, &m_renderID);
+    if (m_renderID == 0) {
+        DUST_ERROR("[OpenGL][InstanceBuffer] Failed to create buffer");
+        return;
+    }
+    DUST_PROFILE_GPU("NamedBufferData (Instances)");
+    // mutable storage: the buffer keeps its name when it grows, attached vertex arrays stay valid
+    glNamedBufferData(m_renderID, m_capacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+    DUST_DEBUG("[OpenGL] Created InstanceBuffer {} ({} instances)", m_renderID, m_capacity);
+}
+
+dr::InstanceBuffer::~InstanceBuffer() {
+    DUST_PROFILE;
+    if (m_renderID) glDeleteBuffers(1, &m_renderID);
+}
+
+u32 dr::InstanceBuffer::add(const InstanceData &instance) {
+    m_instances.push_back(instance);
+    m_dirty = true;
+    return m_instances.size() - 1;
+}
+
+void dr::InstanceBuffer::set(u32 index, const InstanceData &instance) {
+    if (index >= m_instances.size()) {
+        DUST_ERROR("[InstanceBuffer] Instance {} out of range ({})", index, m_instances.size());
+        return;
+    }
+    m_instances[index] = instance;
+    m_dirty            = true;
+}
+
+const dr::InstanceData &dr::InstanceBuffer::get(u32 index) const {
+    return m_instances.at(index);
+}
+
+void dr::InstanceBuffer::clear() {
+    m_instances.clear();
+    m_dirty = true;
+}
+
+void dr::InstanceBuffer::upload() {
+    if (!m_dirty) return;
+    DUST_PROFILE;
+    m_dirty = false;
+    if (m_instances.empty()) return;
+
+    const u32 size = m_instances.size() * sizeof(InstanceData);
+    if (m_instances.size() > m_capacity) {
+        while (m_capacity < m_instances.size()) m_capacity *= 2;
+        DUST_PROFILE_GPU("NamedBufferData (Instances)");
+        glNamedBufferData(m_renderID, m_capacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+    }
+    DUST_PROFILE_GPU("NamedBufferSubData (Instances)");
+    glNamedBufferSubData(m_renderID, 0, size, m_instances.data());
+}
+
+void dr::InstanceBuffer::attach(u32 vertexArray) const {
+    DUST_PROFILE_GPU("InstanceAttributes");
+    glVertexArrayVertexBuffer(vertexArray, INSTANCE_BUFFER_BINDING, m_renderID, 0, sizeof(InstanceData));
+    glVertexArrayBindingDivisor(vertexArray, INSTANCE_BUFFER_BINDING, 1);
+
+    const auto attribute = [&](u32 location) {
+        glEnableVertexArrayAttrib(vertexArray, location);
+        glVertexArrayAttribBinding(vertexArray, location, INSTANCE_BUFFER_BINDING);
+    };
+    // transform (one vec4 per column)
+    for (u32 column = 0; column < 4; ++column) {
+        const u32 location = INSTANCE_ATTRIBUTE_LOCATION + column;
+        attribute(location);
+        glVertexArrayAttribFormat(vertexArray, location, 4, GL_FLOAT, GL_FALSE,
+                                  offsetof(InstanceData, transform) + column * sizeof(glm::vec4));
+    }
+    // color
+    attribute(INSTANCE_ATTRIBUTE_LOCATION + 4);
+    glVertexArrayAttribFormat(vertexArray, INSTANCE_ATTRIBUTE_LOCATION + 4, 4, GL_FLOAT, GL_FALSE,
+                              offsetof(InstanceData, color));
+    // material id
+    attribute(INSTANCE_ATTRIBUTE_LOCATION + 5);
+    glVertexArrayAttribIFormat(vertexArray, INSTANCE_ATTRIBUTE_LOCATION + 5, 1, GL_UNSIGNED_INT,
+                               offsetof(InstanceData, materialID));
+}
+
+u32 dr::InstanceBuffer::getCount() const {
+    return m_instances.size();
+}
+u32 dr::InstanceBuffer::getCapacity() const {
+    return m_capacity;
+}
+u32 dr::InstanceBuffer::getRenderID() const {
+    return m_renderID;
+}
+
+/**********************************************************/
+// InstancedMesh
+
+dr::InstancedMesh::InstancedMesh(MeshPtr mesh, u32 capacity)
+    : m_mesh(mesh), m_instances(capacity) {
+    DUST_PROFILE;
+    m_instances.attach(m_mesh->getRenderID());
+}
+
+dr::InstanceBuffer &dr::InstancedMesh::getInstances() {
+    return m_instances;
+}
+
+dr::MeshPtr dr::InstancedMesh::getMesh() const {
+    return m_mesh;
+}
+
+void dr::InstancedMesh::draw(const Shader *shader) {
+    DUST_PROFILE;
+    if (m_mesh->isHidden()) return;
+    m_instances.upload();
+    if (m_instances.getCount() == 0) return;
+
+    m_mesh->bindMaterials();
+    shader->use();
+    // instanced meshes of the same mesh share its VAO: point its instance binding at this stream
+    glVertexArrayVertexBuffer(m_mesh->getRenderID(), INSTANCE_BUFFER_BINDING, m_instances.getRenderID(), 0,
+                              sizeof(InstanceData));
+    GLStateCache::BindVertexArray(m_mesh->getRenderID());
+    m_mesh->drawGeometryInstanced(m_instances.getCount());
+    m_mesh->unbindMaterials();
+}
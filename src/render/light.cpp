@@ -3,17 +3,28 @@
 #include "dust/core/profiling.hpp"
 #include "dust/core/types.hpp"
 #include "dust/render/camera.hpp"
-#include "dust/render/shader.hpp"
+#include "dust/render/cascadeShadowMap.hpp"
 
+#include "glm/ext/matrix_clip_space.hpp"
 #include "glm/ext/matrix_transform.hpp"
 #include "glm/geometric.hpp"
-#include <format>
+
+#include <algorithm>
+#include <cmath>
 
 namespace dr = dust::render;
 
+/// near plane of a local light projection, positive even for a zero range (far plane: max(range, .1))
+static f32 NearPlane(f32 range)
+{
+    return std::clamp(range * .5f, .001f, .05f);
+}
+
 dr::Light::Light()
-: m_proj(1.f),
-m_view(1.f) 
+: m_dirty(true),
+m_proj(1.f),
+m_view(1.f),
+m_viewProj(1.f)
 { }
 
 glm::mat4 dr::Light::getView() const
@@ -38,7 +49,9 @@ glm::mat4 dr::Light::getViewProjMat(bool forceUpdate)
 dr::DirectionnalLight::DirectionnalLight(glm::vec3 direction, glm::vec3 color)
 : Light(),
 m_color(color),
-m_direction(direction) 
+m_direction(direction),
+m_shadowDistance(100.f),
+m_shadowResolution(DUST_SHADOW_MAP_SIZE)
 {
     updateRenderPos();
 }
@@ -46,13 +59,18 @@ m_direction(direction)
 dr::DirectionnalLight::~DirectionnalLight() {}
 
 
-void dr::DirectionnalLight::bind(ShaderPtr shader, u32 index) const
+dr::LightEntry dr::DirectionnalLight::getLightEntry() const
 {
-    DUST_PROFILE;
-    std::string loc = std::format("uLights[{}]", index);
-    shader->setUniform(loc + ".type", 0);
-    shader->setUniform(loc + ".direction", m_direction);
-    shader->setUniform(loc + ".color", m_color);
+    return LightEntry {
+        .position  = glm::vec4(0.f, 0.f, 0.f, LIGHT_DIRECTIONAL),
+        .direction = glm::vec4(m_direction, 0.f),
+        .color     = glm::vec4(m_color, 1.f),
+        .cone      = glm::vec4(0.f)
+    };
+}
+dr::LightType dr::DirectionnalLight::getType() const
+{
+    return LIGHT_DIRECTIONAL;
 }
 
 glm::vec3 dr::DirectionnalLight::getDirection() const
@@ -72,64 +90,151 @@ void dr::DirectionnalLight::setColor(glm::vec3 color)
 {
     m_color = color;
 }
+void dr::DirectionnalLight::setShadowRange(f32 distance, u32 resolution)
+{
+    m_shadowDistance   = std::max(distance, 0.f);
+    m_shadowResolution = std::max(resolution, 1u);
+    m_dirty = true;
+}
 
 void dr::DirectionnalLight::updateRenderPos()
 {
     DUST_PROFILE;
-    // DUST_PROFILE_SECTION("DirectionnalLight::updateRenderPos");
     const auto camera = Camera::GetActive();
     if(!camera) return;
-    const dr::CameraFrustrum frustrum = camera->getFrustrum();
-    // calculate bounding box
-
-    // calculate view matrix
-    {
-        glm::vec3 center = glm::vec3(0, 0, 0);
-        // const glm::vec4* it = &frustrum.nearTopRight;
-        // for(u16 i = 0; i < 8; ++i, it++)
-        // {
-        //     center += glm::vec3(*it);
-        // }
-        // center *= 0.125f; // divide by 8
-
-        // update ligth view
-        m_view = glm::lookAt(
-            center + (m_direction * 10.f),
-            center,
-            glm::vec3(0.0f, 1.0f, 0.0f)
-        );
-    }
+    // stable projection fitted to the camera frustum up to the shadow distance
+    const f32 near = camera->getNear();
+    const f32 far  = camera->getFar();
+    const f32 distance = m_shadowDistance > 0.f ? std::min(m_shadowDistance, far) : far;
+    const f32 slice = far > near ? (distance - near) / (far - near) : 1.f;
+    const ShadowCascade cascade = CascadeShadowMap::FitCascade(camera->getFrustrum(), 0.f, slice, m_direction, m_shadowResolution,
+                                                               AABB{}, DUST_SHADOW_CENTER_STEP);
+
+    // without depth clamping, the depth range is extended toward the light to keep the casters outside of the view
+    const f32 radius = cascade.texelSize * m_shadowResolution * .5f;
+    m_view = cascade.view;
+    m_proj = glm::ortho(-radius, radius, -radius, radius, -distance, 2.f * radius);
+    m_proj[3].x = cascade.proj[3].x;
+    m_proj[3].y = cascade.proj[3].y;
+    m_viewProj = m_proj * m_view;
+}
 
-    // calculate projection matrix
-    {
-        // f32 minX = std::numeric_limits<f32>::max();
-        // f32 maxX = std::numeric_limits<f32>::lowest();
-        // f32 minY = std::numeric_limits<f32>::max();
-        // f32 maxY = std::numeric_limits<f32>::lowest();
-        // f32 minZ = std::numeric_limits<f32>::max();
-        // f32 maxZ = std::numeric_limits<f32>::lowest();
-        // const glm::vec4* it = &frustrum.nearTopRight;
-        // for(u16 i = 0; i < 8; ++i, it++)
-        // {
-        //     const auto trf = m_view * (*it);
-        //     minX = std::min(minX, trf.x);
-        //     maxX = std::max(maxX, trf.x);
-        //     minY = std::min(minY, trf.y);
-        //     maxY = std::max(maxY, trf.y);
-        //     minZ = std::min(minZ, trf.z);
-        //     maxZ = std::max(maxZ, trf.z);
-        // }
-
-        // // Tune this parameter according to the scene
-        // constexpr float zMult = 10.0f;
-        // if (minZ < 0) minZ *= zMult;
-        // else          minZ /= zMult;
-
-        // if (maxZ < 0) maxZ /= zMult;
-        // else          maxZ *= zMult;
-        // m_proj = glm::ortho(minX, maxX, minY, maxY, minZ, maxZ);
-        m_proj = glm::ortho(-20.f, 20.f, -20.f, 20.f, 1.f, 10.f);
-    }
 
+dr::PointLight::PointLight(glm::vec3 position, glm::vec3 color, f32 range)
+: Light(),
+m_position(position),
+m_color(color),
+m_range(std::max(range, 0.f))
+{
+    updateRenderPos();
+}
+
+void dr::PointLight::updateRenderPos()
+{
+    m_view = glm::translate(glm::mat4(1.f), -m_position);
+    m_proj = glm::perspective(glm::radians(90.f), 1.f, NearPlane(m_range), std::max(m_range, .1f));
     m_viewProj = m_proj * m_view;
-}
\ No newline at end of file
+}
+
+dr::LightEntry dr::PointLight::getLightEntry() const
+{
+    return LightEntry {
+        .position  = glm::vec4(m_position, LIGHT_POINT),
+        .direction = glm::vec4(0.f, 0.f, 0.f, m_range),
+        .color     = glm::vec4(m_color, 1.f),
+        .cone      = glm::vec4(0.f)
+    };
+}
+dr::LightType dr::PointLight::getType() const
+{
+    return LIGHT_POINT;
+}
+
+glm::vec3 dr::PointLight::getPosition() const
+{
+    return m_position;
+}
+glm::vec3 dr::PointLight::getColor() const
+{
+    return m_color;
+}
+f32 dr::PointLight::getRange() const
+{
+    return m_range;
+}
+void dr::PointLight::setPosition(glm::vec3 position)
+{
+    m_position = position;
+    m_dirty = true;
+}
+void dr::PointLight::setColor(glm::vec3 color)
+{
+    m_color = color;
+}
+void dr::PointLight::setRange(f32 range)
+{
+    m_range = std::max(range, 0.f);
+    m_dirty = true;
+}
+
+
+dr::SpotLight::SpotLight(glm::vec3 position, glm::vec3 direction, glm::vec3 color, f32 range, f32 innerAngle,
+                         f32 outerAngle)
+: PointLight(position, color, range),
+m_direction(glm::normalize(direction)),
+m_innerAngle(0.f),
+m_outerAngle(0.f)
+{
+    setAngles(innerAngle, outerAngle);
+    updateRenderPos();
+}
+
+void dr::SpotLight::updateRenderPos()
+{
+    // looking down the cone
+    const glm::vec3 up = std::abs(m_direction.y) > .99f ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f);
+    m_view = glm::lookAt(m_position, m_position + m_direction, up);
+    m_proj = glm::perspective(std::max(2.f * m_outerAngle, .01f), 1.f, NearPlane(m_range),
+                              std::max(m_range, .1f));
+    m_viewProj = m_proj * m_view;
+}
+
+dr::LightEntry dr::SpotLight::getLightEntry() const
+{
+    const f32 cosInner = std::cos(m_innerAngle);
+    const f32 cosOuter = std::cos(m_outerAngle);
+    return LightEntry {
+        .position  = glm::vec4(m_position, LIGHT_SPOT),
+        .direction = glm::vec4(m_direction, m_range),
+        .color     = glm::vec4(m_color, 1.f),
+        .cone      = glm::vec4(cosOuter, 1.f / std::max(cosInner - cosOuter, 1e-4f), 0.f, 0.f)
+    };
+}
+dr::LightType dr::SpotLight::getType() const
+{
+    return LIGHT_SPOT;
+}
+
+glm::vec3 dr::SpotLight::getDirection() const
+{
+    return m_direction;
+}
+f32 dr::SpotLight::getInnerAngle() const
+{
+    return m_innerAngle;
+}
+f32 dr::SpotLight::getOuterAngle() const
+{
+    return m_outerAngle;
+}
+void dr::SpotLight::setDirection(glm::vec3 direction)
+{
+    m_direction = glm::normalize(direction);
+    m_dirty = true;
+}
+void dr::SpotLight::setAngles(f32 innerAngle, f32 outerAngle)
+{
+    m_outerAngle = std::clamp(outerAngle, 0.f, glm::radians(89.f));
+    m_innerAngle = std::clamp(innerAngle, 0.f, m_outerAngle);
+    m_dirty = true;
+}
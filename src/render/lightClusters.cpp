@@ -0,0 +1,328 @@
+#include "dust/render/lightClusters.hpp"
+
+#include "dust/core/log.hpp"
+#include "dust/core/profiling.hpp"
+#include "dust/render/camera.hpp"
+#include "dust/render/culling.hpp"
+#include "dust/render/light.hpp"
+#include "dust/render/renderAPI.hpp"
+#include "dust/render/streamBuffer.hpp"
+
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define DUST_CLUSTERS_SSE
+#endif
+
+namespace dr = dust::render;
+
+/// clusters of a depth slice
+constexpr u32 SLICE_SIZE = dr::LightClusters::SIZE_X * dr::LightClusters::SIZE_Y;
+
+dr::LightClusters::LightClusters(u32 threadCount)
+    : m_workers(threadCount), m_lights(), m_spheres(), m_minX(COUNT), m_minY(COUNT), m_minZ(COUNT), m_maxX(COUNT),
+      m_maxY(COUNT), m_maxZ(COUNT), m_proj(0.f), m_near(0.f), m_far(0.f), m_sliceLights(SIZE_Z),
+      m_sliceMasks(SIZE_Z), m_sliceIndices(SIZE_Z), m_grid(COUNT * 2, 0), m_indices(), m_lightBuffer(0),
+      m_lightCapacity(0), m_gridBuffer(0), m_gridCapacity(0), m_indexBuffer(0), m_indexCapacity(0), m_data(),
+      m_stats() {
+    DUST_DEBUG("[LightClusters] {}x{}x{} clusters, {} workers", SIZE_X, SIZE_Y, SIZE_Z, threadCount);
+}
+
+dr::LightClusters::~LightClusters() {
+    DUST_PROFILE;
+    for (u32 buffer : {m_lightBuffer, m_gridBuffer, m_indexBuffer}) {
+        if (buffer) glDeleteBuffers(1, &buffer);
+    }
+}
+
+void dr::LightClusters::clear() {
+    m_lights.clear();
+}
+
+u32 dr::LightClusters::push(const Light &light) {
+    return push(light.getLightEntry());
+}
+
+u32 dr::LightClusters::push(const LightEntry &light) {
+    if (static_cast<u32>(light.position.w) == LIGHT_DIRECTIONAL) return m_lights.size();
+    m_lights.push_back(light);
+    return m_lights.size() - 1;
+}
+
+void dr::LightClusters::build(const Camera &camera) {
+    DUST_PROFILE_SECTION("LightClusters::build");
+    const glm::mat4 proj = camera.getProj();
+    const f32 near       = camera.getNear();
+    const f32 far        = std::max(camera.getFar(), near * 1.001f);
+    if (proj != m_proj || near != m_near || far != m_far) buildFroxels(proj, near, far);
+
+    // slice = log(depth) * scale + bias, exponential between near and far
+    const f32 scale = SIZE_Z / std::log(far / near);
+    const f32 bias  = -std::log(near) * scale;
+    m_data.size     = glm::uvec4(SIZE_X, SIZE_Y, SIZE_Z, m_lights.size());
+    m_data.depth    = glm::vec4(near, far, scale, bias);
+
+    m_stats = Stats{.lights = (u32)m_lights.size(), .visible = 0, .indices = 0, .maxPerCluster = 0};
+    for (auto &lights : m_sliceLights) lights.clear();
+
+    const glm::mat4 view = camera.getView();
+    const Frustum &frustum = camera.getFrustum();
+    m_spheres.resize(m_lights.size());
+    for (u32 i = 0; i < m_lights.size(); ++i) {
+        const glm::vec4 sphere = BoundingSphere(m_lights[i]);
+        const glm::vec3 center(sphere);
+        const bool outside = std::any_of(frustum.planes.begin(), frustum.planes.end(), [&](const glm::vec4 &plane) {
+            return glm::dot(glm::vec3(plane), center) + plane.w < -sphere.w;
+        });
+        const glm::vec3 viewCenter(view * glm::vec4(center, 1.f));
+        m_spheres[i] = glm::vec4(viewCenter, outside ? -1.f : sphere.w);
+        if (outside) continue;
+
+        ++m_stats.visible;
+        const f32 depth = -viewCenter.z;
+        const u32 first = Slice(std::max(depth - sphere.w, near), scale, bias);
+        const u32 last  = Slice(std::min(depth + sphere.w, far), scale, bias);
+        for (u32 slice = first; slice <= last; ++slice) m_sliceLights[slice].push_back(i);
+    }
+
+    m_workers.dispatch(SIZE_Z, [&](u32 slice) { buildSlice(slice); });
+
+    // slices are contiguous in the grid: their indices follow each other
+    m_indices.clear();
+    for (u32 slice = 0; slice < SIZE_Z; ++slice) {
+        const u32 base = m_indices.size();
+        for (u32 cluster = slice * SLICE_SIZE; cluster < (slice + 1) * SLICE_SIZE; ++cluster) {
+            m_grid[cluster * 2] += base;
+            m_stats.maxPerCluster = std::max(m_stats.maxPerCluster, m_grid[cluster * 2 + 1]);
+        }
+        m_indices.insert(m_indices.end(), m_sliceIndices[slice].begin(), m_sliceIndices[slice].end());
+    }
+    m_stats.indices = m_indices.size();
+}
+
+void dr::LightClusters::buildSlice(u32 slice) {
+    const auto &lights = m_sliceLights[slice];
+    auto &masks        = m_sliceMasks[slice];
+    masks.assign(lights.size() * SIZE_Y, 0u);
+
+    // sphere against 4 froxels of a row at a time: distance from the center to the box
+    const u32 first = Index(0, 0, slice);
+    for (u32 l = 0; l < lights.size(); ++l) {
+        const glm::vec4 &sphere = m_spheres[lights[l]];
+        const f32 radius2       = sphere.w * sphere.w;
+        for (u32 y = 0; y < SIZE_Y; ++y) {
+            const u32 row = first + y * SIZE_X;
+            u32 mask      = 0;
+#ifdef DUST_CLUSTERS_SSE
+            const __m128 cx = _mm_set1_ps(sphere.x), cy = _mm_set1_ps(sphere.y), cz = _mm_set1_ps(sphere.z);
+            const __m128 r2 = _mm_set1_ps(radius2);
+            const __m128 zero = _mm_setzero_ps();
+            for (u32 x = 0; x < SIZE_X; x += 4) {
+                const u32 i = row + x;
+                const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minX[i]), cx),
+                                                        _mm_sub_ps(cx, _mm_loadu_ps(&m_maxX[i]))), zero);
+                const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minY[i]), cy),
+                                                        _mm_sub_ps(cy, _mm_loadu_ps(&m_maxY[i]))), zero);
+                const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&m_minZ[i]), cz),
+                                                        _mm_sub_ps(cz, _mm_loadu_ps(&m_maxZ[i]))), zero);
+                const __m128 distance2 =
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                mask |= (u32)_mm_movemask_ps(_mm_cmple_ps(distance2, r2)) << x;
+            }
+#else
+            for (u32 x = 0; x < SIZE_X; ++x) {
+                const u32 i = row + x;
+                const glm::vec3 center(sphere);
+                const glm::vec3 closest = glm::clamp(center, glm::vec3(m_minX[i], m_minY[i], m_minZ[i]),
+                                                     glm::vec3(m_maxX[i], m_maxY[i], m_maxZ[i]));
+                const glm::vec3 offset = center - closest;
+                if (glm::dot(offset, offset) <= radius2) mask |= 1u << x;
+            }
+#endif
+            masks[l * SIZE_Y + y] = mask;
+        }
+    }
+
+    // counting sort of the light indices by cluster
+    u32 *grid = &m_grid[first * 2];
+    for (u32 cluster = 0; cluster < SLICE_SIZE; ++cluster) grid[cluster * 2 + 1] = 0;
+    for (u32 l = 0; l < lights.size(); ++l) {
+        for (u32 y = 0; y < SIZE_Y; ++y) {
+            for (u32 mask = masks[l * SIZE_Y + y]; mask != 0; mask &= mask - 1) {
+                ++grid[(y * SIZE_X + std::countr_zero(mask)) * 2 + 1];
+            }
+        }
+    }
+    u32 offset = 0;
+    for (u32 cluster = 0; cluster < SLICE_SIZE; ++cluster) {
+        grid[cluster * 2] = offset;
+        offset += grid[cluster * 2 + 1];
+    }
+
+    auto &indices = m_sliceIndices[slice];
+    indices.resize(offset);
+    std::array<u32, SLICE_SIZE> cursors;
+    for (u32 cluster = 0; cluster < SLICE_SIZE; ++cluster) cursors[cluster] = grid[cluster * 2];
+    // lights stay sorted by index inside a cluster
+    for (u32 l = 0; l < lights.size(); ++l) {
+        for (u32 y = 0; y < SIZE_Y; ++y) {
+            for (u32 mask = masks[l * SIZE_Y + y]; mask != 0; mask &= mask - 1) {
+                indices[cursors[y * SIZE_X + std::countr_zero(mask)]++] = lights[l];
+            }
+        }
+    }
+}
+
+void dr::LightClusters::buildFroxels(const glm::mat4 &proj, f32 near, f32 far) {
+    DUST_PROFILE_SECTION("LightClusters::buildFroxels");
+    m_proj = proj;
+    m_near = near;
+    m_far  = far;
+
+    // view space line of every tile corner, between the near and far planes
+    const glm::mat4 inverse = glm::inverse(proj);
+    const auto unproject    = [&](f32 x, f32 y, f32 z) {
+        const glm::vec4 point = inverse * glm::vec4(x, y, z, 1.f);
+        return glm::vec3(point) / point.w;
+    };
+    std::vector<glm::vec3> nearCorners((SIZE_X + 1) * (SIZE_Y + 1)), farCorners(nearCorners.size());
+    for (u32 y = 0; y <= SIZE_Y; ++y) {
+        for (u32 x = 0; x <= SIZE_X; ++x) {
+            const f32 ndcX = -1.f + 2.f * x / SIZE_X;
+            const f32 ndcY = -1.f + 2.f * y / SIZE_Y;
+            nearCorners[y * (SIZE_X + 1) + x] = unproject(ndcX, ndcY, -1.f);
+            farCorners[y * (SIZE_X + 1) + x]  = unproject(ndcX, ndcY, 1.f);
+        }
+    }
+    // point of a corner line at a view depth
+    const auto corner = [&](u32 x, u32 y, f32 depth) {
+        const glm::vec3 &a = nearCorners[y * (SIZE_X + 1) + x];
+        const glm::vec3 &b = farCorners[y * (SIZE_X + 1) + x];
+        const f32 t        = b.z != a.z ? (-depth - a.z) / (b.z - a.z) : 0.f;
+        return a + (b - a) * t;
+    };
+
+    for (u32 z = 0; z < SIZE_Z; ++z) {
+        const f32 sliceNear = near * std::pow(far / near, (f32)z / SIZE_Z);
+        const f32 sliceFar  = near * std::pow(far / near, (f32)(z + 1) / SIZE_Z);
+        for (u32 y = 0; y < SIZE_Y; ++y) {
+            for (u32 x = 0; x < SIZE_X; ++x) {
+                AABB box{};
+                for (u32 c = 0; c < 4; ++c) {
+                    box.extend(corner(x + (c & 1), y + (c >> 1), sliceNear));
+                    box.extend(corner(x + (c & 1), y + (c >> 1), sliceFar));
+                }
+                const u32 i = Index(x, y, z);
+                m_minX[i] = box.min.x;
+                m_minY[i] = box.min.y;
+                m_minZ[i] = box.min.z;
+                m_maxX[i] = box.max.x;
+                m_maxY[i] = box.max.y;
+                m_maxZ[i] = box.max.z;
+            }
+        }
+    }
+}
+
+void dr::LightClusters::upload() {
+    DUST_PROFILE_GPU("LightClusters::upload");
+    // empty blocks are still bound to a valid range
+    const u32 lightSize = std::max<u32>(m_lights.size(), 1) * sizeof(LightEntry);
+    const u32 gridSize  = m_grid.size() * sizeof(u32);
+    const u32 indexSize = std::max<u32>(m_indices.size(), 1) * sizeof(u32);
+
+    StreamAllocation lights, grid, indices;
+    if (auto *stream = StreamBuffer::Get()) {
+        const u32 alignment = stream->getStorageAlignment();
+        lights = stream->allocate(lightSize, alignment);
+        if (lights) grid = stream->allocate(gridSize, alignment);
+        if (grid) indices = stream->allocate(indexSize, alignment);
+    }
+
+    if (lights && grid && indices) {
+        if (!m_lights.empty()) std::memcpy(lights.data, m_lights.data(), m_lights.size() * sizeof(LightEntry));
+        std::memcpy(grid.data, m_grid.data(), gridSize);
+        if (!m_indices.empty()) std::memcpy(indices.data, m_indices.data(), m_indices.size() * sizeof(u32));
+        const u32 stream = StreamBuffer::Get()->getRenderID();
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, LIGHT_LIST_BINDING, stream, lights.offset, lights.size);
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, CLUSTER_GRID_BINDING, stream, grid.offset, grid.size);
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, CLUSTER_INDEX_BINDING, stream, indices.offset, indices.size);
+        return;
+    }
+    uploadBuffer(m_lightBuffer, m_lightCapacity, LIGHT_LIST_BINDING, m_lights.data(),
+                 m_lights.size() * sizeof(LightEntry));
+    uploadBuffer(m_gridBuffer, m_gridCapacity, CLUSTER_GRID_BINDING, m_grid.data(), gridSize);
+    uploadBuffer(m_indexBuffer, m_indexCapacity, CLUSTER_INDEX_BINDING, m_indices.data(),
+                 m_indices.size() * sizeof(u32));
+}
+
+void dr::LightClusters::uploadBuffer(u32 &buffer, u32 &capacity, u32 binding, const void *data, u32 size) {
+    if (buffer == 0 || size > capacity) {
+        const u32 newCapacity = std::max({size, capacity * 2, 256u});
+        u32 renderID          = 0;
+        glCreateBuffers(1, &renderID);
+        if (renderID == 0) {
+            DUST_ERROR("[OpenGL][LightClusters] Failed to create buffer");
+            return;
+        }
+        glNamedBufferStorage(renderID, newCapacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        if (buffer) glDeleteBuffers(1, &buffer);
+        DUST_DEBUG("[OpenGL] LightClusters buffer {} resized to {} bytes", renderID, newCapacity);
+        buffer   = renderID;
+        capacity = newCapacity;
+    }
+    if (size > 0) {
+        DUST_PROFILE_GPU("NamedBufferSubData (Clusters)");
+        glNamedBufferSubData(buffer, 0, size, data);
+    }
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, buffer, 0, std::max(size, 16u));
+}
+
+dr::ClusterData dr::LightClusters::getClusterData() const {
+    return m_data;
+}
+
+std::span<const u32> dr::LightClusters::getClusterLights(u32 x, u32 y, u32 z) const {
+    if (x >= SIZE_X || y >= SIZE_Y || z >= SIZE_Z) return {};
+    const u32 cluster = Index(x, y, z);
+    return std::span<const u32>(m_indices).subspan(m_grid[cluster * 2], m_grid[cluster * 2 + 1]);
+}
+
+std::span<const dr::LightEntry> dr::LightClusters::getLights() const {
+    return m_lights;
+}
+
+const dr::LightClusters::Stats &dr::LightClusters::getStats() const {
+    return m_stats;
+}
+
+u32 dr::LightClusters::Slice(f32 depth, f32 scale, f32 bias) {
+    if (depth <= 0.f) return 0;
+    const f32 slice = std::floor(std::log(depth) * scale + bias);
+    return (u32)std::clamp(slice, 0.f, (f32)(SIZE_Z - 1));
+}
+
+glm::vec4 dr::LightClusters::BoundingSphere(const LightEntry &light) {
+    const glm::vec3 position(light.position);
+    const f32 range = light.direction.w;
+    if (static_cast<u32>(light.position.w) != LIGHT_SPOT) return glm::vec4(position, range);
+
+    // smallest sphere around the cone
+    const glm::vec3 direction = glm::normalize(glm::vec3(light.direction));
+    const f32 cosAngle        = std::clamp(light.cone.x, 0.f, 1.f);
+    if (cosAngle < .70710678f) {
+        // wide cone: the sphere of its base
+        return glm::vec4(position + direction * range * cosAngle, range * std::sqrt(1.f - cosAngle * cosAngle));
+    }
+    const f32 radius = range / (2.f * std::max(cosAngle, 1e-4f));
+    return glm::vec4(position + direction * radius, radius);
+}
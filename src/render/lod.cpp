@@ -0,0 +1,292 @@
+#include "dust/render/lod.hpp"
+
+#include "dust/core/profiling.hpp"
+
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace dr = dust::render;
+
+constexpr u32 NO_VERTEX = std::numeric_limits<u32>::max();
+/// a level must remove at least this fraction of the triangles of the previous one
+constexpr f32 MIN_LOD_REDUCTION = .1f;
+
+/**
+ * @brief Symmetric 4x4 quadric (area weighted sum of squared plane distances)
+ */
+struct Quadric {
+    f64 a00, a01, a02, a11, a12, a22;
+    f64 b0, b1, b2;
+    f64 c;
+    f64 weight;
+
+    static Quadric FromPlane(glm::vec3 normal, f32 distance, f32 weight) {
+        const f64 x = normal.x, y = normal.y, z = normal.z, d = distance, w = weight;
+        return Quadric{w * x * x, w * x * y, w * x * z, w * y * y, w * y * z, w * z * z,
+                       w * d * x, w * d * y, w * d * z, w * d * d, w};
+    }
+
+    Quadric &operator+=(const Quadric &other) {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02;
+        a11 += other.a11; a12 += other.a12; a22 += other.a22;
+        b0 += other.b0; b1 += other.b1; b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+        return *this;
+    }
+
+    /// squared distance, averaged by the weight
+    [[nodiscard]] f64 evaluate(glm::vec3 p) const {
+        const f64 x = p.x, y = p.y, z = p.z;
+        const f64 error = a00 * x * x + a11 * y * y + a22 * z * z
+                        + 2. * (a01 * x * y + a02 * x * z + a12 * y * z)
+                        + 2. * (b0 * x + b1 * y + b2 * z) + c;
+        return weight > 0. ? std::max(error, 0.) / weight : 0.;
+    }
+};
+
+struct Collapse {
+    u32 from;
+    u32 to;
+    f64 cost;
+};
+
+/**
+ * @brief Position of each vertex, vertices sharing a position are mapped to the first one
+ */
+static std::vector<u32>
+BuildPositionRemap(std::span<const glm::vec3> positions)
+{
+    struct Hash {
+        size_t operator()(const std::array<u32, 3> &key) const {
+            return (key[0] * 73856093u) ^ (key[1] * 19349663u) ^ (key[2] * 83492791u);
+        }
+    };
+    std::unordered_map<std::array<u32, 3>, u32, Hash> firstVertex{};
+    firstVertex.reserve(positions.size());
+    std::vector<u32> remap(positions.size());
+    for (u32 v = 0; v < positions.size(); ++v) {
+        std::array<u32, 3> key{};
+        std::memcpy(key.data(), &positions[v], sizeof(key));
+        remap[v] = firstVertex.try_emplace(key, v).first->second;
+    }
+    return remap;
+}
+
+std::vector<u32> dr::MeshSimplifier::Simplify(std::span<const glm::vec3> positions, std::span<const u32> indices,
+                                              u32 targetIndexCount, f32 &error) {
+    DUST_PROFILE_SECTION("MeshSimplifier::Simplify");
+    const u32 vertexCount = positions.size();
+    std::vector<u32> result(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+    f64 maxCost = 0.;
+    error = 0.f;
+
+    const std::vector<u32> remap = BuildPositionRemap(positions);
+    std::vector<Quadric> quadrics(vertexCount, Quadric{});
+    std::vector<u8> locked(vertexCount, 0);
+    {
+        // seams: several vertices at the same position
+        std::vector<u32> users(vertexCount, NO_VERTEX);
+        for (const u32 index : result) {
+            const u32 position = remap[index];
+            if (users[position] == NO_VERTEX) users[position] = index;
+            else if (users[position] != index) locked[position] = 1;
+        }
+
+        // borders and non manifold edges: not shared by exactly 2 triangles
+        std::unordered_map<u64, u32> edges{};
+        edges.reserve(result.size());
+        for (u32 i = 0; i < result.size(); i += 3) {
+            for (u32 e = 0; e < 3; ++e) {
+                const u32 a = remap[result[i + e]], b = remap[result[i + (e + 1) % 3]];
+                ++edges[((u64)std::min(a, b) << 32) | std::max(a, b)];
+            }
+        }
+        for (const auto &[edge, count] : edges) {
+            if (count == 2) continue;
+            locked[edge >> 32]        = 1;
+            locked[edge & 0xFFFFFFFF] = 1;
+        }
+
+        for (u32 i = 0; i < result.size(); i += 3) {
+            const glm::vec3 &p0 = positions[result[i]];
+            const glm::vec3 normal = glm::cross(positions[result[i + 1]] - p0, positions[result[i + 2]] - p0);
+            const f32 length = glm::length(normal);
+            if (length <= 0.f) continue;
+            const glm::vec3 unit = normal / length;
+            const Quadric quadric = Quadric::FromPlane(unit, -glm::dot(unit, p0), length * .5f);
+            for (u32 v = 0; v < 3; ++v) quadrics[remap[result[i + v]]] += quadric;
+        }
+    }
+
+    std::vector<Collapse> collapses{};
+    std::vector<u32> collapseTo(vertexCount, NO_VERTEX);
+    std::vector<u8> touched(vertexCount, 0);
+    std::vector<u32> adjacencyOffsets{}, adjacency{};
+    while (result.size() > targetIndexCount) {
+        const u32 triangleCount = result.size() / 3;
+
+        // triangles of each vertex
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for (const u32 index : result) ++adjacencyOffsets[index + 1];
+        for (u32 v = 0; v < vertexCount; ++v) adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        adjacency.resize(result.size());
+        {
+            std::vector<u32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (u32 i = 0; i < result.size(); ++i) adjacency[fill[result[i]]++] = i / 3;
+        }
+
+        // every half edge collapse of an unlocked vertex
+        collapses.clear();
+        for (u32 i = 0; i < result.size(); i += 3) {
+            for (u32 e = 0; e < 3; ++e) {
+                const u32 a = result[i + e], b = result[i + (e + 1) % 3];
+                const u32 ra = remap[a], rb = remap[b];
+                if (ra == rb) continue;
+                Quadric quadric = quadrics[ra];
+                quadric += quadrics[rb];
+                if (!locked[ra]) collapses.push_back({a, b, quadric.evaluate(positions[b])});
+                if (!locked[rb]) collapses.push_back({b, a, quadric.evaluate(positions[a])});
+            }
+        }
+        if (collapses.empty()) break;
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse &l, const Collapse &r) { return l.cost < r.cost; });
+
+        // cheapest independent collapses, a collapse removes about 2 triangles
+        const u32 budget = (triangleCount - targetIndexCount / 3) / 2 + 1;
+        u32 applied = 0;
+        std::fill(touched.begin(), touched.end(), 0);
+        for (const auto &collapse : collapses) {
+            if (applied >= budget) break;
+            const u32 from = collapse.from, to = collapse.to;
+            if (touched[remap[from]] || touched[remap[to]]) continue;
+
+            // reject collapses flipping a triangle
+            bool flips = false;
+            for (u32 a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1] && !flips; ++a) {
+                const u32 *triangle = &result[adjacency[a] * 3];
+                glm::vec3 before[3], after[3];
+                bool collapsed = false;
+                for (u32 v = 0; v < 3; ++v) {
+                    before[v] = after[v] = positions[triangle[v]];
+                    if (triangle[v] == from) after[v] = positions[to];
+                    else collapsed |= remap[triangle[v]] == remap[to];
+                }
+                if (collapsed) continue;
+                const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                const glm::vec3 normalAfter  = glm::cross(after[1] - after[0], after[2] - after[0]);
+                flips = glm::dot(normalBefore, normalAfter) <= 0.f;
+            }
+            if (flips) continue;
+
+            collapseTo[from] = to;
+            quadrics[remap[to]] += quadrics[remap[from]];
+            maxCost = std::max(maxCost, collapse.cost);
+            // the neighbourhood is left untouched until the next pass
+            for (u32 a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; ++a) {
+                for (u32 v = 0; v < 3; ++v) touched[remap[result[adjacency[a] * 3 + v]]] = 1;
+            }
+            ++applied;
+        }
+        if (applied == 0) break;
+
+        // move the indices and drop the degenerate triangles
+        u32 kept = 0;
+        for (u32 i = 0; i < result.size(); i += 3) {
+            u32 triangle[3];
+            for (u32 v = 0; v < 3; ++v) {
+                const u32 index = result[i + v];
+                triangle[v] = collapseTo[index] != NO_VERTEX ? collapseTo[index] : index;
+            }
+            const u32 r0 = remap[triangle[0]], r1 = remap[triangle[1]], r2 = remap[triangle[2]];
+            if (r0 == r1 || r1 == r2 || r2 == r0) continue;
+            std::copy(triangle, triangle + 3, result.begin() + kept);
+            kept += 3;
+        }
+        result.resize(kept);
+        for (const auto &collapse : collapses) collapseTo[collapse.from] = NO_VERTEX;
+    }
+
+    error = static_cast<f32>(std::sqrt(maxCost));
+    return result;
+}
+
+std::vector<dr::MeshLOD> dr::MeshSimplifier::BuildLODs(std::span<const glm::vec3> positions,
+                                                       std::vector<u32> &indices, u32 lodCount) {
+    DUST_PROFILE_SECTION("MeshSimplifier::BuildLODs");
+    std::vector<MeshLOD> lods{MeshLOD{0, static_cast<u32>(indices.size()), 0.f}};
+    if (indices.size() / 3 < DUST_LOD_MIN_TRIANGLES) return lods;
+
+    std::vector<u32> current(indices);
+    f32 error = 0.f;
+    for (u32 level = 1; level < lodCount; ++level) {
+        const u32 target = current.size() / 6 * 3;
+        f32 levelError = 0.f;
+        std::vector<u32> simplified = Simplify(positions, current, target, levelError);
+        if (simplified.empty() || simplified.size() > current.size() * (1.f - MIN_LOD_REDUCTION)) break;
+        // simplified from the previous level: the errors add up
+        error += levelError;
+        lods.push_back(MeshLOD{static_cast<u32>(indices.size()), static_cast<u32>(simplified.size()), error});
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        current = std::move(simplified);
+    }
+    return lods;
+}
+
+dr::LODSelector::LODSelector()
+    : m_viewPosition(0.f), m_projectionScale(0.f), m_maxError(1.f), m_hysteresis(.25f) {
+}
+
+void dr::LODSelector::setViewPosition(glm::vec3 position) {
+    m_viewPosition = position;
+}
+
+void dr::LODSelector::setProjection(f32 projectionScale, f32 maxError, f32 hysteresis) {
+    m_projectionScale = std::max(projectionScale, 0.f);
+    m_maxError        = std::max(maxError, 1e-3f);
+    m_hysteresis      = std::clamp(hysteresis, 0.f, .9f);
+}
+
+bool dr::LODSelector::isEnabled() const {
+    return m_projectionScale > 0.f;
+}
+
+f32 dr::LODSelector::getScreenError(const MeshLOD &lod, const glm::mat4 &model, const AABB &bounds) const {
+    if (lod.error <= 0.f) return 0.f;
+    const f32 scale = std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])),
+                                glm::length(glm::vec3(model[2]))});
+    // distance to the closest point of the bounds
+    f32 distance = 0.f;
+    if (bounds.isValid()) {
+        const AABB world = bounds.transformed(model);
+        distance = glm::length(glm::max(glm::max(world.min - m_viewPosition, m_viewPosition - world.max), glm::vec3(0.f)));
+    } else {
+        distance = glm::length(glm::vec3(model[3]) - m_viewPosition);
+    }
+    if (distance <= 1e-4f) return std::numeric_limits<f32>::max();
+    return lod.error * scale * m_projectionScale / distance;
+}
+
+u32 dr::LODSelector::select(std::span<const MeshLOD> lods, const glm::mat4 &model, const AABB &bounds,
+                            u32 previous) const {
+    if (!isEnabled() || lods.size() < 2) return 0;
+    const f32 coarser = m_maxError * (1.f - m_hysteresis);
+    const f32 finer   = m_maxError * (1.f + m_hysteresis);
+    u32 level = std::min<u32>(previous, lods.size() - 1);
+    while (level + 1 < lods.size() && getScreenError(lods[level + 1], model, bounds) <= coarser) ++level;
+    while (level > 0 && getScreenError(lods[level], model, bounds) > finer) --level;
+    return level;
+}
+
+f32 dr::LODSelector::ProjectionScale(const glm::mat4 &proj, f32 viewportHeight) {
+    // proj[1][1] = 1 / tan(fov / 2)
+    return proj[1][1] * viewportHeight * .5f;
+}
@@ -4,21 +4,20 @@
 #include "dust/render/shader.hpp"
 #include "dust/core/profiling.hpp"
 #include "dust/render/mesh.hpp"
+#include "dust/render/materialTable.hpp"
 #include "glm/ext/vector_float4.hpp"
-#include <format>
 
 
 namespace dr = dust::render;
 
-static std::string shaderMaterialLoc(u32 index) {
-    DUST_PROFILE;
-    return std::format("uMaterials[{}]", index);
+static dust::StringID shaderMaterialLoc(u32 index) {
+    return dust::StringID("uMaterials").index(index);
 }
 
 /*********************************************************/
 
 dr::Material::Material()
-: m_boundSlot(0), m_name("Material") {}
+: m_id(s_nextID++), m_boundSlot(0), m_name("Material"), m_transparent(false), m_dirty(true) {}
 
 void dr::Material::setName(const std::string &name)
 {
@@ -29,10 +28,50 @@ std::string dr::Material::getName() const
     return m_name;
 }
 
+u32 dr::Material::getID() const
+{
+    return m_id;
+}
+
+void dr::Material::setTransparent(bool transparent)
+{
+    m_transparent = transparent;
+    m_dirty = true;
+}
+bool dr::Material::isTransparent() const
+{
+    return m_transparent;
+}
+
+void dr::Material::markDirty()
+{
+    m_dirty = true;
+}
+
+void dr::Material::upload()
+{
+    updateRecord(m_boundSlot);
+}
+
+void dr::Material::updateRecord(u32 slot)
+{
+    if(!m_dirty && slot == m_boundSlot) return;
+    DUST_PROFILE;
+    m_boundSlot = slot;
+    m_dirty = false;
+
+    auto table = MaterialTable::Get();
+    if(table == nullptr) return;
+    MaterialRecord record = getRecord();
+    record.textureSlot = slot;
+    if(m_transparent) record.flags |= MATERIAL_TRANSPARENT;
+    table->update(m_id, record);
+}
+
 /*********************************************************/
 
 dr::ColorMaterial::ColorMaterial(glm::vec3 color)
-: color({1.f, 1.f, 1.f}) 
+: color(color) 
 { }
 dr::ColorMaterial::ColorMaterial() 
 : ColorMaterial({1.f, 1.f, 1.f}) { }
@@ -45,18 +84,19 @@ void dr::ColorMaterial::SetupMaterialShader(Shader *shader)
 void dr::ColorMaterial::bind(u32 slot)   
 {
     DUST_PROFILE;
-    m_boundSlot = slot;
-    const std::string loc = shaderMaterialLoc(slot);
-    s_shader->setUniform(loc + ".exist", true);
-    s_shader->setUniform(loc + ".diffuse", glm::vec4{color, 1.f});
-    s_shader->setUniform(loc + ".specular", glm::vec4{color, 1.f});
-    s_shader->setUniform(loc + ".ambient", glm::vec4{color, 1.f});
+    updateRecord(slot);
+    // primitives have no per vertex material id
+    s_shader->setUniform("uMaterialID", (int)m_id);
 }
 void dr::ColorMaterial::unbind() 
+{ }
+dr::MaterialRecord dr::ColorMaterial::getRecord() const
 {
-    DUST_PROFILE;
-    const std::string loc = shaderMaterialLoc(m_boundSlot);
-    s_shader->setUniform(loc + ".exist", false);
+    MaterialRecord record{};
+    record.albedo = glm::vec4(color, 1.f);
+    record.params = glm::vec4(0.f, 1.f, 1.f, 0.f);
+    record.flags  = MATERIAL_EXIST;
+    return record;
 }
 
 /*********************************************************/
@@ -67,27 +107,27 @@ void dr::TextureMaterial::SetupMaterialShader(Shader* shader)
 { 
     s_shader = shader;
     for(int slot = 0; slot < DUST_MATERIAL_SLOTS; ++slot) {
-        const std::string loc = shaderMaterialLoc(slot);
-        s_shader->setUniform(loc + ".albedo", (int)(slot * MAX_MATERIAL_TEXTURE_COUNT));
+        s_shader->setUniform(shaderMaterialLoc(slot).append(".texAlbedo"), (int)(slot * MAX_MATERIAL_TEXTURE_COUNT));
     }
 }
 void dr::TextureMaterial::bind(u32 slot)
 {
     DUST_PROFILE;
-    m_boundSlot = slot;
-    const std::string loc = shaderMaterialLoc(slot);
-    s_shader->setUniform(loc + ".exist", true);
-    texture->bind(0);
-    s_shader->setUniform(loc + ".albedo", (int)(slot * MAX_MATERIAL_TEXTURE_COUNT));
+    updateRecord(slot);
+    texture->bind(slot * MAX_MATERIAL_TEXTURE_COUNT);
+    // primitives have no per vertex material id
+    s_shader->setUniform("uMaterialID", (int)m_id);
 }
 
 void dr::TextureMaterial::unbind()
+{ }
+dr::MaterialRecord dr::TextureMaterial::getRecord() const
 {
-    DUST_PROFILE;
-    const std::string loc = shaderMaterialLoc(m_boundSlot);
-    texture->unbind();
-    s_shader->setUniform("uHasMaterial", false);
-    s_shader->setUniform("uMaterial.texture", (int)(m_boundSlot * MAX_MATERIAL_TEXTURE_COUNT));
+    MaterialRecord record{};
+    record.albedo = glm::vec4(1.f);
+    record.params = glm::vec4(0.f, 1.f, 1.f, 0.f);
+    record.flags  = MATERIAL_EXIST | MATERIAL_TEXTURED;
+    return record;
 }
 
 /*********************************************************/
@@ -97,65 +137,42 @@ dr::PBRMaterial::PBRMaterial()
 roughness(0.f),
 metallic(0.f),
 ao(0.0),
-albedoTexture(Texture::GetNullTexture()),
-normalTexture(Texture::GetNullTexture()),
-metallicTexture(Texture::GetNullTexture()),
-roughnessTexture(Texture::GetNullTexture()),
-aoTexture(Texture::GetNullTexture())
+albedoTexture(),
+normalTexture(),
+ormTexture()
 {  }
 
 void dr::PBRMaterial::SetupMaterialShader(Shader *shader)
 {
     DUST_PROFILE;
     s_shader = shader;
-    static constexpr const char* albedoU      = "uMaterials[{}].texAlbedo";
-    static constexpr const char* normalU      = "uMaterials[{}].texNormal";
-    static constexpr const char* metallicU    = "uMaterials[{}].texMetallic";
-    static constexpr const char* roughnessU   = "uMaterials[{}].texRoughness";
-    static constexpr const char* aoU          = "uMaterials[{}].texAO";
-    for(int slot = 0; slot < DUST_MATERIAL_SLOTS; ++slot) {
-        // textures
-        const int baseTextureBind = slot * MAX_MATERIAL_TEXTURE_COUNT;
-        s_shader->setUniform(std::format(albedoU     , slot), baseTextureBind + 0);
-        s_shader->setUniform(std::format(normalU     , slot), baseTextureBind + 1);
-        s_shader->setUniform(std::format(metallicU   , slot), baseTextureBind + 2);
-        s_shader->setUniform(std::format(roughnessU  , slot), baseTextureBind + 3);
-        s_shader->setUniform(std::format(aoU         , slot), baseTextureBind + 4);
+    for(u32 i = 0; i < MAX_TEXTURE_ARRAYS; ++i) {
+        s_shader->setUniform(StringID("uTextureArrays").index(i), (int)(TEXTURE_ARRAY_UNIT + i));
     }
 }
 
 void dr::PBRMaterial::bind(u32 slot) 
 {
     DUST_PROFILE;
+    updateRecord(slot);
 
-    m_boundSlot = slot;
-    
-    const std::string bufAccess = std::format("[{}]", slot);
-    const std::string loc = "uMaterials" + bufAccess;
-    s_shader->setUniform(loc + ".exist", true);
-
-    // textures
-    const int baseTextureBind = slot * MAX_MATERIAL_TEXTURE_COUNT;
-    albedoTexture->bind(baseTextureBind + 0);
-    normalTexture->bind(baseTextureBind + 1);
-    metallicTexture->bind(baseTextureBind + 2);
-    roughnessTexture->bind(baseTextureBind + 3);
-    aoTexture->bind(baseTextureBind + 4);
-
-    // colors
-    s_shader->setUniform(loc + ".albedo", albedo);
-    s_shader->setUniform(loc + ".metallic", metallic);
-    s_shader->setUniform(loc + ".roughness", roughness);
-    s_shader->setUniform(loc + ".ao", ao);
+    // textures are layers of the shared arrays, already bound after the first material
+    if(auto table = MaterialTable::Get()) {
+        table->bindTextureArrays();
+    }
 }
 void dr::PBRMaterial::unbind() 
 {
-    const std::string loc = shaderMaterialLoc(m_boundSlot);
-    // unbind textures
-    albedoTexture->unbind();
-    normalTexture->unbind();
-    metallicTexture->unbind();
-    roughnessTexture->unbind();
-    aoTexture->unbind();
-    s_shader->setUniform(loc + ".exist", false);
+    // parameters and textures stay resident
+}
+dr::MaterialRecord dr::PBRMaterial::getRecord() const
+{
+    MaterialRecord record{};
+    record.albedo = glm::vec4(albedo, 1.f);
+    record.params = glm::vec4(metallic, roughness, ao, 0.f);
+    record.flags  = MATERIAL_EXIST | MATERIAL_TEXTURED | MATERIAL_TEXTURE_ARRAYS;
+    record.textures[TEXTURE_ALBEDO] = albedoTexture.pack();
+    record.textures[TEXTURE_NORMAL] = normalTexture.pack();
+    record.textures[TEXTURE_ORM]    = ormTexture.pack();
+    return record;
 }
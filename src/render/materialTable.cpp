@@ -0,0 +1,108 @@
+#include "dust/render/materialTable.hpp"
+
+#include "dust/core/log.hpp"
+#include "dust/core/profiling.hpp"
+#include "dust/render/glStateCache.hpp"
+#include "dust/render/renderAPI.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dr = dust::render;
+
+static_assert(sizeof(dr::MaterialRecord) == 64, "MaterialRecord must match its std430 layout");
+
+dr::MaterialTable::MaterialTable(u32 capacity)
+    : m_renderID(0), m_capacity(0), m_records(), m_textureArrays(), m_uploadCount(0) {
+    DUST_PROFILE;
+    grow(std::max(capacity, 1u));
+    if (s_instance == nullptr) s_instance = this;
+}
+
+dr::MaterialTable::~MaterialTable() {
+    DUST_PROFILE;
+    if (m_renderID) glDeleteBuffers(1, &m_renderID);
+    if (s_instance == this) s_instance = nullptr;
+}
+
+void dr::MaterialTable::update(u32 index, const MaterialRecord &record) {
+    if (index >= m_capacity) {
+        u32 capacity = m_capacity;
+        while (capacity <= index) capacity *= 2;
+        grow(capacity);
+    }
+    if (std::memcmp(&m_records[index], &record, sizeof(MaterialRecord)) == 0) {
+        return;
+    }
+    m_records[index] = record;
+    ++m_uploadCount;
+    DUST_PROFILE_GPU("NamedBufferSubData (Material)");
+    glNamedBufferSubData(m_renderID, index * sizeof(MaterialRecord), sizeof(MaterialRecord), &record);
+}
+
+void dr::MaterialTable::bind() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_TABLE_BINDING, m_renderID);
+}
+
+u32 dr::MaterialTable::addTextureArray(TexturePtr textureArray) {
+    // only the table owns the arrays of destroyed materials
+    for (auto &array : m_textureArrays) {
+        if (array && array.use_count() == 1) array.reset();
+    }
+    const auto slot = std::find(m_textureArrays.begin(), m_textureArrays.end(), nullptr);
+    if (slot != m_textureArrays.end()) {
+        *slot = textureArray;
+        return slot - m_textureArrays.begin();
+    }
+    if (m_textureArrays.size() >= MAX_TEXTURE_ARRAYS) {
+        DUST_ERROR("[MaterialTable] Texture arrays limit reached ({})", MAX_TEXTURE_ARRAYS);
+        return NO_TEXTURE_LAYER;
+    }
+    m_textureArrays.push_back(textureArray);
+    return m_textureArrays.size() - 1;
+}
+
+void dr::MaterialTable::bindTextureArrays() const {
+    for (u32 i = 0; i < m_textureArrays.size(); ++i) {
+        if (!m_textureArrays[i]) continue;
+        GLStateCache::BindTexture(TEXTURE_ARRAY_UNIT + i, GL_TEXTURE_2D_ARRAY, m_textureArrays[i]->getRenderID());
+    }
+}
+
+dr::TexturePtr dr::MaterialTable::getTextureArray(u32 index) const {
+    if (index >= m_textureArrays.size()) return nullptr;
+    return m_textureArrays[index];
+}
+
+u32 dr::MaterialTable::getCapacity() const {
+    return m_capacity;
+}
+u32 dr::MaterialTable::getUploadCount() const {
+    return m_uploadCount;
+}
+
+dr::MaterialTable *dr::MaterialTable::Get() {
+    return s_instance;
+}
+
+void dr::MaterialTable::grow(u32 capacity) {
+    DUST_PROFILE_SECTION("MaterialTable::grow");
+    // records are zero initialized: the record 0 (and unused ones) has no MATERIAL_EXIST flag
+    m_records.resize(capacity, MaterialRecord{});
+
+    u32 renderID = 0;
+    glCreateBuffers(1, &renderID);
+    if (renderID == 0) {
+        DUST_ERROR("[OpenGL][MaterialTable] Failed to create buffer");
+        return;
+    }
+    DUST_PROFILE_GPU("NamedBufferStorage (Material)");
+    glNamedBufferStorage(renderID, capacity * sizeof(MaterialRecord), m_records.data(),
+                         GL_DYNAMIC_STORAGE_BIT);
+    if (m_renderID) glDeleteBuffers(1, &m_renderID);
+
+    DUST_DEBUG("[OpenGL] MaterialTable {} resized to {} records", renderID, capacity);
+    m_renderID = renderID;
+    m_capacity = capacity;
+    bind();
+}
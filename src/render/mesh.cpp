@@ -1,22 +1,26 @@
 #include "dust/render/mesh.hpp"
 
 #include "dust/core/profiling.hpp"
+#include "dust/render/glStateCache.hpp"
 #include "dust/render/renderAPI.hpp"
 #include "dust/core/log.hpp"
 #include "dust/render/shader.hpp"
 #include <algorithm>
+#include <cstdint>
 
 namespace dr = dust::render;
 
 /**********************************************************/
 // Attribute
 
-dr::Attribute::Attribute(u32 count, u32 size, u32 glType)
-: m_count(count), m_size(size), m_glType(glType) {}
+dr::Attribute::Attribute(u32 count, u32 size, u32 glType, bool normalized, bool integer)
+: m_count(count), m_size(size), m_glType(glType), m_normalized(normalized), m_integer(integer) {}
 
-u32 dr::Attribute::getSize()   const { return m_size;   }
-u32 dr::Attribute::getCount()  const { return m_count;  }
-u32 dr::Attribute::getGLType() const { return m_glType; }
+u32 dr::Attribute::getSize()      const { return m_size;       }
+u32 dr::Attribute::getCount()     const { return m_count;      }
+u32 dr::Attribute::getGLType()    const { return m_glType;     }
+bool dr::Attribute::isNormalized() const { return m_normalized; }
+bool dr::Attribute::isInteger()    const { return m_integer;    }
 
 dr::Attribute dr::Attribute::Float     {1, 1 * sizeof(float), GL_FLOAT};
 dr::Attribute dr::Attribute::Float2    {2, 2 * sizeof(float), GL_FLOAT};
@@ -27,14 +31,53 @@ dr::Attribute dr::Attribute::Pos2D     {Float2};
 dr::Attribute dr::Attribute::Pos3D     {Float3};
 dr::Attribute dr::Attribute::Color     {Float4};
 
+dr::Attribute dr::Attribute::Half2       {2, 2 * sizeof(u16), GL_HALF_FLOAT};
+dr::Attribute dr::Attribute::Short2Norm  {2, 2 * sizeof(i16), GL_SHORT, true};
+dr::Attribute dr::Attribute::UShort4Norm {4, 4 * sizeof(u16), GL_UNSIGNED_SHORT, true};
+dr::Attribute dr::Attribute::UByte4      {4, 4 * sizeof(u8), GL_UNSIGNED_BYTE};
+dr::Attribute dr::Attribute::UByte4Norm  {4, 4 * sizeof(u8), GL_UNSIGNED_BYTE, true};
+dr::Attribute dr::Attribute::Int         {1, 1 * sizeof(i32), GL_INT, false, true};
+dr::Attribute dr::Attribute::UInt        {1, 1 * sizeof(u32), GL_UNSIGNED_INT, false, true};
+dr::Attribute dr::Attribute::Unused      {0, 0, GL_FLOAT};
+
+dr::AttributeFormat::AttributeFormat(const std::vector<Attribute> &attributes)
+: attributes(), stride(0)
+{
+    this->attributes.reserve(attributes.size());
+    for(u32 location = 0; location < attributes.size(); ++location) {
+        const auto &attrib = attributes[location];
+        if(attrib.getCount() > 0) {
+            this->attributes.push_back(VertexAttribute{location, attrib.getCount(),
+                                                       static_cast<ComponentType>(attrib.getGLType()),
+                                                       attrib.isNormalized(), attrib.isInteger(), stride});
+        }
+        stride += attrib.getSize();
+    }
+}
+
+dr::AttributeFormat::operator VertexFormat() const
+{
+    return VertexFormat{attributes, stride};
+}
+
 /**********************************************************/
 
-dr::Mesh::Mesh(void *vertexData, u32 vertexDataSize, u32 vertexCount, std::vector<u32> indices, std::vector<Attribute> attributes)
+dr::Mesh::Mesh(const void *vertexData, u32 vertexDataSize, u32 vertexCount, std::vector<u32> indices, const VertexFormat &format)
 : m_indexCount(indices.size()),
 m_renderID(0),
+m_positionRenderID(0),
+m_positionVbo(0),
+m_positionEbo(0),
+m_indexType(GL_UNSIGNED_INT),
 m_vertexCount(vertexCount),
+m_firstElement(0),
 m_materialSlots(),
 m_name(),
+m_bounds(),
+m_occluder(),
+m_meshlets(),
+m_lods(),
+m_dequantization(1.f),
 m_hidden(false)
 {
     DUST_PROFILE;
@@ -44,15 +87,13 @@ m_hidden(false)
 
     m_materialSlots.fill(nullptr);
     DUST_PROFILE_GPU("CreateVertexArrays");
-    unsigned int test = 0;
-    glGenVertexArrays(1, &m_renderID);
+    glCreateVertexArrays(1, &m_renderID);
     if(m_renderID == 0) {
         DUST_ERROR("[OpenGL][Mesh] Failed to create VAO");
         return;
     }
-    glBindVertexArray(m_renderID);
 
-    glGenBuffers(1, &m_vbo);
+    glCreateBuffers(1, &m_vbo);
     if(m_vbo == 0) {
         DUST_ERROR("[OpenGL][Mesh] Failed to create VBO");
         return;
@@ -60,42 +101,76 @@ m_hidden(false)
         DUST_DEBUG("[OpenGL][Mesh] Created VBO {}", m_vbo);
     }
     // VBO
-    {
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        DUST_PROFILE_GPU("BufferData (VBO)");
-        glBufferData(GL_ARRAY_BUFFER, vertexDataSize * vertexCount, vertexData, GL_STATIC_DRAW);
+    if(vertexCount > 0) {
+        DUST_PROFILE_GPU("NamedBufferStorage (VBO)");
+        glNamedBufferStorage(m_vbo, vertexDataSize * vertexCount, vertexData, 0);
     }
     // EBO
     m_ebo = 0;
     if(m_indexCount > 0) {
-        glGenBuffers(1, &m_ebo);
+        glCreateBuffers(1, &m_ebo);
         if(m_ebo == 0) {
             DUST_ERROR("[OpenGL][Mesh] Failed to create EBO");
             return;
         } else {
             DUST_DEBUG("[OpenGL][Mesh] Created EBO {}", m_ebo);
         }
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-        DUST_PROFILE_GPU("BufferData (EBO)");
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(u32), &indices.front(), GL_STATIC_DRAW);
+        DUST_PROFILE_GPU("NamedBufferStorage (EBO)");
+        if(vertexCount <= 0x10000) {
+            // 16 bits indices, half the index memory and bandwidth
+            const std::vector<u16> shortIndices(indices.begin(), indices.end());
+            m_indexType = GL_UNSIGNED_SHORT;
+            glNamedBufferStorage(m_ebo, shortIndices.size() * sizeof(u16), shortIndices.data(), 0);
+        } else {
+            glNamedBufferStorage(m_ebo, indices.size() * sizeof(u32), indices.data(), 0);
+        }
+        glVertexArrayElementBuffer(m_renderID, m_ebo);
     }
 
-    bindAttributes(attributes);
+    bindFormat(format);
     DUST_DEBUG("[OpenGL] Created Mesh {}", m_renderID);
-    glBindVertexArray(0);
 }
+dr::Mesh::Mesh(const void *vertexData, u32 vertexCount, const VertexFormat &format, std::vector<u32> indices)
+: dr::Mesh::Mesh(vertexData, format.stride, vertexCount, std::move(indices), format) {}
+dr::Mesh::Mesh(void *vertexData, u32 vertexDataSize, u32 vertexCount, std::vector<u32> indices, std::vector<Attribute> attributes)
+: dr::Mesh::Mesh(vertexData, vertexDataSize, vertexCount, std::move(indices), AttributeFormat(attributes)) {}
 dr::Mesh::Mesh(const std::vector<float> &vertexData, u32 vertexDataSize, u32 vertexCount, std::vector<Attribute> attribute)
 : dr::Mesh::Mesh((void*)&vertexData.front(), vertexDataSize, vertexCount, {}, attribute) {}
 dr::Mesh::Mesh(void *vertexData, u32 vertexDataSize, u32 vertexCount, std::vector<Attribute> attribute)
 : dr::Mesh::Mesh(vertexData, vertexDataSize, vertexCount, {}, attribute) {}
 
+dr::Mesh::Mesh()
+: m_renderID(0),
+m_vbo(0),
+m_ebo(0),
+m_positionRenderID(0),
+m_positionVbo(0),
+m_positionEbo(0),
+m_indexCount(0),
+m_indexType(GL_UNSIGNED_INT),
+m_vertexCount(0),
+m_firstElement(0),
+m_materialSlots(),
+m_name(),
+m_bounds(),
+m_occluder(),
+m_meshlets(),
+m_lods(),
+m_dequantization(1.f),
+m_hidden(false)
+{
+    m_materialSlots.fill(nullptr);
+}
+
 dr::Mesh::~Mesh()
 {   
     DUST_PROFILE;
-    glBindVertexArray(0);
+    GLStateCache::DeleteVertexArray(m_renderID);
     if(m_vbo) glDeleteBuffers(1, &m_vbo);
     if(m_ebo) glDeleteBuffers(1, &m_ebo);
-    glDeleteVertexArrays(1, &m_renderID);
+    if(m_positionRenderID) GLStateCache::DeleteVertexArray(m_positionRenderID);
+    if(m_positionVbo) glDeleteBuffers(1, &m_positionVbo);
+    if(m_positionEbo) glDeleteBuffers(1, &m_positionEbo);
 }
 
 void dr::Mesh::draw(const Shader *shader)
@@ -103,54 +178,116 @@ void dr::Mesh::draw(const Shader *shader)
     DUST_PROFILE;
     if(m_hidden) return;
     
-    u32 slot = 0;
-    for(auto& material : m_materialSlots){
-        if(material == nullptr) { slot++; continue; }
-        material->bind(slot);
-        slot++;
-    }
+    // position only shaders (depth, shadows) read no material
+    const bool materials = !shader->isPositionOnly();
+    if(materials) bindMaterials();
     
     shader->use();    
-    glBindVertexArray(m_renderID);
+    GLStateCache::BindVertexArray(getVertexArray(shader));
+    drawGeometry();
+
+    if(materials) unbindMaterials();
+}
+
+bool dr::Mesh::bindMaterials(const Mesh *previous)
+{
+    DUST_PROFILE;
+    bool changed = false;
+    for(u32 slot = 0; slot < DUST_MATERIAL_SLOTS; ++slot) {
+        const auto &material = m_materialSlots[slot];
+        const MaterialPtr *bound = previous ? &previous->m_materialSlots[slot] : nullptr;
+        if(bound != nullptr && *bound == material) continue;
+        if(material != nullptr) {
+            material->bind(slot);
+        } else if(bound != nullptr && *bound != nullptr) {
+            (*bound)->unbind();
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+void dr::Mesh::unbindMaterials()
+{
+    DUST_PROFILE;
+    for(auto& material : m_materialSlots){
+        if(material == nullptr) continue;
+        material->unbind();
+    }
+}
+
+void dr::Mesh::drawGeometry() const
+{
     if(m_ebo != 0) {
         DUST_PROFILE_GPU("DrawElements");
-        glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, nullptr);
+        glDrawElements(GL_TRIANGLES, m_indexCount, m_indexType, (void*)(uintptr_t)(m_firstElement * getIndexSize()));
     } else {
         DUST_PROFILE_GPU("DrawArrays");
-        glDrawArrays(GL_TRIANGLES, 0, m_vertexCount);
+        glDrawArrays(GL_TRIANGLES, m_firstElement, m_vertexCount);
     }
-    glBindVertexArray(0);
+}
 
-    for(auto& material : m_materialSlots){
-        if(material == nullptr) continue;
-        material->unbind();
+void dr::Mesh::drawGeometryInstanced(u32 instanceCount) const
+{
+    if(m_ebo != 0) {
+        DUST_PROFILE_GPU("DrawElementsInstanced");
+        glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, m_indexType, (void*)(uintptr_t)(m_firstElement * getIndexSize()), instanceCount);
+    } else {
+        DUST_PROFILE_GPU("DrawArraysInstanced");
+        glDrawArraysInstanced(GL_TRIANGLES, m_firstElement, m_vertexCount, instanceCount);
     }
 }
 
-std::array<dr::MaterialPtr, DUST_MATERIAL_SLOTS> dr::Mesh::getMaterials() const
+void dr::Mesh::drawGeometryRanges(const i32 *counts, const void *const *offsets, u32 rangeCount) const
+{
+    if(m_ebo == 0 || rangeCount == 0) return;
+    DUST_PROFILE_GPU("MultiDrawElements");
+    glMultiDrawElements(GL_TRIANGLES, counts, m_indexType, offsets, rangeCount);
+}
+
+const std::array<dr::MaterialPtr, DUST_MATERIAL_SLOTS> &dr::Mesh::getMaterials() const
 {
     return m_materialSlots;
 }
 
-void dr::Mesh::bindAttributes(const std::vector<Attribute> &attributes)
+u32 dr::Mesh::getMaterialKey() const
 {
-    DUST_PROFILE_GPU("MeshAttribute");
-    u32 stride = 0;
-    std::for_each(attributes.begin(), attributes.end(), [&](const Attribute &attrib){
-        stride += attrib.getSize();
-    });
-    // DUST_DEBUG("[OpenGL][VertexAttrib] Stride = {}", stride);
-
-    u64 offset = 0;
-    u32 index  = 0;
-    for(const auto& attrib : attributes)
-    {
-        // DUST_DEBUG("[OpenGL][VertexAttrib] Vertex attrib {} : offset {}", index, offset);
-        glVertexAttribPointer(index, attrib.getCount(), attrib.getGLType(), GL_FALSE, stride, (void*)offset);
-        glEnableVertexAttribArray(index);
-        offset += attrib.getSize();
-        ++index;
+    for(const auto& material : m_materialSlots) {
+        if(material != nullptr) return material->getID();
     }
+    return 0;
+}
+
+bool dr::Mesh::isTransparent() const
+{
+    return std::any_of(m_materialSlots.begin(), m_materialSlots.end(), [](const MaterialPtr &material) {
+        return material != nullptr && material->isTransparent();
+    });
+}
+
+u32 dr::Mesh::getRenderID() const
+{
+    return m_renderID;
+}
+u32 dr::Mesh::getFirstElement() const
+{
+    return m_firstElement;
+}
+u32 dr::Mesh::getIndexSize() const
+{
+    return m_indexType == GL_UNSIGNED_SHORT ? sizeof(u16) : sizeof(u32);
+}
+u32 dr::Mesh::getTriangleCount() const
+{
+    return (m_ebo != 0 ? m_indexCount : m_vertexCount) / 3;
+}
+
+void dr::Mesh::bindFormat(const VertexFormat &format)
+{
+    DUST_PROFILE_GPU("MeshAttribute");
+    format.apply(m_renderID);
+    // interleaved vertices in the VBO, binding 0
+    glVertexArrayVertexBuffer(m_renderID, 0, m_vbo, 0, format.stride);
 }
 
 void dr::Mesh::setName(const std::string &name)
@@ -172,6 +309,109 @@ bool dr::Mesh::isHidden() const
     return m_hidden;
 }
 
+void dr::Mesh::setBounds(const AABB &bounds)
+{
+    m_bounds = bounds;
+}
+const dr::AABB &dr::Mesh::getBounds() const
+{
+    return m_bounds;
+}
+
+void dr::Mesh::setOccluder(std::vector<glm::vec3> triangles)
+{
+    m_occluder = std::move(triangles);
+}
+const std::vector<glm::vec3> &dr::Mesh::getOccluder() const
+{
+    return m_occluder;
+}
+
+void dr::Mesh::setMeshlets(std::vector<Meshlet> meshlets)
+{
+    m_meshlets = std::move(meshlets);
+}
+const std::vector<dr::Meshlet> &dr::Mesh::getMeshlets() const
+{
+    return m_meshlets;
+}
+
+void dr::Mesh::setLODs(std::vector<MeshLOD> lods)
+{
+    m_lods = std::move(lods);
+    if(!m_lods.empty()) m_indexCount = m_lods.front().indexCount;
+}
+const std::vector<dr::MeshLOD> &dr::Mesh::getLODs() const
+{
+    return m_lods;
+}
+
+void dr::Mesh::setDequantization(const glm::mat4 &dequantization)
+{
+    m_dequantization = dequantization;
+}
+const glm::mat4 &dr::Mesh::getDequantization() const
+{
+    return m_dequantization;
+}
+bool dr::Mesh::isQuantized() const
+{
+    return m_dequantization != glm::mat4(1.f);
+}
+glm::mat4 dr::Mesh::getVertexTransform(const glm::mat4 &model) const
+{
+    return isQuantized() ? model * m_dequantization : model;
+}
+
+void dr::Mesh::setPositionStream(const void *positions, u32 positionCount, const VertexFormat &format,
+                                 std::span<const u32> indices)
+{
+    DUST_PROFILE;
+    if(positions == nullptr || positionCount == 0) return;
+    if(m_ebo != 0 && indices.size() < m_indexCount) {
+        DUST_ERROR("[Mesh] {} position stream needs {} indices, got {}", m_name, m_indexCount, indices.size());
+        return;
+    }
+    if(m_ebo == 0 && positionCount < m_firstElement + m_vertexCount) {
+        DUST_ERROR("[Mesh] {} position stream needs {} positions, got {}", m_name, m_firstElement + m_vertexCount, positionCount);
+        return;
+    }
+    if(m_positionRenderID == 0) glCreateVertexArrays(1, &m_positionRenderID);
+    if(m_positionRenderID == 0) {
+        DUST_ERROR("[OpenGL][Mesh] Failed to create position VAO");
+        return;
+    }
+    // immutable storages, replaced as a whole
+    if(m_positionVbo) glDeleteBuffers(1, &m_positionVbo);
+    if(m_positionEbo) glDeleteBuffers(1, &m_positionEbo);
+    m_positionEbo = 0;
+
+    DUST_PROFILE_GPU("NamedBufferStorage (positions)");
+    glCreateBuffers(1, &m_positionVbo);
+    glNamedBufferStorage(m_positionVbo, positionCount * format.stride, positions, 0);
+    if(m_ebo != 0) {
+        // same index type as the mesh, the index ranges are byte offsets
+        glCreateBuffers(1, &m_positionEbo);
+        if(m_indexType == GL_UNSIGNED_SHORT) {
+            const std::vector<u16> shortIndices(indices.begin(), indices.end());
+            glNamedBufferStorage(m_positionEbo, shortIndices.size() * sizeof(u16), shortIndices.data(), 0);
+        } else {
+            glNamedBufferStorage(m_positionEbo, indices.size_bytes(), indices.data(), 0);
+        }
+        glVertexArrayElementBuffer(m_positionRenderID, m_positionEbo);
+    }
+    format.apply(m_positionRenderID);
+    glVertexArrayVertexBuffer(m_positionRenderID, 0, m_positionVbo, 0, format.stride);
+}
+bool dr::Mesh::hasPositionStream() const
+{
+    return m_positionVbo != 0;
+}
+u32 dr::Mesh::getVertexArray(const Shader *shader) const
+{
+    return (m_positionVbo != 0 && shader != nullptr && shader->isPositionOnly()) ? m_positionRenderID : m_renderID;
+}
+
 void dr::Mesh::setMaterial(u32 index, MaterialPtr material)
 {
     DUST_PROFILE;
@@ -183,13 +423,36 @@ dr::MaterialPtr dr::Mesh::getMaterial(u32 index) const
     return m_materialSlots.at(index);
 }
 
+using PlainVertexLayout    = dr::VertexLayout<dr::Position3f, dr::Normal3f>;
+using TexturedVertexLayout = dr::VertexLayout<dr::Position3f, dr::Normal3f, dr::TexCoord2f>;
+
+/// Mesh of interleaved float vertices of a layout, with its position stream (position first)
+template <typename Layout>
+static dr::MeshPtr CreateMesh(const std::vector<f32> &vertices)
+{
+    static_assert(Layout::Stride % sizeof(f32) == 0);
+    static_assert(Layout::template OffsetOf<dr::Position3f>() == 0);
+    constexpr u32 floats = Layout::Stride / sizeof(f32);
+    const u32 count = vertices.size() / floats;
+    auto mesh = dust::createRef<dr::Mesh>(vertices.data(), count, Layout::Format());
+
+    std::vector<f32> positions{};
+    positions.reserve(count * 3);
+    for(u32 i = 0; i < count; ++i) {
+        positions.insert(positions.end(), vertices.begin() + i * floats, vertices.begin() + i * floats + 3);
+    }
+    mesh->setPositionStream(positions.data(), count, dr::VertexLayout<dr::Position3f>::Format(), {});
+    return mesh;
+}
+
 dr::MeshPtr
 dr::Mesh::createPlane(glm::vec2 size, bool textureCoordinates)
 {
     DUST_PROFILE;
     const glm::vec2 half = size*.5f;
+    MeshPtr mesh;
     if(!textureCoordinates) {
-        return createRef<Mesh>(std::vector<f32>{
+        mesh = CreateMesh<PlainVertexLayout>({
             // pos                  // normal
             // first triangle
             -half.x, 0.f, +half.y,  0.f, 1.f, 0.f,
@@ -200,9 +463,9 @@ dr::Mesh::createPlane(glm::vec2 size, bool textureCoordinates)
              half.x, 0.f, -half.y,  0.f, 1.f, 0.f,
             -half.x, 0.f, -half.y,  0.f, 1.f, 0.f,
             -half.x, 0.f, +half.y,  0.f, 1.f, 0.f,
-        }, sizeof(f32) * 6, 6, std::vector<Attribute>{ Attribute::Pos3D, Attribute::Pos3D });
+        });
     } else {
-        return createRef<Mesh>(std::vector<f32>{
+        mesh = CreateMesh<TexturedVertexLayout>({
             // pos                 //normal       // tex
             // first triangle
             -half.x, 0.f, +half.y, 0.f, 1.f, 0.f,  0.f, 1.f,
@@ -213,8 +476,10 @@ dr::Mesh::createPlane(glm::vec2 size, bool textureCoordinates)
              half.x, 0.f, -half.y, 0.f, 1.f, 0.f,  1.f, 0.f,
             -half.x, 0.f, -half.y, 0.f, 1.f, 0.f,  0.f, 0.f,
             -half.x, 0.f, +half.y, 0.f, 1.f, 0.f,  0.f, 1.f,
-        }, sizeof(f32) * 8, 6, std::vector<Attribute>{ Attribute::Pos3D, Attribute::Pos3D, Attribute::TexCoords});
+        });
     }
+    mesh->setBounds(AABB{{-half.x, 0.f, -half.y}, {half.x, 0.f, half.y}});
+    return mesh;
 }
 
 dr::MeshPtr
@@ -222,8 +487,9 @@ dr::Mesh::createCube(glm::vec3 size, bool textureCoordinates)
 {
     DUST_PROFILE;
     const glm::vec3 half = size*.5f;
+    MeshPtr mesh;
     if(!textureCoordinates) {
-        return createRef<Mesh>(std::vector<f32>{
+        mesh = CreateMesh<PlainVertexLayout>({
             // position           // normals
             // back face
              half.x, +half.y, -half.z,  0.0f,  0.0f, -1.0f, // bottom-right         
@@ -267,9 +533,9 @@ dr::Mesh::createCube(glm::vec3 size, bool textureCoordinates)
             -half.x, -half.y,  half.z,  0.0f, -1.0f,  0.0f, // bottom-left        
             -half.x, -half.y, -half.z,  0.0f, -1.0f,  0.0f, // top-left
              half.x, -half.y,  half.z,  0.0f, -1.0f,  0.0f, // bottom-right
-        }, sizeof(f32) * 6, 36, std::vector<Attribute>{ Attribute::Pos3D, Attribute::Pos3D });
+        });
     } else {
-        return createRef<Mesh>(std::vector<f32>{
+        mesh = CreateMesh<TexturedVertexLayout>({
             // position           // normals          // tex coords
             // back face
             -half.x, +half.y, -half.z,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
@@ -313,6 +579,8 @@ dr::Mesh::createCube(glm::vec3 size, bool textureCoordinates)
              half.x, -half.y,  half.z,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
             -half.x, -half.y, -half.z,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-left
             -half.x, -half.y,  half.z,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f  // bottom-left        
-        }, sizeof(f32) * 8, 36, std::vector<Attribute>{ Attribute::Pos3D, Attribute::Pos3D, Attribute::TexCoords });
+        });
     }
+    mesh->setBounds(AABB{-half, half});
+    return mesh;
 }
\ No newline at end of file
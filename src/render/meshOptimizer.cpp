@@ -0,0 +1,193 @@
+#include "dust/render/meshOptimizer.hpp"
+
+#include "dust/core/profiling.hpp"
+
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+namespace dr = dust::render;
+
+void dr::MeshOptimizer::OptimizeVertexCache(std::span<u32> indices, u32 cacheSize) {
+    DUST_PROFILE_SECTION("MeshOptimizer::OptimizeVertexCache");
+    const u32 triangleCount = indices.size() / 3;
+    if (triangleCount < 2) return;
+
+    // compact vertex ids, the indices can be a part of a larger buffer
+    std::vector<u32> vertices(indices.begin(), indices.begin() + triangleCount * 3);
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+    const u32 vertexCount = vertices.size();
+    std::vector<u32> local(triangleCount * 3);
+    for (u32 i = 0; i < local.size(); ++i) {
+        local[i] = std::lower_bound(vertices.begin(), vertices.end(), indices[i]) - vertices.begin();
+    }
+
+    // triangles of each vertex, its count is the number of triangles left to emit
+    std::vector<u32> live(vertexCount, 0);
+    for (const u32 v : local) ++live[v];
+    std::vector<u32> adjacencyOffsets(vertexCount + 1, 0);
+    std::partial_sum(live.begin(), live.end(), adjacencyOffsets.begin() + 1);
+    std::vector<u32> adjacency(local.size());
+    {
+        std::vector<u32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (u32 i = 0; i < local.size(); ++i) adjacency[fill[local[i]]++] = i / 3;
+    }
+
+    std::vector<u32> timestamps(vertexCount, 0);
+    std::vector<u8> emitted(triangleCount, 0);
+    std::vector<u32> deadEnds{}, candidates{}, result{};
+    result.reserve(local.size());
+    u32 time   = cacheSize + 1;
+    u32 cursor = 0;
+    i64 fanning = 0;
+    while (fanning >= 0) {
+        // emit every triangle around the fanning vertex
+        candidates.clear();
+        for (u32 a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; ++a) {
+            const u32 triangle = adjacency[a];
+            if (emitted[triangle]) continue;
+            emitted[triangle] = 1;
+            for (u32 v = 0; v < 3; ++v) {
+                const u32 vertex = local[triangle * 3 + v];
+                result.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                --live[vertex];
+                if (time - timestamps[vertex] > cacheSize) timestamps[vertex] = time++;
+            }
+        }
+
+        // next fanning vertex: the oldest one still in the cache after its triangles are emitted
+        fanning = -1;
+        i64 bestPriority = -1;
+        for (const u32 vertex : candidates) {
+            if (live[vertex] == 0) continue;
+            i64 priority = 0;
+            if (time - timestamps[vertex] + 2 * live[vertex] <= cacheSize) priority = time - timestamps[vertex];
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fanning      = vertex;
+            }
+        }
+        if (fanning >= 0) continue;
+        // dead end: a recent vertex with triangles left, any vertex otherwise
+        while (!deadEnds.empty() && fanning < 0) {
+            const u32 vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[vertex] > 0) fanning = vertex;
+        }
+        while (fanning < 0 && cursor < vertexCount) {
+            if (live[cursor] > 0) fanning = cursor;
+            ++cursor;
+        }
+    }
+
+    for (u32 i = 0; i < result.size(); ++i) indices[i] = vertices[result[i]];
+}
+
+void dr::MeshOptimizer::OptimizeOverdraw(std::span<const glm::vec3> positions, std::vector<u32> &indices,
+                                         std::vector<Meshlet> &meshlets) {
+    DUST_PROFILE_SECTION("MeshOptimizer::OptimizeOverdraw");
+    if (meshlets.size() < 2) return;
+
+    // area weighted centroids and normals
+    glm::vec3 meshCentroid(0.f);
+    f32 meshArea = 0.f;
+    std::vector<glm::vec3> centroids(meshlets.size()), normals(meshlets.size());
+    for (u32 m = 0; m < meshlets.size(); ++m) {
+        glm::vec3 centroid(0.f), normal(0.f);
+        f32 area = 0.f;
+        const auto &meshlet = meshlets[m];
+        for (u32 i = meshlet.firstIndex; i + 2 < meshlet.firstIndex + meshlet.indexCount; i += 3) {
+            const glm::vec3 &a = positions[indices[i]], &b = positions[indices[i + 1]], &c = positions[indices[i + 2]];
+            const glm::vec3 cross = glm::cross(b - a, c - a);
+            const f32 triangleArea = glm::length(cross) * .5f;
+            centroid += (a + b + c) / 3.f * triangleArea;
+            normal += cross;
+            area += triangleArea;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        centroids[m] = area > 0.f ? centroid / area : meshlet.center;
+        normals[m]   = normal;
+    }
+    if (meshArea > 0.f) meshCentroid /= meshArea;
+
+    // outward facing meshlets far from the center first
+    std::vector<f32> scores(meshlets.size());
+    for (u32 m = 0; m < meshlets.size(); ++m) {
+        const f32 length = glm::length(normals[m]);
+        scores[m] = length > 0.f ? glm::dot(centroids[m] - meshCentroid, normals[m] / length) : 0.f;
+    }
+    std::vector<u32> order(meshlets.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](u32 l, u32 r) { return scores[l] > scores[r]; });
+
+    std::vector<u32> reordered{};
+    reordered.reserve(indices.size());
+    std::vector<Meshlet> sorted{};
+    sorted.reserve(meshlets.size());
+    for (const u32 m : order) {
+        Meshlet meshlet    = meshlets[m];
+        const u32 first    = meshlet.firstIndex;
+        meshlet.firstIndex = reordered.size();
+        reordered.insert(reordered.end(), indices.begin() + first, indices.begin() + first + meshlet.indexCount);
+        sorted.push_back(meshlet);
+    }
+    // indices after the meshlets are kept as is
+    u32 end = 0;
+    for (const auto &meshlet : meshlets) end = std::max(end, meshlet.firstIndex + meshlet.indexCount);
+    reordered.insert(reordered.end(), indices.begin() + end, indices.end());
+    indices  = std::move(reordered);
+    meshlets = std::move(sorted);
+}
+
+std::vector<u32> dr::MeshOptimizer::OptimizeVertexFetch(std::span<u32> indices, u32 vertexCount) {
+    DUST_PROFILE_SECTION("MeshOptimizer::OptimizeVertexFetch");
+    std::vector<u32> remap(vertexCount, NO_VERTEX);
+    u32 next = 0;
+    for (u32 &index : indices) {
+        if (remap[index] == NO_VERTEX) remap[index] = next++;
+        index = remap[index];
+    }
+    return remap;
+}
+
+std::vector<u32> dr::MeshOptimizer::WeldPositions(std::span<const glm::vec3> positions, u32 &positionCount) {
+    DUST_PROFILE_SECTION("MeshOptimizer::WeldPositions");
+    struct Hash {
+        size_t operator()(const std::array<u32, 3> &key) const {
+            return (key[0] * 73856093u) ^ (key[1] * 19349663u) ^ (key[2] * 83492791u);
+        }
+    };
+    std::unordered_map<std::array<u32, 3>, u32, Hash> unique{};
+    unique.reserve(positions.size());
+    std::vector<u32> remap(positions.size());
+    for (u32 v = 0; v < positions.size(); ++v) {
+        std::array<u32, 3> key{};
+        std::memcpy(key.data(), &positions[v], sizeof(key));
+        remap[v] = unique.try_emplace(key, unique.size()).first->second;
+    }
+    positionCount = unique.size();
+    return remap;
+}
+
+dr::VertexCacheStats dr::MeshOptimizer::AnalyzeVertexCache(std::span<const u32> indices, u32 vertexCount,
+                                                           u32 cacheSize) {
+    // FIFO: a vertex leaves the cache `cacheSize` misses after it entered it
+    std::vector<u32> insertedAt(vertexCount, NO_VERTEX);
+    u32 misses = 0, referenced = 0;
+    for (const u32 index : indices) {
+        if (insertedAt[index] == NO_VERTEX) ++referenced;
+        else if (misses - insertedAt[index] < cacheSize) continue;
+        insertedAt[index] = misses++;
+    }
+    const u32 triangleCount = indices.size() / 3;
+    return VertexCacheStats{triangleCount > 0 ? (f32)misses / triangleCount : 0.f,
+                            referenced > 0 ? (f32)misses / referenced : 0.f};
+}
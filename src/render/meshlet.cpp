@@ -0,0 +1,195 @@
+#include "dust/render/meshlet.hpp"
+
+#include "dust/core/profiling.hpp"
+
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace dr = dust::render;
+
+/// under this cosine the normals are too spread for the cone to cull anything
+constexpr f32 MIN_CONE_COSINE = .1f;
+
+/**
+ * @brief Bounding sphere and normal cone of the triangles of a meshlet
+ */
+static void
+ComputeBounds(std::span<const glm::vec3> positions, std::span<const u32> indices, dr::Meshlet &meshlet)
+{
+    dr::AABB box{};
+    glm::vec3 normalSum(0.f);
+    std::vector<glm::vec3> normals{};
+    normals.reserve(indices.size() / 3);
+    for (u32 i = 0; i + 2 < indices.size(); i += 3) {
+        const glm::vec3 &a = positions[indices[i]];
+        const glm::vec3 &b = positions[indices[i + 1]];
+        const glm::vec3 &c = positions[indices[i + 2]];
+        box.extend(a);
+        box.extend(b);
+        box.extend(c);
+        const glm::vec3 normal = glm::cross(b - a, c - a);
+        const f32 length = glm::length(normal);
+        if (length <= 0.f) continue;
+        normals.push_back(normal / length);
+        normalSum += normals.back();
+    }
+
+    meshlet.center = box.getCenter();
+    meshlet.radius = 0.f;
+    for (const u32 index : indices) {
+        meshlet.radius = std::max(meshlet.radius, glm::length(positions[index] - meshlet.center));
+    }
+
+    meshlet.coneAxis   = glm::vec3(0.f, 0.f, 1.f);
+    meshlet.coneCutoff = 1.f;
+    const f32 sumLength = glm::length(normalSum);
+    if (normals.empty() || sumLength <= 0.f) return;
+    const glm::vec3 axis = normalSum / sumLength;
+    f32 minCosine = 1.f;
+    for (const auto &normal : normals) minCosine = std::min(minCosine, glm::dot(normal, axis));
+    if (minCosine <= MIN_CONE_COSINE) return;
+    meshlet.coneAxis = axis;
+    // sine of the cone half angle
+    meshlet.coneCutoff = std::sqrt(1.f - minCosine * minCosine);
+}
+
+std::vector<dr::Meshlet> dr::Meshlet::Build(std::span<const glm::vec3> positions, std::vector<u32> &indices,
+                                            u32 maxVertices, u32 maxTriangles) {
+    DUST_PROFILE_SECTION("Meshlet::Build");
+    constexpr u32 NONE = std::numeric_limits<u32>::max();
+    const u32 triangleCount = indices.size() / 3;
+    const u32 vertexCount   = positions.size();
+    maxVertices  = std::max(maxVertices, 3u);
+    maxTriangles = std::max(maxTriangles, 1u);
+
+    // triangles of each vertex
+    std::vector<u32> adjacencyOffsets(vertexCount + 1, 0);
+    for (u32 i = 0; i < triangleCount * 3; ++i) ++adjacencyOffsets[indices[i] + 1];
+    for (u32 v = 0; v < vertexCount; ++v) adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    std::vector<u32> adjacency(triangleCount * 3);
+    {
+        std::vector<u32> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (u32 i = 0; i < triangleCount * 3; ++i) adjacency[fill[indices[i]]++] = i / 3;
+    }
+    std::vector<glm::vec3> centroids(triangleCount);
+    for (u32 t = 0; t < triangleCount; ++t) {
+        centroids[t] = (positions[indices[3 * t]] + positions[indices[3 * t + 1]] + positions[indices[3 * t + 2]]) / 3.f;
+    }
+
+    std::vector<Meshlet> meshlets{};
+    std::vector<u32> reordered{};
+    reordered.reserve(triangleCount * 3);
+    std::vector<u8> emitted(triangleCount, 0);
+    // last meshlet using each vertex
+    std::vector<u32> vertexMeshlet(vertexCount, NONE);
+    std::vector<u32> meshletVertices{};
+    meshletVertices.reserve(maxVertices);
+
+    const auto newVertices = [&](u32 triangle, u32 meshlet) {
+        u32 count = 0;
+        for (u32 v = 0; v < 3; ++v) count += vertexMeshlet[indices[3 * triangle + v]] != meshlet;
+        return count;
+    };
+
+    u32 seed = 0;
+    while (true) {
+        while (seed < triangleCount && emitted[seed]) ++seed;
+        if (seed == triangleCount) break;
+
+        const u32 id = meshlets.size();
+        Meshlet meshlet{};
+        meshlet.firstIndex = reordered.size();
+        meshletVertices.clear();
+        glm::vec3 centroidSum(0.f);
+        u32 meshletTriangles = 0;
+
+        u32 triangle = seed;
+        while (triangle != NONE) {
+            emitted[triangle] = 1;
+            for (u32 v = 0; v < 3; ++v) {
+                const u32 vertex = indices[3 * triangle + v];
+                if (vertexMeshlet[vertex] != id) {
+                    vertexMeshlet[vertex] = id;
+                    meshletVertices.push_back(vertex);
+                }
+                reordered.push_back(vertex);
+            }
+            centroidSum += centroids[triangle];
+            if (++meshletTriangles == maxTriangles) break;
+
+            // connected triangle adding the fewest vertices, then the closest
+            const glm::vec3 centroid = centroidSum / (f32)meshletTriangles;
+            u32 bestExtra = 4;
+            f32 bestDistance = std::numeric_limits<f32>::max();
+            triangle = NONE;
+            for (const u32 vertex : meshletVertices) {
+                for (u32 a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; ++a) {
+                    const u32 candidate = adjacency[a];
+                    if (emitted[candidate]) continue;
+                    const u32 extra = newVertices(candidate, id);
+                    if (meshletVertices.size() + extra > maxVertices || extra > bestExtra) continue;
+                    const glm::vec3 offset = centroids[candidate] - centroid;
+                    const f32 distance = glm::dot(offset, offset);
+                    if (extra < bestExtra || distance < bestDistance) {
+                        bestExtra    = extra;
+                        bestDistance = distance;
+                        triangle     = candidate;
+                    }
+                }
+            }
+        }
+
+        meshlet.indexCount = reordered.size() - meshlet.firstIndex;
+        ComputeBounds(positions, std::span<const u32>(reordered).subspan(meshlet.firstIndex, meshlet.indexCount),
+                      meshlet);
+        meshlets.push_back(meshlet);
+    }
+
+    // non triangle leftovers
+    reordered.insert(reordered.end(), indices.begin() + triangleCount * 3, indices.end());
+    indices = std::move(reordered);
+    return meshlets;
+}
+
+dr::MeshletCuller::MeshletCuller(const glm::mat4 &model, const Frustum *frustum, glm::vec3 viewPosition)
+    : m_planes(), m_radiusScale(1.f), m_viewPosition(0.f), m_frustumCulling(frustum != nullptr),
+      m_coneCulling(false) {
+    const f32 scaleX = glm::length(glm::vec3(model[0]));
+    const f32 scaleY = glm::length(glm::vec3(model[1]));
+    const f32 scaleZ = glm::length(glm::vec3(model[2]));
+    m_radiusScale = std::max({scaleX, scaleY, scaleZ});
+
+    if (frustum != nullptr) {
+        // world distance of a local point: dot(transpose(model) * plane, point)
+        const glm::mat4 transposed = glm::transpose(model);
+        for (u32 i = 0; i < Frustum::PLANE_COUNT; ++i) m_planes[i] = transposed * frustum->planes[i];
+    }
+
+    const f32 minScale = std::min({scaleX, scaleY, scaleZ});
+    const bool uniform = minScale > 0.f && m_radiusScale - minScale <= m_radiusScale * 1e-3f;
+    if (uniform && glm::determinant(glm::mat3(model)) > 0.f) {
+        m_viewPosition = glm::vec3(glm::inverse(model) * glm::vec4(viewPosition, 1.f));
+        m_coneCulling  = true;
+    }
+}
+
+bool dr::MeshletCuller::isVisible(const Meshlet &meshlet) const {
+    if (m_frustumCulling) {
+        const glm::vec4 center(meshlet.center, 1.f);
+        const f32 radius = meshlet.radius * m_radiusScale;
+        for (const auto &plane : m_planes) {
+            if (glm::dot(plane, center) < -radius) return false;
+        }
+    }
+    if (m_coneCulling && meshlet.coneCutoff < 1.f) {
+        // every triangle faces away from the view position
+        const glm::vec3 toCenter = meshlet.center - m_viewPosition;
+        const f32 distance = glm::length(toCenter);
+        if (glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * distance + meshlet.radius) return false;
+    }
+    return true;
+}
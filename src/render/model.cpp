@@ -12,11 +12,11 @@
 namespace dr = dust::render;
 
 dr::Model::Model(MeshPtr mesh)
-    : m_meshes({mesh}), m_position(.0f, .0f, .0f), m_modelMat(1.f) {
+    : m_meshes({mesh}), m_lods(1, 0), m_position(.0f, .0f, .0f), m_modelMat(1.f), m_dirty(true) {
 }
 
 dr::Model::Model(const std::vector<dr::MeshPtr> &meshes)
-    : m_meshes(meshes), m_position(.0f, .0f, .0f), m_modelMat(1.f) {
+    : m_meshes(meshes), m_lods(meshes.size(), 0), m_position(.0f, .0f, .0f), m_modelMat(1.f), m_dirty(true) {
 }
 dr::Model::~Model() {
     DUST_PROFILE;
@@ -30,6 +30,7 @@ void dr::Model::setPosition(glm::vec3 position) {
     DUST_PROFILE;
     m_position = position;
     m_modelMat = glm::translate(glm::mat4(1.f), position);
+    m_dirty    = true;
 }
 
 glm::vec3 dr::Model::getPosition() const {
@@ -40,13 +41,38 @@ std::vector<dr::MeshPtr> dr::Model::getMeshes() const {
     return m_meshes;
 }
 
+glm::mat4 dr::Model::getModelMatrix() const {
+    return m_modelMat;
+}
+
+u32 dr::Model::getMeshLOD(u32 mesh) const {
+    return mesh < m_lods.size() ? m_lods[mesh] : 0;
+}
+
+bool dr::Model::isDirty() const {
+    return m_dirty;
+}
+
+void dr::Model::setDirty(bool dirty) {
+    m_dirty = dirty;
+}
+
 void dr::Model::draw(Shader *shader) {
     DUST_PROFILE_SECTION("Model::Draw");
-    shader->setUniform("uModel", m_modelMat);
     for (auto mesh : m_meshes) {
         if (!mesh) {
             continue;
         }
+        shader->setUniform("uModel", mesh->getVertexTransform(m_modelMat));
         mesh->draw(shader);
     }
-}
\ No newline at end of file
+}
+void dr::Model::submit(RenderQueue &queue, Shader *shader, u8 pass) {
+    DUST_PROFILE_SECTION("Model::Submit");
+    for (u32 i = 0; i < m_meshes.size(); ++i) {
+        if (!m_meshes[i]) {
+            continue;
+        }
+        queue.push(m_meshes[i].get(), shader, m_modelMat, pass, &m_lods[i]);
+    }
+}
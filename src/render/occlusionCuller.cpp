@@ -0,0 +1,293 @@
+#include "dust/render/occlusionCuller.hpp"
+
+#include "dust/core/log.hpp"
+#include "dust/core/profiling.hpp"
+
+#include "glm/common.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <map>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define DUST_OCCLUSION_SSE
+#endif
+
+namespace dr = dust::render;
+
+/// rows rasterized by one task
+constexpr u32 BAND_HEIGHT = 16;
+/// boxes tested by one task
+constexpr u32 BOX_BATCH = 256;
+
+dr::OcclusionCuller::OcclusionCuller(u32 width, u32 height, u32 threadCount)
+    : m_width((std::max(width, 4u) + 3) & ~3u), m_height(std::max(height, 1u)), m_viewProj(1.f),
+      m_triangles(), m_levels(), m_stats(), m_workers(threadCount) {
+    DUST_PROFILE;
+    // max depth pyramid down to 1x1
+    u32 levelWidth = m_width, levelHeight = m_height;
+    while (true) {
+        m_levels.emplace_back(levelWidth * levelHeight, 1.f);
+        if (levelWidth == 1 && levelHeight == 1) break;
+        levelWidth  = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+
+    DUST_DEBUG("[OcclusionCuller] {}x{} depth buffer, {} levels, {} workers", m_width, m_height, m_levels.size(),
+               threadCount);
+}
+
+dr::OcclusionCuller::~OcclusionCuller() = default;
+
+void dr::OcclusionCuller::begin(const glm::mat4 &viewProj) {
+    m_viewProj = viewProj;
+    m_triangles.clear();
+    m_stats = Stats{};
+}
+
+void dr::OcclusionCuller::addOccluder(std::span<const glm::vec3> triangles, const glm::mat4 &model) {
+    const glm::mat4 transform = m_viewProj * model;
+    const glm::vec2 screen(m_width, m_height);
+    const u32 first = m_triangles.size();
+    for (u32 i = 0; i + 2 < triangles.size(); i += 3) {
+        glm::vec4 clip[3];
+        bool behind = false;
+        for (u32 v = 0; v < 3; ++v) {
+            clip[v] = transform * glm::vec4(triangles[i + v], 1.f);
+            // crossing the near plane: dropping an occluder stays conservative
+            behind |= clip[v].z < -clip[v].w || clip[v].w <= 1e-6f;
+        }
+        if (behind) continue;
+        // outside of one side of the frustum
+        if ((clip[0].x > clip[0].w && clip[1].x > clip[1].w && clip[2].x > clip[2].w)
+            || (clip[0].x < -clip[0].w && clip[1].x < -clip[1].w && clip[2].x < -clip[2].w)
+            || (clip[0].y > clip[0].w && clip[1].y > clip[1].w && clip[2].y > clip[2].w)
+            || (clip[0].y < -clip[0].w && clip[1].y < -clip[1].w && clip[2].y < -clip[2].w)) {
+            continue;
+        }
+
+        glm::vec3 vertices[3];
+        for (u32 v = 0; v < 3; ++v) {
+            const glm::vec3 ndc = glm::vec3(clip[v]) / clip[v].w;
+            vertices[v] = glm::vec3((glm::vec2(ndc.x, ndc.y) * .5f + .5f) * screen, ndc.z * .5f + .5f);
+        }
+        // occluders are double sided: counter clockwise in screen space
+        const f32 area = (vertices[1].x - vertices[0].x) * (vertices[2].y - vertices[0].y)
+                       - (vertices[1].y - vertices[0].y) * (vertices[2].x - vertices[0].x);
+        if (std::abs(area) < 1e-6f) continue;
+        if (area < 0.f) std::swap(vertices[1], vertices[2]);
+        m_triangles.push_back(ScreenTriangle{vertices[0], vertices[1], vertices[2], 0});
+    }
+    markInteriorEdges(first);
+}
+
+void dr::OcclusionCuller::markInteriorEdges(u32 first) {
+    // triangles are counter clockwise: neighbours on both sides of an edge walk it in opposite directions
+    std::map<std::array<f32, 4>, u32> openEdges;
+    for (u32 t = first; t < m_triangles.size(); ++t) {
+        const ScreenTriangle &triangle = m_triangles[t];
+        const glm::vec3 *vertices[3]   = {&triangle.v0, &triangle.v1, &triangle.v2};
+        for (u32 e = 0; e < 3; ++e) {
+            const glm::vec3 &a = *vertices[e], &b = *vertices[(e + 1) % 3];
+            const auto neighbour = openEdges.find({b.x, b.y, a.x, a.y});
+            if (neighbour == openEdges.end()) {
+                openEdges.emplace(std::array<f32, 4>{a.x, a.y, b.x, b.y}, t * 3 + e);
+                continue;
+            }
+
+            // the depth plane of a triangle only holds past the edge when the neighbour is coplanar
+            ScreenTriangle &other = m_triangles[neighbour->second / 3];
+            const u32 otherEdge   = neighbour->second % 3;
+            const glm::vec3 *otherVertices[3] = {&other.v0, &other.v1, &other.v2};
+            const glm::vec3 &p = *otherVertices[(otherEdge + 2) % 3];
+            const glm::vec3 &v0 = triangle.v0, &v1 = triangle.v1, &v2 = triangle.v2;
+            const f32 area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+            const f32 w1   = ((p.x - v0.x) * (v2.y - v0.y) - (p.y - v0.y) * (v2.x - v0.x)) / area;
+            const f32 w2   = ((v1.x - v0.x) * (p.y - v0.y) - (v1.y - v0.y) * (p.x - v0.x)) / area;
+            const f32 z    = v0.z + w1 * (v1.z - v0.z) + w2 * (v2.z - v0.z);
+            if (std::abs(z - p.z) > 1e-5f) continue;
+
+            m_triangles[t].interior |= 1u << e;
+            other.interior |= 1u << otherEdge;
+            openEdges.erase(neighbour);
+        }
+    }
+}
+
+void dr::OcclusionCuller::rasterize() {
+    DUST_PROFILE_SECTION("OcclusionCuller::rasterize");
+    m_stats.occluderTriangles = m_triangles.size();
+    const u32 bands = (m_height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    m_workers.dispatch(bands, [&](u32 band) {
+        rasterizeBand(band * BAND_HEIGHT, std::min(m_height, (band + 1) * BAND_HEIGHT));
+    });
+    buildPyramid();
+}
+
+bool dr::OcclusionCuller::isVisible(const AABB &box) const {
+    if (!box.isValid()) return true;
+    glm::vec3 min(std::numeric_limits<f32>::max());
+    glm::vec3 max(std::numeric_limits<f32>::lowest());
+    for (u32 corner = 0; corner < 8; ++corner) {
+        const glm::vec3 point((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y,
+                              (corner & 4) ? box.max.z : box.min.z);
+        const glm::vec4 clip = m_viewProj * glm::vec4(point, 1.f);
+        // crossing the near plane: cannot be tested
+        if (clip.z < -clip.w || clip.w <= 1e-6f) return true;
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        min = glm::min(min, ndc);
+        max = glm::max(max, ndc);
+    }
+    // outside of the screen: left to the frustum culling
+    if (max.x < -1.f || min.x > 1.f || max.y < -1.f || min.y > 1.f) return true;
+
+    const f32 nearestDepth = min.z * .5f + .5f;
+    const i32 x0 = std::clamp((i32)std::floor((min.x * .5f + .5f) * m_width), 0, (i32)m_width - 1);
+    const i32 x1 = std::clamp((i32)std::floor((max.x * .5f + .5f) * m_width), 0, (i32)m_width - 1);
+    const i32 y0 = std::clamp((i32)std::floor((min.y * .5f + .5f) * m_height), 0, (i32)m_height - 1);
+    const i32 y1 = std::clamp((i32)std::floor((max.y * .5f + .5f) * m_height), 0, (i32)m_height - 1);
+
+    // level where the rectangle covers at most 2x2 texels
+    u32 level = 0;
+    while (level + 1 < m_levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+        ++level;
+    }
+    const u32 levelWidth = std::max(1u, (m_width + (1u << level) - 1) >> level);
+    const auto &depth    = m_levels[level];
+    f32 farthest = 0.f;
+    for (i32 y = y0 >> level; y <= (y1 >> level); ++y) {
+        for (i32 x = x0 >> level; x <= (x1 >> level); ++x) {
+            farthest = std::max(farthest, depth[y * levelWidth + x]);
+        }
+    }
+    return nearestDepth <= farthest;
+}
+
+u32 dr::OcclusionCuller::cull(std::span<const AABB> boxes, std::vector<u8> &visibility) {
+    DUST_PROFILE_SECTION("OcclusionCuller::cull");
+    visibility.resize(boxes.size());
+    const u32 batches = (boxes.size() + BOX_BATCH - 1) / BOX_BATCH;
+    m_workers.dispatch(batches, [&](u32 batch) {
+        const u32 last = std::min<u32>(boxes.size(), (batch + 1) * BOX_BATCH);
+        for (u32 i = batch * BOX_BATCH; i < last; ++i) visibility[i] = isVisible(boxes[i]);
+    });
+
+    u32 visible = 0;
+    for (const u8 v : visibility) visible += v;
+    m_stats.tested += boxes.size();
+    m_stats.occluded += boxes.size() - visible;
+    return visible;
+}
+
+const dr::OcclusionCuller::Stats &dr::OcclusionCuller::getStats() const {
+    return m_stats;
+}
+u32 dr::OcclusionCuller::getWidth() const {
+    return m_width;
+}
+u32 dr::OcclusionCuller::getHeight() const {
+    return m_height;
+}
+u32 dr::OcclusionCuller::getLevelCount() const {
+    return m_levels.size();
+}
+std::span<const f32> dr::OcclusionCuller::getLevel(u32 level) const {
+    return m_levels.at(level);
+}
+
+void dr::OcclusionCuller::rasterizeBand(u32 firstRow, u32 lastRow) {
+    f32 *depth = m_levels[0].data();
+    std::fill(depth + firstRow * m_width, depth + lastRow * m_width, 1.f);
+
+    for (const auto &triangle : m_triangles) {
+        const glm::vec3 &v0 = triangle.v0, &v1 = triangle.v1, &v2 = triangle.v2;
+        const i32 minY = std::max((i32)firstRow, (i32)std::floor(std::min({v0.y, v1.y, v2.y})));
+        const i32 maxY = std::min((i32)lastRow - 1, (i32)std::ceil(std::max({v0.y, v1.y, v2.y})));
+        if (minY > maxY) continue;
+        // blocks of 4 pixels
+        const i32 minX = std::max(0, (i32)std::floor(std::min({v0.x, v1.x, v2.x}))) & ~3;
+        const i32 maxX = std::min((i32)m_width - 1, (i32)std::ceil(std::max({v0.x, v1.x, v2.x})));
+        if (minX > maxX) continue;
+
+        // edge functions e(p) = a * p.x + b * p.y + c, positive inside.
+        // Conservative inward: the edges are moved in by half a pixel, a pixel center passes
+        // only when its 4 corners are inside, a partly covered pixel keeps what is behind.
+        // Edges shared with a coplanar neighbour stay, their pixels are covered by both sides
+        const glm::vec3 *edges[3][2] = {{&v0, &v1}, {&v1, &v2}, {&v2, &v0}};
+        f32 edgeA[3], edgeB[3], edgeC[3];
+        for (u32 e = 0; e < 3; ++e) {
+            const glm::vec3 &a = *edges[e][0], &b = *edges[e][1];
+            edgeA[e] = a.y - b.y;
+            edgeB[e] = b.x - a.x;
+            edgeC[e] = -edgeA[e] * a.x - edgeB[e] * a.y;
+            if (!(triangle.interior & (1u << e))) edgeC[e] -= .5f * (std::abs(edgeA[e]) + std::abs(edgeB[e]));
+        }
+        // depth plane, evaluated at the center it gives the farthest depth over the pixel
+        const f32 area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+        const f32 dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+        const f32 dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+        const f32 dzc  = v0.z - dzdx * v0.x - dzdy * v0.y + .5f * (std::abs(dzdx) + std::abs(dzdy));
+
+        for (i32 y = minY; y <= maxY; ++y) {
+            const f32 py = y + .5f;
+            f32 *row = depth + y * m_width;
+#ifdef DUST_OCCLUSION_SSE
+            const __m128 offsets = _mm_setr_ps(.5f, 1.5f, 2.5f, 3.5f);
+            __m128 rowEdge[3], stepEdge[3];
+            for (u32 e = 0; e < 3; ++e) {
+                rowEdge[e]  = _mm_set1_ps(edgeB[e] * py + edgeC[e]);
+                stepEdge[e] = _mm_set1_ps(edgeA[e]);
+            }
+            const __m128 rowDepth  = _mm_set1_ps(dzdy * py + dzc);
+            const __m128 stepDepth = _mm_set1_ps(dzdx);
+            const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f);
+            for (i32 x = minX; x <= maxX; x += 4) {
+                const __m128 px = _mm_add_ps(_mm_set1_ps((f32)x), offsets);
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepEdge[0], px), rowEdge[0]), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepEdge[1], px), rowEdge[1]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepEdge[2], px), rowEdge[2]), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+
+                __m128 z = _mm_add_ps(_mm_mul_ps(stepDepth, px), rowDepth);
+                z = _mm_min_ps(_mm_max_ps(z, zero), one);
+                const __m128 previous = _mm_loadu_ps(row + x);
+                const __m128 nearest  = _mm_min_ps(previous, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+            }
+#else
+            for (i32 x = minX; x <= maxX; ++x) {
+                const f32 px = x + .5f;
+                bool inside = true;
+                for (u32 e = 0; e < 3; ++e) inside &= edgeA[e] * px + edgeB[e] * py + edgeC[e] >= 0.f;
+                if (!inside) continue;
+                const f32 z = std::clamp(dzdx * px + dzdy * py + dzc, 0.f, 1.f);
+                row[x] = std::min(row[x], z);
+            }
+#endif
+        }
+    }
+}
+
+void dr::OcclusionCuller::buildPyramid() {
+    DUST_PROFILE_SECTION("OcclusionCuller::buildPyramid");
+    u32 width = m_width, height = m_height;
+    for (u32 level = 1; level < m_levels.size(); ++level) {
+        const auto &source = m_levels[level - 1];
+        auto &target = m_levels[level];
+        const u32 levelWidth  = (width + 1) / 2;
+        const u32 levelHeight = (height + 1) / 2;
+        for (u32 y = 0; y < levelHeight; ++y) {
+            const u32 y0 = 2 * y, y1 = std::min(2 * y + 1, height - 1);
+            for (u32 x = 0; x < levelWidth; ++x) {
+                const u32 x0 = 2 * x, x1 = std::min(2 * x + 1, width - 1);
+                target[y * levelWidth + x] = std::max(std::max(source[y0 * width + x0], source[y0 * width + x1]),
+                                                      std::max(source[y1 * width + x0], source[y1 * width + x1]));
+            }
+        }
+        width  = levelWidth;
+        height = levelHeight;
+    }
+}
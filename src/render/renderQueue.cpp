@@ -0,0 +1,365 @@
+#include "dust/render/renderQueue.hpp"
+
+#include "dust/core/profiling.hpp"
+#include "dust/render/glStateCache.hpp"
+#include "dust/render/mesh.hpp"
+#include "dust/render/occlusionCuller.hpp"
+#include "dust/render/renderAPI.hpp"
+#include "dust/render/shader.hpp"
+
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace dr = dust::render;
+
+dr::RenderQueue::RenderQueue()
+    : m_opaque(),
+      m_blended(),
+      m_sortBuffer(),
+      m_transforms(),
+      m_culler(),
+      m_visibility(),
+      m_frustum(),
+      m_culling(false),
+      m_occlusionCuller(nullptr),
+      m_bounds(),
+      m_occludeeBounds(),
+      m_occludees(),
+      m_occludeeVisibility(),
+      m_meshletCulling(true),
+      m_rangeCounts(),
+      m_rangeOffsets(),
+      m_viewPosition(0.f),
+      m_depthRange(1000.f),
+      m_lodSelector(),
+      m_stats() {
+}
+
+void dr::RenderQueue::setViewPosition(glm::vec3 position, f32 depthRange) {
+    m_viewPosition = position;
+    m_depthRange   = std::max(depthRange, 1e-3f);
+    m_lodSelector.setViewPosition(position);
+}
+
+void dr::RenderQueue::setLODSelection(f32 projectionScale, f32 maxError) {
+    m_lodSelector.setProjection(projectionScale, maxError);
+}
+
+void dr::RenderQueue::setFrustum(const Frustum &frustum) {
+    m_frustum = frustum;
+    m_culling = true;
+}
+
+void dr::RenderQueue::setOcclusionCuller(OcclusionCuller *culler) {
+    m_occlusionCuller = culler;
+}
+
+void dr::RenderQueue::setMeshletCulling(bool enabled) {
+    m_meshletCulling = enabled;
+}
+
+void dr::RenderQueue::push(Mesh *mesh, Shader *shader, const glm::mat4 &model, u8 pass, u8 *lod) {
+    if (mesh == nullptr || shader == nullptr || mesh->isHidden()) {
+        return;
+    }
+
+    const u16 depth    = quantizeDepth(model);
+    const u32 material = shader->isPositionOnly() ? 0 : mesh->getMaterialKey();
+    const u32 vao      = mesh->getVertexArray(shader);
+    const u32 program  = shader->getRenderID();
+
+    DrawPacket packet{};
+    packet.mesh      = mesh;
+    packet.shader    = shader;
+    packet.transform = static_cast<u32>(m_transforms.size());
+    m_transforms.push_back(model);
+    m_bounds.push_back(mesh->getBounds().transformed(model));
+    m_culler.push(m_bounds.back());
+
+    const auto &lods = mesh->getLODs();
+    const u32 level  = m_lodSelector.select(lods, model, mesh->getBounds(), lod != nullptr ? *lod : 0);
+    // passes without selection (shadows) keep the history of the main pass
+    if (lod != nullptr && m_lodSelector.isEnabled()) *lod = static_cast<u8>(level);
+    if (level > 0) {
+        // a coarse level is drawn as a single range, the meshlets only cover the first one
+        packet.firstRange = static_cast<u32>(m_rangeCounts.size());
+        packet.rangeCount = 1;
+        m_rangeCounts.push_back(static_cast<i32>(lods[level].indexCount));
+        m_rangeOffsets.push_back(
+            reinterpret_cast<const void *>(
+                static_cast<uintptr_t>(mesh->getFirstElement() + lods[level].firstIndex) * mesh->getIndexSize()));
+    }
+
+    if (mesh->isTransparent()) {
+        packet.key = MakeBlendedKey(pass, program, material, vao, depth);
+        m_blended.push_back(packet);
+    } else {
+        packet.key = MakeKey(pass, program, material, vao, depth);
+        m_opaque.push_back(packet);
+    }
+}
+
+void dr::RenderQueue::sort() {
+    DUST_PROFILE_SECTION("RenderQueue::Sort");
+    RadixSort(m_opaque, m_sortBuffer);
+    RadixSort(m_blended, m_sortBuffer);
+}
+
+void dr::RenderQueue::flush() {
+    DUST_PROFILE_SECTION("RenderQueue::Flush");
+    m_stats         = Stats{};
+    m_stats.packets = static_cast<u32>(m_opaque.size() + m_blended.size());
+    m_stats.visible = m_stats.packets;
+    if (m_culling) {
+        cull();
+    }
+    if (m_occlusionCuller != nullptr) {
+        cullOccluded();
+    }
+    if (m_culling && m_meshletCulling) {
+        cullMeshlets();
+    }
+    DUST_PROFILE_VALUE("Culled packets", static_cast<int64_t>(m_stats.culled));
+    DUST_PROFILE_VALUE("Occluded packets", static_cast<int64_t>(m_stats.occluded));
+    if (empty()) {
+        clear();
+        return;
+    }
+
+    sort();
+
+    GLStateCache::SetBlending(false);
+    submit(m_opaque);
+
+    if (!m_blended.empty()) {
+        GLStateCache::SetBlending(true);
+        GLStateCache::SetDepthWrite(false);
+        submit(m_blended);
+        GLStateCache::SetDepthWrite(true);
+    }
+    // renderer default state
+    GLStateCache::SetBlending(true);
+
+    DUST_PROFILE_VALUE("Draw calls", static_cast<int64_t>(m_stats.drawCalls));
+    DUST_PROFILE_VALUE("Triangles", static_cast<int64_t>(m_stats.triangles));
+    clear();
+}
+
+void dr::RenderQueue::clear() {
+    m_opaque.clear();
+    m_blended.clear();
+    m_transforms.clear();
+    m_bounds.clear();
+    m_culler.clear();
+    m_rangeCounts.clear();
+    m_rangeOffsets.clear();
+    m_culling         = false;
+    m_occlusionCuller = nullptr;
+}
+
+bool dr::RenderQueue::empty() const {
+    return m_opaque.empty() && m_blended.empty();
+}
+
+const dr::RenderQueue::Stats &dr::RenderQueue::getStats() const {
+    return m_stats;
+}
+
+u64 dr::RenderQueue::MakeKey(u8 pass, u32 shader, u32 material, u32 vao, u16 depth) {
+    return (static_cast<u64>(pass & 0xF) << 60)
+         | (static_cast<u64>(shader & 0xFFF) << 48)
+         | (static_cast<u64>(material & 0xFFFF) << 32)
+         | (static_cast<u64>(vao & 0xFFFF) << 16)
+         | static_cast<u64>(depth);
+}
+
+u64 dr::RenderQueue::MakeBlendedKey(u8 pass, u32 shader, u32 material, u32 vao, u16 depth) {
+    // farthest first
+    return (static_cast<u64>(pass & 0xF) << 60)
+         | (static_cast<u64>(static_cast<u16>(~depth)) << 44)
+         | (static_cast<u64>(shader & 0xFFF) << 32)
+         | (static_cast<u64>(material & 0xFFFF) << 16)
+         | static_cast<u64>(vao & 0xFFFF);
+}
+
+void dr::RenderQueue::cull() {
+    DUST_PROFILE_SECTION("RenderQueue::Cull");
+    m_stats.visible = m_culler.cull(m_frustum, m_visibility);
+    m_stats.culled  = m_stats.packets - m_stats.visible;
+    if (m_stats.culled == 0) {
+        return;
+    }
+    const auto culled = [&](const DrawPacket &packet) { return m_visibility[packet.transform] == 0; };
+    std::erase_if(m_opaque, culled);
+    std::erase_if(m_blended, culled);
+}
+
+void dr::RenderQueue::cullOccluded() {
+    DUST_PROFILE_SECTION("RenderQueue::CullOccluded");
+    // blended packets do not occlude but can be occluded
+    for (const auto &packet : m_opaque) {
+        const auto &occluder = packet.mesh->getOccluder();
+        if (!occluder.empty()) m_occlusionCuller->addOccluder(occluder, m_transforms[packet.transform]);
+    }
+    m_occlusionCuller->rasterize();
+
+    m_occludees.clear();
+    m_occludeeBounds.clear();
+    for (const auto *packets : {&m_opaque, &m_blended}) {
+        for (const auto &packet : *packets) {
+            m_occludees.push_back(packet.transform);
+            m_occludeeBounds.push_back(m_bounds[packet.transform]);
+        }
+    }
+    const u32 visible = m_occlusionCuller->cull(m_occludeeBounds, m_occludeeVisibility);
+    m_stats.occluded  = static_cast<u32>(m_occludees.size()) - visible;
+    m_stats.visible  -= m_stats.occluded;
+    if (m_stats.occluded == 0) {
+        return;
+    }
+    // per transform, like the frustum culling
+    m_visibility.assign(m_transforms.size(), 0);
+    for (u32 i = 0; i < m_occludees.size(); ++i) m_visibility[m_occludees[i]] = m_occludeeVisibility[i];
+    const auto occluded = [&](const DrawPacket &packet) { return m_visibility[packet.transform] == 0; };
+    std::erase_if(m_opaque, occluded);
+    std::erase_if(m_blended, occluded);
+}
+
+void dr::RenderQueue::cullMeshlets() {
+    DUST_PROFILE_SECTION("RenderQueue::CullMeshlets");
+    u32 dropped = 0;
+    for (auto *packets : {&m_opaque, &m_blended}) {
+        for (auto &packet : *packets) {
+            const auto &meshlets = packet.mesh->getMeshlets();
+            if (meshlets.empty() || packet.rangeCount > 0) continue;
+
+            const MeshletCuller culler(m_transforms[packet.transform], &m_frustum, m_viewPosition);
+            const u32 firstElement = packet.mesh->getFirstElement();
+            const u32 indexSize    = packet.mesh->getIndexSize();
+            packet.firstRange = static_cast<u32>(m_rangeCounts.size());
+            u32 end = 0;
+            for (const auto &meshlet : meshlets) {
+                if (!culler.isVisible(meshlet)) {
+                    ++m_stats.culledMeshlets;
+                    continue;
+                }
+                // merge consecutive meshlets
+                if (m_rangeCounts.size() > packet.firstRange && meshlet.firstIndex == end) {
+                    m_rangeCounts.back() += static_cast<i32>(meshlet.indexCount);
+                } else {
+                    m_rangeCounts.push_back(static_cast<i32>(meshlet.indexCount));
+                    m_rangeOffsets.push_back(
+                        reinterpret_cast<const void *>(static_cast<uintptr_t>(firstElement + meshlet.firstIndex) * indexSize));
+                }
+                end = meshlet.firstIndex + meshlet.indexCount;
+            }
+            packet.rangeCount = static_cast<u32>(m_rangeCounts.size()) - packet.firstRange;
+            m_stats.meshlets += static_cast<u32>(meshlets.size());
+            if (packet.rangeCount == 0) {
+                // no meshlet left: dropped below
+                packet.mesh = nullptr;
+                ++dropped;
+            }
+        }
+    }
+    if (dropped == 0) {
+        return;
+    }
+    m_stats.visible -= dropped;
+    m_stats.culled += dropped;
+    const auto empty = [](const DrawPacket &packet) { return packet.mesh == nullptr; };
+    std::erase_if(m_opaque, empty);
+    std::erase_if(m_blended, empty);
+}
+
+void dr::RenderQueue::submit(const std::vector<DrawPacket> &packets) {
+    DUST_PROFILE_GPU("RenderQueue::Submit");
+    Shader *currentShader = nullptr;
+    Mesh *previousMesh    = nullptr;
+    u32 currentVAO        = 0;
+
+    for (const auto &packet : packets) {
+        if (packet.shader != currentShader) {
+            packet.shader->use();
+            currentShader = packet.shader;
+            ++m_stats.shaderSwitches;
+        }
+
+        // materials write into their own shader, only the changed slots are rebound;
+        // position only shaders (depth, shadows) read none
+        if (!packet.shader->isPositionOnly()) {
+            if (packet.mesh->bindMaterials(previousMesh)) {
+                ++m_stats.materialSwitches;
+            }
+            previousMesh = packet.mesh;
+        }
+
+        const u32 vao = packet.mesh->getVertexArray(packet.shader);
+        if (vao != currentVAO) {
+            GLStateCache::BindVertexArray(vao);
+            currentVAO = vao;
+            ++m_stats.vaoSwitches;
+        }
+
+        currentShader->setUniform("uModel", packet.mesh->getVertexTransform(m_transforms[packet.transform]));
+        if (packet.rangeCount > 0) {
+            packet.mesh->drawGeometryRanges(&m_rangeCounts[packet.firstRange], &m_rangeOffsets[packet.firstRange],
+                                            packet.rangeCount);
+            for (u32 i = 0; i < packet.rangeCount; ++i) m_stats.triangles += m_rangeCounts[packet.firstRange + i] / 3;
+        } else {
+            packet.mesh->drawGeometry();
+            m_stats.triangles += packet.mesh->getTriangleCount();
+        }
+        ++m_stats.drawCalls;
+    }
+
+    if (previousMesh) {
+        previousMesh->unbindMaterials();
+    }
+}
+
+u16 dr::RenderQueue::quantizeDepth(const glm::mat4 &model) const {
+    const glm::vec3 position(model[3]);
+    const f32 distance = glm::length(position - m_viewPosition);
+    const f32 normalized = std::clamp(distance / m_depthRange, 0.f, 1.f);
+    return static_cast<u16>(normalized * 65535.f);
+}
+
+void dr::RenderQueue::RadixSort(std::vector<DrawPacket> &packets, std::vector<DrawPacket> &buffer) {
+    if (packets.size() < 2) {
+        return;
+    }
+    buffer.resize(packets.size());
+
+    // LSD radix sort on 8 bits digits, stable
+    std::vector<DrawPacket> *src = &packets;
+    std::vector<DrawPacket> *dst = &buffer;
+    for (u32 shift = 0; shift < 64; shift += 8) {
+        std::array<size_t, 256> count{};
+        for (const auto &packet : *src) {
+            ++count[(packet.key >> shift) & 0xFF];
+        }
+        // every key share this digit, nothing to reorder
+        if (count[((*src)[0].key >> shift) & 0xFF] == src->size()) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (auto &c : count) {
+            const size_t n = c;
+            c = offset;
+            offset += n;
+        }
+        for (const auto &packet : *src) {
+            (*dst)[count[(packet.key >> shift) & 0xFF]++] = packet;
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != &packets) {
+        packets.swap(buffer);
+    }
+}
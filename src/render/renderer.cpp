@@ -1,7 +1,9 @@
 #include "dust/render/renderer.hpp"
 #include "dust/core/log.hpp"
 #include "dust/core/profiling.hpp"
+#include "dust/render/glStateCache.hpp"
 #include "dust/render/renderAPI.hpp"
+#include "dust/render/camera.hpp"
 
 #include "GLFW/glfw3.h"
 #include "backends/imgui_impl_opengl3.h"
@@ -99,10 +101,11 @@ dust::Renderer::Renderer(const dust::Window &window) {
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
     glEnable(GL_STENCIL_TEST);
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask(GL_TRUE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    render::GLStateCache::SetDepthTest(true);
+    render::GLStateCache::SetDepthWrite(true);
+    render::GLStateCache::SetDepthFunc(GL_LESS);
+    render::GLStateCache::SetBlending(true);
+    render::GLStateCache::SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 #ifdef _DEBUG
     DUST_INFO("[OpenGL] Set up debug message callback.");
@@ -113,21 +116,39 @@ dust::Renderer::Renderer(const dust::Window &window) {
     if (!GLAD_GL_ARB_geometry_shader4)
         DUST_WARN("Nsight will output errors. (GL_ARB_geometry_shader4 not supported)");
 
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    render::GLStateCache::SetCulling(true);
+    render::GLStateCache::SetCullFace(GL_BACK);
+    render::GLStateCache::SetPolygonMode(GL_FILL);
     glFrontFace(GL_CCW);
 
     setClearColor(.1f, .1f, .1f);
     resize(window.getWidth(), window.getHeight());
+
+    m_frameBuffer  = createScope<render::UniformBuffer>(sizeof(render::FrameData), render::FRAME_BINDING);
+    m_viewBuffer   = createScope<render::UniformBuffer>(sizeof(render::ViewData), render::VIEW_BINDING);
+    m_lightBuffer  = createScope<render::UniformBuffer>(sizeof(render::LightData), render::LIGHT_BINDING);
+    m_shadowBuffer = createScope<render::UniformBuffer>(sizeof(render::ShadowData), render::SHADOW_BINDING);
+    m_clusterBuffer = createScope<render::UniformBuffer>(sizeof(render::ClusterData), render::CLUSTER_BINDING);
+    m_materialTable = createScope<render::MaterialTable>();
+    m_streamBuffer  = createScope<render::StreamBuffer>();
 }
 
 dust::Renderer::~Renderer() {
     DUST_PROFILE;
+    m_frameBuffer.reset();
+    m_viewBuffer.reset();
+    m_lightBuffer.reset();
+    m_shadowBuffer.reset();
+    m_clusterBuffer.reset();
+    m_materialTable.reset();
+    m_streamBuffer.reset();
     DUST_INFO("[Glad] Unloading OpenGL");
 }
 
 void dust::Renderer::newFrame() {
     DUST_PROFILE_GPU("renderer new frame");
+    render::GLStateCache::NewFrame();
+    m_streamBuffer->beginFrame();
     clear();
     ImGui_ImplOpenGL3_NewFrame();
 }
@@ -150,20 +171,17 @@ void dust::Renderer::clear(bool clearColor) {
 void dust::Renderer::endFrame() {
     DUST_PROFILE_GPU("end frame");
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    m_streamBuffer->endFrame();
 }
 
 void dust::Renderer::setCulling(bool culling) {
     DUST_PROFILE_GPU("renderer set culling");
-    if (culling) {
-        glEnable(GL_CULL_FACE);
-    } else {
-        glDisable(GL_CULL_FACE);
-    }
+    render::GLStateCache::SetCulling(culling);
 }
 void dust::Renderer::setCullFaces(bool back, bool front) {
     DUST_PROFILE_GPU("renderer set cull face");
-    glCullFace(back ? (front ? GL_FRONT_AND_BACK : GL_BACK)
-                    : (front ? GL_FRONT : GL_BACK));
+    render::GLStateCache::SetCullFace(back ? (front ? GL_FRONT_AND_BACK : GL_BACK)
+                                   : (front ? GL_FRONT : GL_BACK));
 }
 
 void dust::Renderer::setClearColor(float r, float g, float b, float a) {
@@ -176,15 +194,11 @@ void dust::Renderer::setClearColor(glm::vec4 color) {
 
 void dust::Renderer::setDepthWrite(bool write) {
     DUST_PROFILE_GPU("renderer set depth write");
-    glDepthMask(write);
+    render::GLStateCache::SetDepthWrite(write);
 }
 void dust::Renderer::setDepthTest(bool test) {
     DUST_PROFILE_GPU("renderer set depth test");
-    if (test) {
-        glEnable(GL_DEPTH_TEST);
-    } else {
-        glDisable(GL_DEPTH_TEST);
-    }
+    render::GLStateCache::SetDepthTest(test);
 }
 
 void dust::Renderer::resize(u32 width, u32 height) {
@@ -194,9 +208,40 @@ void dust::Renderer::resize(u32 width, u32 height) {
 
 void dust::Renderer::setDrawWireframe(bool wireframe) {
     DUST_PROFILE_GPU("renderer set wireframe");
-    if (wireframe) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    } else {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    }
+    render::GLStateCache::SetPolygonMode(wireframe ? GL_LINE : GL_FILL);
+}
+
+void dust::Renderer::setFrameData(const render::FrameData &data) {
+    DUST_PROFILE_GPU("renderer set frame data");
+    m_frameBuffer->update(data);
+}
+
+void dust::Renderer::setViewData(const render::ViewData &data) {
+    DUST_PROFILE_GPU("renderer set view data");
+    m_viewBuffer->update(data);
+}
+
+void dust::Renderer::setView(render::Camera *camera, bool force) {
+    if (camera == nullptr || !(force || camera->isDirty())) return;
+    setViewData(camera->getViewData());
+    camera->setDirty(false);
+}
+
+void dust::Renderer::setLightData(const render::LightData &data) {
+    DUST_PROFILE_GPU("renderer set light data");
+    m_lightBuffer->update(data);
+}
+
+void dust::Renderer::setShadowData(const render::ShadowData &data) {
+    DUST_PROFILE_GPU("renderer set shadow data");
+    m_shadowBuffer->update(data);
+}
+
+void dust::Renderer::setClusterData(const render::ClusterData &data) {
+    DUST_PROFILE_GPU("renderer set cluster data");
+    m_clusterBuffer->update(data);
+}
+
+dust::render::StreamBuffer *dust::Renderer::getStreamBuffer() const {
+    return m_streamBuffer.get();
 }
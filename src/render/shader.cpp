@@ -4,6 +4,7 @@
 #include "dust/core/profiling.hpp"
 #include "dust/io/assetsManager.hpp"
 #include "dust/io/loaders.hpp"
+#include "dust/render/glStateCache.hpp"
 #include "dust/render/mesh.hpp"
 #include "dust/render/renderAPI.hpp"
 
@@ -28,52 +29,74 @@ dr::Shader::Shader(const std::string &vertexCode, const std::string &fragmentCod
 dr::Shader::Shader() : dust::io::ResourceFile(""), m_renderID(0), m_uniforms() {}
 dr::Shader::~Shader() {
     DUST_PROFILE;
-    glUseProgram(0);
-    glDeleteProgram(m_renderID);
+    GLStateCache::DeleteProgram(m_renderID);
 }
 
 void dr::Shader::use() const {
-    DUST_PROFILE_GPU("UseProgram");
-    glUseProgram(m_renderID);
+    GLStateCache::UseProgram(m_renderID);
 }
 
-void dr::Shader::setUniform(const std::string &name, bool value) {
-    const u32 loc = getUniformLocation(name);
+u32 dr::Shader::getRenderID() const {
+    return m_renderID;
+}
+
+void dr::Shader::setPositionOnly(bool positionOnly) {
+    if (positionOnly && !m_readsPositionOnly) {
+        DUST_ERROR("[Shader] {} reads more than the positions, it can not be position only", m_vertexFilePath);
+        return;
+    }
+    m_positionOnly = positionOnly;
+}
+
+bool dr::Shader::isPositionOnly() const {
+    return m_positionOnly;
+}
+
+dr::UniformHandle dr::Shader::getUniformHandle(StringID name) const {
+    const auto found = m_uniforms.find(name);
+    if (found == m_uniforms.end()) {
+        return UniformHandle{};
+    }
+    return UniformHandle{static_cast<i32>(found->second.index)};
+}
+
+void dr::Shader::setUniform(UniformHandle handle, bool value) {
+    const i32 loc = handle.location;
     DUST_PROFILE_GPU("glProgramUniform1i bool");
     glProgramUniform1i(m_renderID, loc, (int)value);
 }
 
-void dr::Shader::setUniform(const std::string &name, int value) {
-    const u32 loc = getUniformLocation(name);
+void dr::Shader::setUniform(UniformHandle handle, int value) {
+    const i32 loc = handle.location;
     DUST_PROFILE_GPU("glProgramUniform1i");
     glProgramUniform1i(m_renderID, loc, value);
 }
 
-void dr::Shader::setUniform(const std::string &name, float value) {
-    const u32 loc = getUniformLocation(name);
+void dr::Shader::setUniform(UniformHandle handle, float value) {
+    const i32 loc = handle.location;
     DUST_PROFILE_GPU("glProgramUniform1f");
     glProgramUniform1f(m_renderID, loc, value);
 }
 
-void dr::Shader::setUniform(const std::string &name, glm::vec2 value) {
-    const u32 loc = getUniformLocation(name);
+void dr::Shader::setUniform(UniformHandle handle, glm::vec2 value) {
+    const i32 loc = handle.location;
     DUST_PROFILE_GPU("glProgramUniform2f");
     glProgramUniform2f(m_renderID, loc, value.x, value.y);
 }
 
-void dr::Shader::setUniform(const std::string &name, glm::vec3 value) {
-    const u32 loc = getUniformLocation(name);
+void dr::Shader::setUniform(UniformHandle handle, glm::vec3 value) {
+    const i32 loc = handle.location;
     DUST_PROFILE_GPU("glProgramUniform3f");
     glProgramUniform3f(m_renderID, loc, value.x, value.y, value.z);
 }
 
-void dr::Shader::setUniform(const std::string &name, glm::vec4 value) {
-    const u32 loc = getUniformLocation(name);
+void dr::Shader::setUniform(UniformHandle handle, glm::vec4 value) {
+    const i32 loc = handle.location;
     DUST_PROFILE_GPU("glProgramUniform4f");
     glProgramUniform4f(m_renderID, loc, value.x, value.y, value.z, value.w);
 }
-void dr::Shader::setUniform(const std::string &name, glm::mat4 value) {
-    const u32 loc = getUniformLocation(name);
+void dr::Shader::setUniform(UniformHandle handle, glm::mat4 value) {
+    const i32 loc = handle.location;
     DUST_PROFILE_GPU("glProgramUniformMatrix4fv");
     glProgramUniformMatrix4fv(m_renderID, loc, 1, GL_FALSE, glm::value_ptr(value));
 }
@@ -85,8 +108,7 @@ void dr::Shader::reload(bool _firstLoad) {
     if (resultVert.has_value() && resultFrag.has_value()) {
         u32 reloadedShaderID = internalCreate(resultVert.value(), resultFrag.value());
         if (reloadedShaderID != 0) {
-            glUseProgram(0);
-            glDeleteProgram(m_renderID);
+            GLStateCache::DeleteProgram(m_renderID);
             m_renderID = reloadedShaderID;
         }
     }
@@ -108,16 +130,6 @@ dust::Result<dr::ShaderPtr> dr::Shader::LoadFromFile(const std::string &vertexPa
     return {};
 }
 
-u32 dr::Shader::getUniformLocation(const std::string &name) {
-    DUST_PROFILE;
-    const auto found = m_uniforms.find(name);
-    if (found == m_uniforms.end()) {
-        // DUST_DEBUG("[Shader Uniforms] {} not found", name);
-        return -1;
-    }
-    return found->second.index;
-}
-
 u32 dr::Shader::internalCreate(const std::string &vertexCode, const std::string &fragmentCode) {
     DUST_PROFILE_GPU("Shader program creation");
     const u32 vertex = compileShader(GL_VERTEX_SHADER, vertexCode);
@@ -152,6 +164,7 @@ u32 dr::Shader::internalCreate(const std::string &vertexCode, const std::string
 
     // Parse active uniforms
     queryActiveUniforms(renderID);
+    queryActiveAttributes(renderID);
 
     glDeleteShader(vertex);
     glDeleteShader(fragment);
@@ -211,7 +224,6 @@ void dr::Shader::queryActiveUniforms(u32 program) {
     DUST_PROFILE_GPU("glGetActiveUniform queries");
     m_uniforms.clear(); // empty uniforms.
     int uniformCount;
-    glUseProgram(program);
     glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
     u32 type;
     int length, size;
@@ -254,9 +266,34 @@ void dr::Shader::queryActiveUniforms(u32 program) {
             break;
         }
         DUST_DEBUG("[OpenGL][Shader Uniform] {} at {} (type = {})", name, uIndex, type);
-        m_uniforms.insert({std::string(name), u});
+        if (!m_uniforms.insert({StringID::Runtime(name), u}).second) {
+            DUST_ERROR("[Shader Uniforms] {} hash collides with another uniform", name);
+        }
+    }
+}
+
+void dr::Shader::queryActiveAttributes(u32 program) {
+    DUST_PROFILE_GPU("glGetActiveAttrib queries");
+    int attributeCount;
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &attributeCount);
+    u32 type;
+    int length, size;
+    char name[MAX_UNIFORM_NAME_SIZE];
+    u32 inputs = 0;
+    bool position = false;
+    for (u32 i = 0; i < attributeCount; ++i) {
+        glGetActiveAttrib(program, i, MAX_UNIFORM_NAME_SIZE, &length, &size, &type, name);
+        const i32 location = glGetAttribLocation(program, name);
+        // built-ins (gl_VertexID, ...) have no location
+        if (location < 0) continue;
+        ++inputs;
+        position |= location == 0;
+    }
+    m_readsPositionOnly = inputs == 1 && position;
+    if (m_positionOnly && !m_readsPositionOnly) {
+        DUST_ERROR("[Shader] {} reads more than the positions, it is no longer position only", m_vertexFilePath);
+        m_positionOnly = false;
     }
-    glUseProgram(0);
 }
 
 /*************************************/
@@ -277,8 +314,7 @@ void dr::PackedShader::reload(bool _firstLoad) {
         auto [vertCode, fragCode] = processCode(result.value());
         u32 reloadedShaderID = internalCreate(vertCode, fragCode);
         if (reloadedShaderID != 0) {
-            glUseProgram(0);
-            glDeleteProgram(m_renderID);
+            GLStateCache::DeleteProgram(m_renderID);
             m_renderID = reloadedShaderID;
         }
     }
@@ -4,6 +4,7 @@
 #include "dust/core/profiling.hpp"
 #include "dust/core/types.hpp"
 #include "dust/io/assetsManager.hpp"
+#include "dust/render/glStateCache.hpp"
 #include "dust/render/renderAPI.hpp"
 #include "dust/render/texture.hpp"
 
@@ -53,20 +54,23 @@ m_shader(dust::createRef<Shader>(vCode, fCode))
 {
     DUST_PROFILE_SECTION("Skybox::Constructor");
     io::Path assetsDirPath = io::AssetsManager::GetAssetsDir();
-    glGenTextures(1, &m_renderID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_renderID);
+    glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &m_renderID);
     // load each side
     u32 index = 0;
     int width, height, nrChannels;
+    bool allocated = false;
     stbi_set_flip_vertically_on_load(false);
     for(auto path : skyboxTexturePaths)
     {
         io::Path imagePath = assetsDirPath / path;
-        u8 *data = stbi_load(imagePath.string().c_str(), &width, &height, &nrChannels, 0);
+        u8 *data = stbi_load(imagePath.string().c_str(), &width, &height, &nrChannels, STBI_rgb_alpha);
         if (data != nullptr) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + index, 
-                         0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data
-            );
+            // every face has the size of the first one
+            if(!allocated) {
+                glTextureStorage2D(m_renderID, 1, GL_RGBA8, width, height);
+                allocated = true;
+            }
+            glTextureSubImage3D(m_renderID, 0, 0, 0, index, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
         }
         else {
             DUST_ERROR("[Skybox] Cubemap tex failed to load {}", path);
@@ -74,12 +78,11 @@ m_shader(dust::createRef<Shader>(vCode, fCode))
         stbi_image_free(data);
         ++index;
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    glTextureParameteri(m_renderID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(m_renderID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(m_renderID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(m_renderID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(m_renderID, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
     m_shader->setUniform("uSkybox", 0);
 
@@ -89,7 +92,7 @@ m_shader(dust::createRef<Shader>(vCode, fCode))
 dr::Skybox::~Skybox()
 {
     DUST_PROFILE;
-    glDeleteTextures(1, &m_renderID);
+    GLStateCache::DeleteTexture(m_renderID);
     m_mesh.reset();
     m_shader.reset();
 }
@@ -98,19 +101,18 @@ void dr::Skybox::draw(Camera* camera)
 {
     DUST_PROFILE_GPU("Skybox draw");
     // disable depth
-    glDisable(GL_CULL_FACE);
-    glDepthFunc(GL_LEQUAL);
+    GLStateCache::SetCulling(false);
+    GLStateCache::SetDepthFunc(GL_LEQUAL);
 
     glm::mat4 viewNoTranslation = glm::mat4(glm::mat3(camera->getView()));
     m_shader->setUniform("uProj", camera->getProj());
     m_shader->setUniform("uView", viewNoTranslation);
 
     // bind cubemap
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_renderID);
+    GLStateCache::BindTexture(0, GL_TEXTURE_CUBE_MAP, m_renderID);
 
     m_mesh->draw(m_shader.get());
  
-    glDepthFunc(GL_LESS);
-    glEnable(GL_CULL_FACE);
+    GLStateCache::SetDepthFunc(GL_LESS);
+    GLStateCache::SetCulling(true);
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "dust/render/streamBuffer.hpp"
+
+#include "dust/core/log.hpp"
+#include "dust/core/profiling.hpp"
+#include "dust/render/renderAPI.hpp"
+
+#include <algorithm>
+
+namespace dr = dust::render;
+
+dr::StreamBuffer::StreamBuffer(u32 regionSize, u32 regionCount)
+    : m_renderID(0), m_mapped(nullptr), m_regionSize(regionSize), m_regionCount(std::max(regionCount, 1u)),
+      m_region(0), m_head(0), m_fences(m_regionCount, nullptr), m_waitCount(0),
+      m_storageAlignment(16) {
+    DUST_PROFILE;
+    GLint alignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0) m_storageAlignment = alignment;
+
+    glCreateBuffers(1, &m_renderID);
+    if (m_renderID == 0) {
+        DUST_ERROR("[OpenGL][StreamBuffer] Failed to create buffer");
+        return;
+    }
+    const u32 flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glNamedBufferStorage(m_renderID, (GLsizeiptr)m_regionSize * m_regionCount, nullptr, flags);
+    m_mapped = (u8 *)glMapNamedBufferRange(m_renderID, 0, (GLsizeiptr)m_regionSize * m_regionCount, flags);
+    if (m_mapped == nullptr) {
+        DUST_ERROR("[OpenGL][StreamBuffer] Failed to map buffer {}", m_renderID);
+        return;
+    }
+    DUST_DEBUG("[OpenGL] Created StreamBuffer {} ({} x {} bytes)", m_renderID, m_regionCount, m_regionSize);
+    if (s_instance == nullptr) s_instance = this;
+}
+
+dr::StreamBuffer::~StreamBuffer() {
+    DUST_PROFILE;
+    for (void *fence : m_fences) {
+        if (fence) glDeleteSync((GLsync)fence);
+    }
+    if (m_renderID) {
+        if (m_mapped) glUnmapNamedBuffer(m_renderID);
+        glDeleteBuffers(1, &m_renderID);
+    }
+    if (s_instance == this) s_instance = nullptr;
+}
+
+void dr::StreamBuffer::beginFrame() {
+    DUST_PROFILE;
+    m_region = (m_region + 1) % m_regionCount;
+    m_head   = 0;
+
+    auto fence = (GLsync)m_fences[m_region];
+    if (fence == nullptr) return;
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        DUST_PROFILE_SECTION("StreamBuffer::wait");
+        ++m_waitCount;
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+    if (status == GL_WAIT_FAILED) {
+        DUST_ERROR("[OpenGL][StreamBuffer] Failed to wait for region {}", m_region);
+    }
+    glDeleteSync(fence);
+    m_fences[m_region] = nullptr;
+}
+
+void dr::StreamBuffer::endFrame() {
+    if (m_fences[m_region]) glDeleteSync((GLsync)m_fences[m_region]);
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+dr::StreamAllocation dr::StreamBuffer::allocate(u32 size, u32 alignment) {
+    if (m_mapped == nullptr || size == 0) return StreamAllocation{};
+    const u32 head = (m_head + alignment - 1) & ~(alignment - 1);
+    if (head + size > m_regionSize) {
+        DUST_DEBUG("[StreamBuffer] Region full ({} + {} > {} bytes)", head, size, m_regionSize);
+        return StreamAllocation{};
+    }
+    m_head           = head + size;
+    const u32 offset = m_region * m_regionSize + head;
+    return StreamAllocation{m_mapped + offset, offset, size};
+}
+
+u32 dr::StreamBuffer::getRenderID() const {
+    return m_renderID;
+}
+u32 dr::StreamBuffer::getRegionSize() const {
+    return m_regionSize;
+}
+u32 dr::StreamBuffer::getUsed() const {
+    return m_head;
+}
+u32 dr::StreamBuffer::getWaitCount() const {
+    return m_waitCount;
+}
+u32 dr::StreamBuffer::getStorageAlignment() const {
+    return m_storageAlignment;
+}
+
+dr::StreamBuffer *dr::StreamBuffer::Get() {
+    return s_instance;
+}
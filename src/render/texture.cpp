@@ -2,14 +2,16 @@
 #include "dust/core/log.hpp"
 #include "dust/core/profiling.hpp"
 #include "dust/core/types.hpp"
+#include "dust/render/glStateCache.hpp"
 #include "dust/render/renderAPI.hpp"
-#include <GL/gl.h>
+#include <algorithm>
 #include <filesystem>
 
 namespace dr = dust::render;
 
 dr::TexturePtr dr::Texture::s_nullTexture = nullptr;
 
+/// pixel transfer format of data with `channels` channels
 static u32 toGLFormat(u32 channels)
 {
     switch (channels) {
@@ -22,12 +24,50 @@ static u32 toGLFormat(u32 channels)
     }
 }
 
+static u32 toGLInternalFormat(u32 channels)
+{
+    switch (channels) {
+        case 4: return GL_RGBA8;
+        case 3: return GL_RGB8;
+        case 2: return GL_RG8;
+        case 1:
+        case 0:
+        default: return GL_R8;
+    }
+}
+
+/// block compressed formats of the core profile (RGTC for 1-2 channels, BPTC otherwise)
+static u32 toGLCompressedFormat(u32 channels)
+{
+    switch (channels) {
+        case 2: return GL_COMPRESSED_RG_RGTC2;
+        case 1:
+        case 0: return GL_COMPRESSED_RED_RGTC1;
+        default: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+}
+
+static u32 compressedLevelSize(u32 channels, u32 width, u32 height)
+{
+    // 4x4 blocks of 8 (RGTC1) or 16 bytes
+    const u32 blockSize = channels <= 1 ? 8 : 16;
+    return ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+static u32 mipLevelCount(u32 width, u32 height)
+{
+    u32 levels = 1;
+    for(u32 size = std::max(width, height); size > 1; size >>= 1) ++levels;
+    return levels;
+}
+
 dr::Texture::Texture(u32 width, u32 height, u32 channels) 
-: m_channels(channels),
+: m_renderID(0),
 m_apiType(GL_TEXTURE_2D),
-m_height(height), m_width(width),
 m_lastIndex(0),
-m_renderID(0)
+m_width(width), m_height(height),
+m_channels(channels),
+m_layers(1)
 { 
     DUST_PROFILE;
 }
@@ -37,8 +77,8 @@ bool dr::Texture::internalCreate(u32 apiTextureType)
 {
     DUST_PROFILE;
     m_apiType = apiTextureType;
-    DUST_PROFILE_GPU("GenTextures");
-    glGenTextures(1, &m_renderID);
+    DUST_PROFILE_GPU("CreateTextures");
+    glCreateTextures(apiTextureType, 1, &m_renderID);
     if(m_renderID == 0) {
         DUST_ERROR("[OpenGL][Texture] Failed to create a texture.");
         return false;
@@ -46,6 +86,24 @@ bool dr::Texture::internalCreate(u32 apiTextureType)
     return true;
 }
 
+void dr::Texture::applyParam(const TextureParam &param, bool mipMaps)
+{
+    glTextureParameteri(m_renderID, GL_TEXTURE_MAG_FILTER, apiValue(param.filter, false));
+    glTextureParameteri(m_renderID, GL_TEXTURE_MIN_FILTER, apiValue(param.filter, mipMaps));
+    glTextureParameteri(m_renderID, GL_TEXTURE_WRAP_S, apiValue(param.wrap));
+    glTextureParameteri(m_renderID, GL_TEXTURE_WRAP_T, apiValue(param.wrap));
+    if(m_apiType == GL_TEXTURE_CUBE_MAP) {
+        glTextureParameteri(m_renderID, GL_TEXTURE_WRAP_R, apiValue(param.wrap));
+    }
+    // grey images are sampled as colors
+    const bool grey      = param.format == TextureFormat::R8 || (param.format == TextureFormat::Auto && m_channels <= 1);
+    const bool greyAlpha = param.format == TextureFormat::Auto && m_channels == 2;
+    if(grey || greyAlpha) {
+        const GLint swizzle[] = {GL_RED, GL_RED, GL_RED, greyAlpha ? GL_GREEN : GL_ONE};
+        glTextureParameteriv(m_renderID, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+}
+
 dr::TexturePtr dr::Texture::CreateTexture2D(u32 width, u32 height, u32 channels, void* data, const TextureParam& param) 
 {
     DUST_PROFILE_SECTION("Texture 2D flat");
@@ -55,50 +113,91 @@ dr::TexturePtr dr::Texture::CreateTexture2D(u32 width, u32 height, u32 channels,
       return GetNullTexture();
     }
 
-    glBindTexture(GL_TEXTURE_2D, texture->m_renderID);
-    DUST_PROFILE_GPU("TexImage2D");
-    glTexImage2D(GL_TEXTURE_2D, 0, toGLFormat(channels), width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, apiValue(param.filter, false));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, apiValue(param.filter, param.mipMaps));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, apiValue(param.wrap));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, apiValue(param.wrap));
-    if(param.mipMaps) {
+    const u32 levels = param.mipMaps ? mipLevelCount(width, height) : 1;
+    {
+        DUST_PROFILE_GPU("TextureStorage2D");
+        glTextureStorage2D(texture->m_renderID, levels, apiInternalFormat(param.format, channels), width, height);
+    }
+    texture->applyParam(param, param.mipMaps);
+    if(data != nullptr) {
+        DUST_PROFILE_GPU("TextureSubImage2D");
+        glTextureSubImage2D(texture->m_renderID, 0, 0, 0, width, height, toGLFormat(channels), GL_UNSIGNED_BYTE, data);
+    }
+    if(param.mipMaps && data != nullptr) {
         DUST_DEBUG("[OpenGL][Texture] Creating mipmaps...");
         DUST_PROFILE_GPU("GenerateMipmap");
-        glGenerateMipmap(GL_TEXTURE_2D);
+        glGenerateTextureMipmap(texture->m_renderID);
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
 
     DUST_DEBUG("[OpenGL] Created Texture {}", texture->m_renderID);
     return texture;
 }
 
-dr::TexturePtr dr::Texture::CreateTexture2DArray(u32 width, u32 height, u32 channels, std::vector<void *>, const TextureParam &param)
+dr::TexturePtr dr::Texture::CreateTexture2DArray(u32 width, u32 height, u32 channels, std::vector<void *> layers, const TextureParam &param)
 {
     DUST_PROFILE_SECTION("Texture 2D Array");
+    if(layers.empty()) {
+        DUST_ERROR("[OpenGL][Texture] Cannot create a texture array without layers.");
+        return GetNullTexture();
+    }
     TexturePtr texture = TexturePtr(new Texture(width, height, channels));
     if(!texture->internalCreate(GL_TEXTURE_2D_ARRAY)) {
         texture.reset();
         return GetNullTexture();
     }
-    // TODO: Implement texture arrays
-    DUST_WARN("[OpenGL] [Texture] Texture 2D Arrays creation is not implemented yet.");
+    texture->m_layers = layers.size();
+
+    const u32 levels = param.mipMaps ? mipLevelCount(width, height) : 1;
+    {
+        DUST_PROFILE_GPU("TextureStorage3D");
+        glTextureStorage3D(texture->m_renderID, levels, apiInternalFormat(param.format, channels), width, height, layers.size());
+    }
+    texture->applyParam(param, param.mipMaps);
+    u32 uploaded = 0;
+    for(u32 layer = 0; layer < layers.size(); ++layer) {
+        if(layers.at(layer) == nullptr) continue;
+        DUST_PROFILE_GPU("TextureSubImage3D");
+        glTextureSubImage3D(texture->m_renderID, 0, 0, 0, layer, width, height, 1, toGLFormat(channels), GL_UNSIGNED_BYTE, layers.at(layer));
+        ++uploaded;
+    }
+    if(param.mipMaps && uploaded > 0) {
+        DUST_DEBUG("[OpenGL][Texture] Creating mipmaps...");
+        DUST_PROFILE_GPU("GenerateMipmap");
+        glGenerateTextureMipmap(texture->m_renderID);
+    }
+
+    DUST_DEBUG("[OpenGL] Created Texture Array {} ({}x{}, {} layers)", texture->m_renderID, width, height, layers.size());
     return texture;
 }
 
+void dr::Texture::uploadLayer(u32 layer, const void *data)
+{
+    DUST_PROFILE;
+    if(m_apiType != GL_TEXTURE_2D_ARRAY || layer >= m_layers) {
+        DUST_ERROR("[OpenGL][Texture] Layer {} is out of texture {} range.", layer, m_renderID);
+        return;
+    }
+    DUST_PROFILE_GPU("TextureSubImage3D");
+    glTextureSubImage3D(m_renderID, 0, 0, 0, layer, m_width, m_height, 1, toGLFormat(m_channels), GL_UNSIGNED_BYTE, data);
+}
+
+void dr::Texture::generateMipmaps()
+{
+    DUST_PROFILE;
+    DUST_PROFILE_GPU("GenerateMipmap");
+    glGenerateTextureMipmap(m_renderID);
+}
+
 dr::TexturePtr dr::Texture::CreateTextureRaw(int apiType, u32 width, u32 height, u32 channels)
 {
     DUST_PROFILE_SECTION("Texture Flat");
     TexturePtr texture = TexturePtr(new Texture(width, height, channels));
     if(texture->internalCreate(apiType)) {
-        texture->bind();
-        DUST_PROFILE_GPU("TexImage2D");
-        glTexImage2D(apiType, 0, toGLFormat(channels), width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); // reserve memory
-        glTexParameteri(apiType, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(apiType, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(apiType, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(apiType, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        texture->unbind();
+        // no storage: the caller allocates and uploads the levels itself (i.e. DDS loader)
+        glTextureParameteri(texture->m_renderID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(texture->m_renderID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(texture->m_renderID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTextureParameteri(texture->m_renderID, GL_TEXTURE_WRAP_T, GL_REPEAT);
     }
     return texture;
 }
@@ -111,22 +210,18 @@ dr::TexturePtr dr::Texture::CreateTextureCubeMap(u32 width, u32 height, u32 chan
         texture.reset();
         return GetNullTexture();
     }
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texture->m_renderID);
-    u32 index = 0;
-    for(auto face : faces)
     {
-        DUST_PROFILE_GPU("TexImage2D");
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + index, 
-             0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, face
-        );
-        ++index;
+        DUST_PROFILE_GPU("TextureStorage2D");
+        glTextureStorage2D(texture->m_renderID, 1, apiInternalFormat(param.format, channels), width, height);
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, apiValue(param.filter, false));
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, apiValue(param.filter, false));
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, apiValue(param.wrap));
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, apiValue(param.wrap));
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, apiValue(param.wrap));
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    // faces are the layers of the cube map
+    for(u32 index = 0; index < std::min<u32>(faces.size(), 6); ++index)
+    {
+        if(faces.at(index) == nullptr) continue;
+        DUST_PROFILE_GPU("TextureSubImage3D");
+        glTextureSubImage3D(texture->m_renderID, 0, 0, 0, index, width, height, 1, toGLFormat(channels), GL_UNSIGNED_BYTE, faces.at(index));
+    }
+    texture->applyParam(param, false);
     return texture;
 
 }
@@ -139,25 +234,27 @@ dr::TexturePtr dr::Texture::CreateTexture2D(u32 width, u32 height, u32 channels,
         texture.reset();
         return GetNullTexture();
     }
-    glBindTexture(GL_TEXTURE_2D, texture->m_renderID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, apiValue(param.filter, false));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, apiValue(param.filter, param.mipMaps));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, apiValue(param.wrap));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, apiValue(param.wrap));
-    for(int i = 0; i < data.size(); ++i) {
-        DUST_PROFILE_GPU("TexImage2D");
-        glTexImage2D(GL_TEXTURE_2D, i, toGLFormat(channels), width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.at(i));
+    const u32 levels = param.mipMaps ? mipLevelCount(width, height) : std::max<u32>(data.size(), 1);
+    {
+        DUST_PROFILE_GPU("TextureStorage2D");
+        glTextureStorage2D(texture->m_renderID, levels, apiInternalFormat(param.format, channels), width, height);
+    }
+    texture->applyParam(param, levels > 1);
+    const u32 given = std::min<u32>(data.size(), levels);
+    for(u32 i = 0; i < given; ++i) {
+        DUST_PROFILE_GPU("TextureSubImage2D");
+        glTextureSubImage2D(texture->m_renderID, i, 0, 0, std::max(width >> i, 1u), std::max(height >> i, 1u),
+                            toGLFormat(channels), GL_UNSIGNED_BYTE, data.at(i));
     }
-    if(data.size() > 0) {
+    // missing levels
+    if(given > 0 && given < levels) {
         DUST_DEBUG("[OpenGL][Texture] Creating mipmaps...");
         DUST_PROFILE_GPU("GenerateMipmap");
-        glGenerateMipmap(GL_TEXTURE_2D);
+        glGenerateTextureMipmap(texture->m_renderID);
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
 
     DUST_DEBUG("[OpenGL] Created Texture {}", texture->m_renderID);
     return texture;
-    return texture;
 }
 
 dr::TexturePtr dr::Texture::CreateTextureCompressed2D(u32 width, u32 height, u32 channels, u32 size, std::vector<void *> data, const TextureParam &param)
@@ -169,26 +266,40 @@ dr::TexturePtr dr::Texture::CreateTextureCompressed2D(u32 width, u32 height, u32
         return GetNullTexture();
     }
 
-    glBindTexture(GL_TEXTURE_2D, texture->m_renderID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, apiValue(param.filter, false));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, apiValue(param.filter, true));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, apiValue(param.wrap));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, apiValue(param.wrap));
-    for(int i = 0; i < data.size(); ++i) {
-        DUST_PROFILE_GPU("CompressedTexImage2D");
-        glCompressedTexImage2D(GL_TEXTURE_2D, i, toGLFormat(channels), width, height, 0, size, data.at(i));
+    const u32 levels = std::max<u32>(data.size(), 1);
+    {
+        DUST_PROFILE_GPU("TextureStorage2D");
+        glTextureStorage2D(texture->m_renderID, levels, toGLCompressedFormat(channels), width, height);
     }
-    if(data.size() > 0) {
-        DUST_DEBUG("[OpenGL][Texture] Creating mipmaps...");
-        DUST_PROFILE_GPU("GenerateMipmap");
-        glGenerateMipmap(GL_TEXTURE_2D);
+    texture->applyParam(param, levels > 1);
+    for(u32 i = 0; i < data.size(); ++i) {
+        const u32 levelSize = compressedLevelSize(channels, std::max(width >> i, 1u), std::max(height >> i, 1u));
+        if(i == 0 && levelSize != size) {
+            DUST_ERROR("[OpenGL][Texture] Compressed base level is {} bytes, expected {}.", size, levelSize);
+        }
+        DUST_PROFILE_GPU("CompressedTextureSubImage2D");
+        glCompressedTextureSubImage2D(texture->m_renderID, i, 0, 0, std::max(width >> i, 1u), std::max(height >> i, 1u),
+                                      toGLCompressedFormat(channels), levelSize, data.at(i));
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
 
     DUST_DEBUG("[OpenGL] Created Texture {}", texture->m_renderID);
     return texture;
 }
 
+u32 dr::Texture::apiInternalFormat(TextureFormat format, u32 channels)
+{
+    switch(format) {
+        case TextureFormat::R8:           return GL_R8;
+        case TextureFormat::RG8:          return GL_RG8;
+        case TextureFormat::RGB8:         return GL_RGB8;
+        case TextureFormat::RGBA8:        return GL_RGBA8;
+        case TextureFormat::SRGB8:        return GL_SRGB8;
+        case TextureFormat::SRGB8_ALPHA8: return GL_SRGB8_ALPHA8;
+        case TextureFormat::Auto:
+        default: return toGLInternalFormat(channels);
+    }
+}
+
 u32 dr::Texture::apiValue(TextureWrap wrap)
 {
     switch(wrap) {
@@ -211,24 +322,19 @@ u32 dr::Texture::apiValue(TextureFilter filter, bool mipMaps)
 dr::Texture::~Texture()
 {
     DUST_PROFILE;
-    unbind();
-    glDeleteTextures(1, &m_renderID);
+    GLStateCache::DeleteTexture(m_renderID);
 }
 
 void dr::Texture::bind(u16 index)
 {
     DUST_PROFILE;
     m_lastIndex = index;
-    glActiveTexture(GL_TEXTURE0 + m_lastIndex);
-    DUST_PROFILE_GPU("BindTexture");
-    glBindTexture(m_apiType, m_renderID);
+    GLStateCache::BindTexture(m_lastIndex, m_apiType, m_renderID);
 }
-void dr::Texture::unbind()  // PIKMIN
+void dr::Texture::unbind()
 {
     DUST_PROFILE;
-    glActiveTexture(GL_TEXTURE0 + m_lastIndex);
-    DUST_PROFILE_GPU("UnbindTexture");
-    glBindTexture(m_apiType, m_renderID);
+    GLStateCache::BindTexture(m_lastIndex, m_apiType, 0);
 }
 
 u32 dr::Texture::getWidth() const
@@ -244,6 +350,11 @@ u32 dr::Texture::getChannels() const
     return m_channels;
 }
 
+u32 dr::Texture::getLayers() const
+{
+    return m_layers;
+}
+
 u32 dr::Texture::getRenderID() const
 {
     return m_renderID;
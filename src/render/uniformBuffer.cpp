@@ -0,0 +1,54 @@
+#include "dust/render/uniformBuffer.hpp"
+
+#include "dust/core/log.hpp"
+#include "dust/core/profiling.hpp"
+#include "dust/render/renderAPI.hpp"
+
+namespace dr = dust::render;
+
+static_assert(sizeof(dr::FrameData) == 16, "FrameData must match its std140 layout");
+static_assert(sizeof(dr::ViewData) == 208, "ViewData must match its std140 layout");
+static_assert(sizeof(dr::LightData) == 32 + DUST_MAX_LIGHTS * 64, "LightData must match its std140 layout");
+static_assert(sizeof(dr::ClusterData) == 32, "ClusterData must match its std140 layout");
+
+dr::UniformBuffer::UniformBuffer(u32 size, u32 binding)
+    : m_renderID(0), m_size(size), m_binding(binding) {
+    DUST_PROFILE;
+    glCreateBuffers(1, &m_renderID);
+    if (m_renderID == 0) {
+        DUST_ERROR("[OpenGL][UniformBuffer] Failed to create buffer");
+        return;
+    }
+    DUST_PROFILE_GPU("NamedBufferStorage (UBO)");
+    glNamedBufferStorage(m_renderID, size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    bind();
+    DUST_DEBUG("[OpenGL] Created UniformBuffer {} ({} bytes) at binding {}", m_renderID, size, binding);
+}
+
+dr::UniformBuffer::~UniformBuffer() {
+    DUST_PROFILE;
+    if (m_renderID) glDeleteBuffers(1, &m_renderID);
+}
+
+void dr::UniformBuffer::update(const void *data, u32 size, u32 offset) {
+    if (offset + size > m_size) {
+        DUST_ERROR("[UniformBuffer] Update out of range ({} + {} > {})", offset, size, m_size);
+        return;
+    }
+    DUST_PROFILE_GPU("NamedBufferSubData (UBO)");
+    glNamedBufferSubData(m_renderID, offset, size, data);
+}
+
+void dr::UniformBuffer::bind() const {
+    glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_renderID);
+}
+
+u32 dr::UniformBuffer::getRenderID() const {
+    return m_renderID;
+}
+u32 dr::UniformBuffer::getSize() const {
+    return m_size;
+}
+u32 dr::UniformBuffer::getBinding() const {
+    return m_binding;
+}
@@ -0,0 +1,30 @@
+#include "dust/render/vertexLayout.hpp"
+
+#include "dust/core/profiling.hpp"
+#include "dust/render/renderAPI.hpp"
+
+namespace dr = dust::render;
+
+static_assert(static_cast<u32>(dr::ComponentType::Byte) == GL_BYTE);
+static_assert(static_cast<u32>(dr::ComponentType::UByte) == GL_UNSIGNED_BYTE);
+static_assert(static_cast<u32>(dr::ComponentType::Short) == GL_SHORT);
+static_assert(static_cast<u32>(dr::ComponentType::UShort) == GL_UNSIGNED_SHORT);
+static_assert(static_cast<u32>(dr::ComponentType::Int) == GL_INT);
+static_assert(static_cast<u32>(dr::ComponentType::UInt) == GL_UNSIGNED_INT);
+static_assert(static_cast<u32>(dr::ComponentType::Float) == GL_FLOAT);
+static_assert(static_cast<u32>(dr::ComponentType::Half) == GL_HALF_FLOAT);
+
+void dr::VertexFormat::apply(u32 vertexArray, u32 binding) const {
+    DUST_PROFILE_GPU("VertexFormat");
+    for (const auto &attribute : attributes) {
+        const auto type = static_cast<GLenum>(attribute.type);
+        glEnableVertexArrayAttrib(vertexArray, attribute.location);
+        if (attribute.integer) {
+            glVertexArrayAttribIFormat(vertexArray, attribute.location, attribute.count, type, attribute.offset);
+        } else {
+            glVertexArrayAttribFormat(vertexArray, attribute.location, attribute.count, type,
+                                      attribute.normalized ? GL_TRUE : GL_FALSE, attribute.offset);
+        }
+        glVertexArrayAttribBinding(vertexArray, attribute.location, binding);
+    }
+}
@@ -0,0 +1,96 @@
+#include "dust/render/vertexPacking.hpp"
+
+#include "dust/core/profiling.hpp"
+
+#include "glm/geometric.hpp"
+#include "glm/packing.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace dr = dust::render;
+
+bool dr::VertexPacking::CanPack(std::span<const ModelVertex> vertices) {
+    return std::all_of(vertices.begin(), vertices.end(),
+                       [](const ModelVertex &vertex) { return vertex.materialID >= 0.f && vertex.materialID <= 255.f; });
+}
+
+bool dr::VertexPacking::HasColors(std::span<const ModelVertex> vertices) {
+    return std::any_of(vertices.begin(), vertices.end(), [](const ModelVertex &vertex) {
+        return vertex.color.x != 0.f || vertex.color.y != 0.f || vertex.color.z != 0.f || vertex.color.w != 0.f;
+    });
+}
+
+glm::mat4 dr::VertexPacking::Dequantization(const AABB &bounds) {
+    if (!bounds.isValid()) return glm::mat4(1.f);
+    const glm::vec3 size = bounds.max - bounds.min;
+    const f32 extent     = std::max({size.x, size.y, size.z});
+    glm::mat4 dequantization(extent > 0.f ? extent : 1.f);
+    dequantization[3] = glm::vec4(bounds.min, 1.f);
+    return dequantization;
+}
+
+std::vector<u8> dr::VertexPacking::Pack(std::span<const ModelVertex> vertices, const AABB &bounds, bool colors) {
+    DUST_PROFILE_SECTION("VertexPacking::Pack");
+    const glm::mat4 dequantization = Dequantization(bounds);
+    const glm::vec3 offset(dequantization[3].x, dequantization[3].y, dequantization[3].z);
+    const f32 scale = 1.f / dequantization[0].x;
+
+    const u32 stride = Format(colors).stride;
+    std::vector<u8> packed(vertices.size() * stride);
+    for (u32 v = 0; v < vertices.size(); ++v) {
+        const auto &vertex = vertices[v];
+        const glm::vec3 position = (vertex.pos - offset) * scale;
+        const glm::vec3 tangent(vertex.tangent.x, vertex.tangent.y, vertex.tangent.z);
+
+        PackedModelVertex result{};
+        result.position[0]   = glm::packUnorm2x16(glm::vec2(position.x, position.y));
+        result.position[1]   = glm::packUnorm2x16(glm::vec2(position.z, vertex.tangent.w < 0.f ? 0.f : 1.f));
+        result.texCoord      = glm::packHalf2x16(vertex.tex);
+        result.normal        = glm::packSnorm2x16(EncodeOctahedral(vertex.normal));
+        result.tangent       = glm::packSnorm2x16(EncodeOctahedral(tangent));
+        result.materialID[0] = static_cast<u8>(vertex.materialID);
+        result.color         = glm::packUnorm4x8(vertex.color);
+        std::memcpy(packed.data() + v * stride, &result, stride);
+    }
+    return packed;
+}
+
+std::vector<dr::PackedPositionLayout::Vertex>
+dr::VertexPacking::PackPositions(std::span<const glm::vec3> positions, const AABB &bounds) {
+    DUST_PROFILE_SECTION("VertexPacking::PackPositions");
+    const glm::mat4 dequantization = Dequantization(bounds);
+    const glm::vec3 offset(dequantization[3].x, dequantization[3].y, dequantization[3].z);
+    const f32 scale = 1.f / dequantization[0].x;
+
+    std::vector<PackedPositionLayout::Vertex> packed(positions.size());
+    for (u32 p = 0; p < positions.size(); ++p) {
+        // same operations as Pack so that depth tested passes match exactly
+        const glm::vec3 position = (positions[p] - offset) * scale;
+        const std::array<u32, 2> words{glm::packUnorm2x16(glm::vec2(position.x, position.y)),
+                                       glm::packUnorm2x16(glm::vec2(position.z, 1.f))};
+        std::memcpy(packed[p].data.data(), words.data(), sizeof(words));
+    }
+    return packed;
+}
+
+glm::vec2 dr::VertexPacking::EncodeOctahedral(glm::vec3 direction) {
+    const f32 norm = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    // null directions (missing normals or tangents) are encoded as +z
+    if (norm <= 0.f) return glm::vec2(0.f);
+    direction /= norm;
+    if (direction.z >= 0.f) return glm::vec2(direction.x, direction.y);
+    // fold the lower hemisphere over the diagonals
+    return glm::vec2((1.f - std::abs(direction.y)) * (direction.x >= 0.f ? 1.f : -1.f),
+                     (1.f - std::abs(direction.x)) * (direction.y >= 0.f ? 1.f : -1.f));
+}
+
+glm::vec3 dr::VertexPacking::DecodeOctahedral(glm::vec2 encoded) {
+    glm::vec3 direction(encoded.x, encoded.y, 1.f - std::abs(encoded.x) - std::abs(encoded.y));
+    const f32 fold = std::max(-direction.z, 0.f);
+    direction.x += direction.x >= 0.f ? -fold : fold;
+    direction.y += direction.y >= 0.f ? -fold : fold;
+    return glm::normalize(direction);
+}
@@ -0,0 +1,336 @@
+#include "dust/scene/bvh.hpp"
+
+#include "dust/core/log.hpp"
+#include "dust/core/profiling.hpp"
+
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace ds = dust::scene;
+namespace dr = dust::render;
+
+static_assert(sizeof(ds::BVHNode) == 32, "BVHNode must stay 32 bytes (two nodes per cache line)");
+
+/// half surface area, 0 for an empty box
+static f32 Area(const dr::AABB &box) {
+    if (!box.isValid()) return 0.f;
+    const glm::vec3 e = box.max - box.min;
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+static f32 Area(const ds::BVHNode &node) {
+    return Area(dr::AABB{node.min, node.max});
+}
+
+/**
+ * @brief Test a box against the planes of `mask`, the planes the box is fully inside of are removed
+ * @return false if the box is outside
+ */
+static bool Classify(glm::vec3 min, glm::vec3 max, const dr::Frustum &frustum, u32 &mask) {
+    const glm::vec3 center = (min + max) * .5f;
+    const glm::vec3 extent = (max - min) * .5f;
+    for (u32 p = 0; p < dr::Frustum::PLANE_COUNT; ++p) {
+        if ((mask & (1u << p)) == 0) continue;
+        const glm::vec4 &plane = frustum.planes[p];
+        const f32 distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        const f32 radius   = glm::dot(glm::abs(glm::vec3(plane)), extent);
+        if (distance + radius < 0.f) return false;
+        if (distance - radius >= 0.f) mask &= ~(1u << p);
+    }
+    return true;
+}
+
+/// entry distance of the ray in the box, negative on miss
+static f32 IntersectBox(glm::vec3 min, glm::vec3 max, const ds::Ray &ray, glm::vec3 invDirection, f32 maxDistance) {
+    const glm::vec3 t1   = (min - ray.origin) * invDirection;
+    const glm::vec3 t2   = (max - ray.origin) * invDirection;
+    const glm::vec3 entry = glm::min(t1, t2);
+    const glm::vec3 exit  = glm::max(t1, t2);
+    const f32 tEntry = std::max(std::max(entry.x, entry.y), std::max(entry.z, 0.f));
+    const f32 tExit  = std::min(std::min(exit.x, exit.y), std::min(exit.z, maxDistance));
+    return tEntry <= tExit ? tEntry : -1.f;
+}
+
+static bool OverlapSphere(glm::vec3 min, glm::vec3 max, glm::vec3 center, f32 radius) {
+    const glm::vec3 closest = glm::clamp(center, min, max);
+    const glm::vec3 delta   = closest - center;
+    return glm::dot(delta, delta) <= radius * radius;
+}
+
+ds::BVH::BVH() : m_nodes(), m_nodeCount(0), m_indices(), m_boxes(), m_centroids() {
+}
+
+void ds::BVH::build(std::span<const render::AABB> boxes) {
+    DUST_PROFILE_SECTION("BVH::build");
+    clear();
+    if (boxes.empty()) return;
+
+    const u32 count = boxes.size();
+    m_boxes.assign(boxes.begin(), boxes.end());
+    m_indices.resize(count);
+    m_centroids.resize(count);
+    for (u32 i = 0; i < count; ++i) {
+        m_indices[i]   = i;
+        m_centroids[i] = m_boxes[i].getCenter();
+    }
+
+    // a binary tree over N leaves has at most 2N - 1 nodes
+    m_nodes.resize(2 * count - 1);
+    m_nodeCount = 1;
+    BVHNode &root = m_nodes[0];
+    root.leftFirst = 0;
+    root.count     = count;
+    updateBounds(root);
+    subdivide(0);
+
+    m_nodes.resize(m_nodeCount);
+    m_nodes.shrink_to_fit();
+    m_centroids.clear();
+    m_centroids.shrink_to_fit();
+    DUST_DEBUG("[BVH] Built {} nodes over {} primitives", m_nodeCount, count);
+}
+
+void ds::BVH::clear() {
+    m_nodes.clear();
+    m_nodeCount = 0;
+    m_indices.clear();
+    m_boxes.clear();
+}
+
+void ds::BVH::setBox(u32 primitive, const render::AABB &box) {
+    m_boxes.at(primitive) = box;
+}
+
+void ds::BVH::refit() {
+    DUST_PROFILE_SECTION("BVH::refit");
+    // children are always stored after their parent
+    for (i32 i = (i32)m_nodeCount - 1; i >= 0; --i) {
+        BVHNode &node = m_nodes[i];
+        if (node.isLeaf()) {
+            updateBounds(node);
+            continue;
+        }
+        const BVHNode &left  = m_nodes[node.leftFirst];
+        const BVHNode &right = m_nodes[node.leftFirst + 1];
+        node.min = glm::min(left.min, right.min);
+        node.max = glm::max(left.max, right.max);
+    }
+}
+
+void ds::BVH::cull(const render::Frustum &frustum, std::vector<u32> &visible) const {
+    DUST_PROFILE_SECTION("BVH::cull");
+    if (empty()) return;
+    constexpr u32 ALL_PLANES = (1u << render::Frustum::PLANE_COUNT) - 1;
+
+    // node and the planes it still crosses
+    std::vector<std::pair<u32, u32>> stack{};
+    stack.reserve(64);
+    stack.emplace_back(0, ALL_PLANES);
+    while (!stack.empty()) {
+        auto [index, mask] = stack.back();
+        stack.pop_back();
+        const BVHNode &node = m_nodes[index];
+        if (mask != 0 && !Classify(node.min, node.max, frustum, mask)) continue;
+
+        if (!node.isLeaf()) {
+            stack.emplace_back(node.leftFirst + 1, mask);
+            stack.emplace_back(node.leftFirst, mask);
+            continue;
+        }
+        for (u32 i = node.leftFirst; i < node.leftFirst + node.count; ++i) {
+            const u32 primitive = m_indices[i];
+            u32 primitiveMask   = mask;
+            const auto &box     = m_boxes[primitive];
+            if (primitiveMask == 0 || Classify(box.min, box.max, frustum, primitiveMask)) {
+                visible.push_back(primitive);
+            }
+        }
+    }
+}
+
+ds::RayHit ds::BVH::intersect(const Ray &ray) const {
+    RayHit hit{};
+    if (empty()) return hit;
+    const glm::vec3 invDirection = 1.f / ray.direction;
+    f32 maxDistance = ray.maxDistance;
+
+    if (IntersectBox(m_nodes[0].min, m_nodes[0].max, ray, invDirection, maxDistance) < 0.f) return hit;
+    std::vector<u32> stack{};
+    stack.reserve(64);
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const BVHNode &node = m_nodes[stack.back()];
+        stack.pop_back();
+        if (node.isLeaf()) {
+            for (u32 i = node.leftFirst; i < node.leftFirst + node.count; ++i) {
+                const auto &box = m_boxes[m_indices[i]];
+                const f32 distance = IntersectBox(box.min, box.max, ray, invDirection, maxDistance);
+                if (distance >= 0.f && distance < hit.distance) {
+                    hit.primitive = m_indices[i];
+                    hit.distance  = distance;
+                    maxDistance   = distance;
+                }
+            }
+            continue;
+        }
+
+        // nearest child first, subtrees farther than the best hit are skipped
+        u32 nearChild = node.leftFirst, farChild = node.leftFirst + 1;
+        f32 nearDistance = IntersectBox(m_nodes[nearChild].min, m_nodes[nearChild].max, ray, invDirection, maxDistance);
+        f32 farDistance  = IntersectBox(m_nodes[farChild].min, m_nodes[farChild].max, ray, invDirection, maxDistance);
+        if (farDistance >= 0.f && (nearDistance < 0.f || farDistance < nearDistance)) {
+            std::swap(nearChild, farChild);
+            std::swap(nearDistance, farDistance);
+        }
+        if (farDistance >= 0.f) stack.push_back(farChild);
+        if (nearDistance >= 0.f) stack.push_back(nearChild);
+    }
+    return hit;
+}
+
+void ds::BVH::overlap(glm::vec3 center, f32 radius, std::vector<u32> &primitives) const {
+    if (empty()) return;
+    std::vector<u32> stack{};
+    stack.reserve(64);
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const BVHNode &node = m_nodes[stack.back()];
+        stack.pop_back();
+        if (!OverlapSphere(node.min, node.max, center, radius)) continue;
+        if (!node.isLeaf()) {
+            stack.push_back(node.leftFirst + 1);
+            stack.push_back(node.leftFirst);
+            continue;
+        }
+        for (u32 i = node.leftFirst; i < node.leftFirst + node.count; ++i) {
+            const auto &box = m_boxes[m_indices[i]];
+            if (OverlapSphere(box.min, box.max, center, radius)) primitives.push_back(m_indices[i]);
+        }
+    }
+}
+
+const dr::AABB &ds::BVH::getBox(u32 primitive) const {
+    return m_boxes.at(primitive);
+}
+
+std::span<const ds::BVHNode> ds::BVH::getNodes() const {
+    return {m_nodes.data(), m_nodeCount};
+}
+
+u32 ds::BVH::getPrimitiveCount() const {
+    return m_boxes.size();
+}
+
+bool ds::BVH::empty() const {
+    return m_nodeCount == 0;
+}
+
+void ds::BVH::updateBounds(BVHNode &node) const {
+    render::AABB bounds{};
+    for (u32 i = node.leftFirst; i < node.leftFirst + node.count; ++i) bounds.extend(m_boxes[m_indices[i]]);
+    node.min = bounds.min;
+    node.max = bounds.max;
+}
+
+void ds::BVH::subdivide(u32 nodeIndex) {
+    // iterative: degenerate inputs can make the tree deep
+    std::vector<u32> stack{nodeIndex};
+    while (!stack.empty()) {
+        const u32 index = stack.back();
+        stack.pop_back();
+        BVHNode &node = m_nodes[index];
+        if (node.count <= 1) continue;
+
+        u32 axis;
+        f32 position;
+        const f32 splitCost = findSplit(node, axis, position);
+        if (splitCost == std::numeric_limits<f32>::max()) continue;
+        // costs relative to a box test: splitting adds the traversal of the node
+        const f32 leafCost = node.count * Area(node);
+        if (splitCost + Area(node) >= leafCost && node.count <= MAX_LEAF_SIZE) continue;
+
+        // partition the primitives around the split plane
+        i32 i = node.leftFirst;
+        i32 j = i + node.count - 1;
+        while (i <= j) {
+            if (m_centroids[m_indices[i]][axis] < position) {
+                ++i;
+            } else {
+                std::swap(m_indices[i], m_indices[j--]);
+            }
+        }
+        const u32 leftCount = i - node.leftFirst;
+        if (leftCount == 0 || leftCount == node.count) continue;
+
+        const u32 left  = m_nodeCount++;
+        const u32 right = m_nodeCount++;
+        m_nodes[left].leftFirst  = node.leftFirst;
+        m_nodes[left].count      = leftCount;
+        m_nodes[right].leftFirst = i;
+        m_nodes[right].count     = node.count - leftCount;
+        node.leftFirst = left;
+        node.count     = 0;
+        updateBounds(m_nodes[left]);
+        updateBounds(m_nodes[right]);
+        stack.push_back(right);
+        stack.push_back(left);
+    }
+}
+
+f32 ds::BVH::findSplit(const BVHNode &node, u32 &axis, f32 &position) const {
+    struct Bin {
+        render::AABB bounds{};
+        u32 count{0};
+    };
+
+    f32 bestCost = std::numeric_limits<f32>::max();
+    for (u32 a = 0; a < 3; ++a) {
+        f32 centroidMin = std::numeric_limits<f32>::max();
+        f32 centroidMax = std::numeric_limits<f32>::lowest();
+        for (u32 i = node.leftFirst; i < node.leftFirst + node.count; ++i) {
+            centroidMin = std::min(centroidMin, m_centroids[m_indices[i]][a]);
+            centroidMax = std::max(centroidMax, m_centroids[m_indices[i]][a]);
+        }
+        if (centroidMin == centroidMax) continue;
+
+        std::array<Bin, BIN_COUNT> bins{};
+        const f32 scale = BIN_COUNT / (centroidMax - centroidMin);
+        for (u32 i = node.leftFirst; i < node.leftFirst + node.count; ++i) {
+            const u32 primitive = m_indices[i];
+            const u32 bin = std::min(BIN_COUNT - 1, (u32)((m_centroids[primitive][a] - centroidMin) * scale));
+            bins[bin].count++;
+            bins[bin].bounds.extend(m_boxes[primitive]);
+        }
+
+        // sweep from both sides: cost of splitting after each bin
+        std::array<f32, BIN_COUNT - 1> leftArea, rightArea;
+        std::array<u32, BIN_COUNT - 1> leftCount, rightCount;
+        render::AABB leftBox{}, rightBox{};
+        u32 leftSum = 0, rightSum = 0;
+        for (u32 i = 0; i < BIN_COUNT - 1; ++i) {
+            leftSum += bins[i].count;
+            leftCount[i] = leftSum;
+            leftBox.extend(bins[i].bounds);
+            leftArea[i] = Area(leftBox);
+
+            rightSum += bins[BIN_COUNT - 1 - i].count;
+            rightCount[BIN_COUNT - 2 - i] = rightSum;
+            rightBox.extend(bins[BIN_COUNT - 1 - i].bounds);
+            rightArea[BIN_COUNT - 2 - i] = Area(rightBox);
+        }
+        for (u32 i = 0; i < BIN_COUNT - 1; ++i) {
+            if (leftCount[i] == 0 || rightCount[i] == 0) continue;
+            const f32 cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+            if (cost < bestCost) {
+                bestCost = cost;
+                axis     = a;
+                position = centroidMin + (i + 1) / scale;
+            }
+        }
+    }
+    return bestCost;
+}